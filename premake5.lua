@@ -105,4 +105,48 @@ project "VulkanLibrary"
 
 	filter "configurations:Release"
 		runtime "Release"
-		optimize "On"
\ No newline at end of file
+		optimize "On"
+
+		defines
+		{
+			"ENABLE_SHADER_PACK"
+		}
+
+project "ShaderPackCompiler"
+	kind "ConsoleApp"
+	language "C++"
+	staticruntime "on"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("bin/intermediates/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"tools/ShaderPackCompiler/**.cpp",
+		"tools/ShaderPackCompiler/**.h",
+	}
+
+	VulkanLibraryIncludeDirectories(".")
+
+	links
+	{
+		"VulkanLibrary",
+	}
+
+	postbuildcommands
+	{
+		("{COPY} \"" .. VK_SDK_PATH .. "/Bin/dxcompiler.dll\" \"%{cfg.targetdir}\""),
+		("{COPY} \"" .. VK_SDK_PATH .. "/Bin/shaderc_shared.dll\" \"%{cfg.targetdir}\""),
+	}
+
+	filter "system:windows"
+		cppdialect "C++17"
+		systemversion "latest"
+
+	filter "configurations:Debug"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		runtime "Release"
+		optimize "On"
@@ -1,13 +1,22 @@
 #include "pch.h"
 #include "Application.h"
 #include "Graphics/VulkanAllocator.h"
+#include "Graphics/ShaderLibrary.h"
+#include "Graphics/PipelineLibrary.h"
+#include "Graphics/BindlessDescriptorHeap.h"
+#include "Graphics/FrameUniformAllocator.h"
+#include "Graphics/GeometryPool.h"
+#include "Graphics/UploadContext.h"
+#include "Graphics/TextureStreamer.h"
+#include "Graphics/CommandPoolRegistry.h"
+#include "Graphics/MeshSource.h"
 
 namespace VkLibrary {
 
 	Application* Application::s_Instance = nullptr;
 
-	Application::Application(const std::string name)
-		: m_Name(name)
+	Application::Application(const std::string name, const SwapchainSpecification& swapchainSpecification)
+		: m_Name(name), m_SwapchainSpecification(swapchainSpecification)
 	{
 		Init();
 	}
@@ -20,7 +29,29 @@ namespace VkLibrary {
 		}
 
 		m_ImGUIContext.reset();
+
+		// Texture jobs run on the thread pool
+		TextureStreamer::Shutdown();
+
+		TextureMemoryStats textureStats = Texture2D::GetMemoryStats();
+		LOG_INFO("Texture memory: {} textures, {} MB without mips, {} MB with mips, {} MB loaded", textureStats.TextureCount,
+			textureStats.BaseBytes >> 20, textureStats.MipBytes >> 20, textureStats.LoadedBytes >> 20);
+
+		// Workers might still hold command buffers of the registry
+		m_ThreadPool.reset();
+		CommandPoolRegistry::Shutdown();
+
 		m_Swapchain.reset();
+		PipelineLibrary::Shutdown();
+		ShaderLibrary::Shutdown();
+		UploadContext::Shutdown();
+
+		// Device is idle after Run, release everything that was waiting on in flight frames
+		m_VulkanDevice->GetDeletionQueue().Flush();
+
+		GeometryPool::Shutdown();
+		FrameUniformAllocator::Shutdown();
+		BindlessDescriptorHeap::Shutdown();
 		VulkanAllocator::Shutdown();
 		m_VulkanDevice.reset();
 		m_Window.reset();
@@ -39,8 +70,21 @@ namespace VkLibrary {
 		m_Window->SetResizeCallback([this](uint32_t width, uint32_t height) { OnWindowResize(width, height); });
 		m_Window->InitVulkanSurface();
 		m_VulkanDevice = CreateRef<VulkanDevice>();
-		m_Swapchain = CreateRef<Swapchain>();
+		m_Swapchain = CreateRef<Swapchain>(m_SwapchainSpecification);
+		m_ThreadPool = CreateScope<ThreadPool>();
+		CommandPoolRegistry::Init(m_Swapchain->GetFramesInFlight());
 		VulkanAllocator::Init(m_VulkanDevice);
+		BindlessDescriptorHeap::Init();
+		FrameUniformAllocator::Init();
+		UploadContext::Init();
+		TextureStreamer::Init();
+		GeometryPool::Init(sizeof(Vertex));
+		ShaderLibrary::Init();
+		PipelineLibrary::Init();
+
+#ifdef ENABLE_SHADER_PACK
+		ShaderLibrary::LoadPack("assets/shaders/Shaders.vlshaders");
+#endif
 
 		m_ImGUIContext = CreateRef<ImGuiLayer>();
 	}
@@ -81,8 +125,14 @@ namespace VkLibrary {
 
 	void Application::Run()
 	{
+		// Finish work queued while loading, resources released during loading are destroyed by the first frame
+		m_VulkanDevice->GetImmediateContext().WaitIdle();
+		UploadContext::WaitIdle();
+
 		while (!m_Window->IsClosed())
 		{
+			// Wait for the GPU before polling, so the frame works with the most recent input
+			m_Swapchain->WaitForNextFrame();
 			m_Window->OnUpdate();
 
 			if (!m_Window->IsMinimized())
@@ -98,6 +148,7 @@ namespace VkLibrary {
 			}
 		}
 
+		std::lock_guard<std::mutex> queueLock(m_VulkanDevice->GetQueueMutex());
 		vkDeviceWaitIdle(m_VulkanDevice->GetLogicalDevice());
 	}
 
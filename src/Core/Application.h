@@ -1,6 +1,7 @@
 #pragma once
 #include "Core.h"
 #include "Layer.h"
+#include "ThreadPool.h"
 #include "Graphics/VulkanInstance.h"
 #include "Graphics/VulkanDevice.h"
 #include "Graphics/Swapchain.h"
@@ -12,7 +13,7 @@ namespace VkLibrary {
 	class Application
 	{
 	public:
-		Application(const std::string name);
+		Application(const std::string name, const SwapchainSpecification& swapchainSpecification = {});
 		~Application();
 
 	public:
@@ -26,6 +27,7 @@ namespace VkLibrary {
 		inline static Ref<VulkanInstance> GetVulkanInstance() { return s_Instance->GetVulkanInstanceInternal(); }
 		inline static Ref<VulkanDevice> GetVulkanDevice() { return s_Instance->GetVulkanDeviceInternal();; }
 		inline static Ref<Window> GetWindow() { return s_Instance->GetWindowInternal();; }
+		inline static ThreadPool& GetThreadPool() { return *s_Instance->m_ThreadPool; }
 
 		inline static VkCommandBuffer GetActiveCommandBuffer() { return GetSwapchain()->GetCurrentCommandBuffer(); }
 		
@@ -43,6 +45,7 @@ namespace VkLibrary {
 
 	private:
 		std::string m_Name;
+		SwapchainSpecification m_SwapchainSpecification;
 		std::vector<Ref<Layer>> m_Layers;
 
 	private:
@@ -53,6 +56,7 @@ namespace VkLibrary {
 		Ref<Swapchain> m_Swapchain;
 		Ref<Window> m_Window;
 		Ref<ImGuiLayer> m_ImGUIContext;
+		Scope<ThreadPool> m_ThreadPool;
 	};
 
 }
\ No newline at end of file
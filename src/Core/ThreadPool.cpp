@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+namespace VkLibrary {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+
+		LOG_INFO("Thread pool: {} worker threads", threadCount);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Running = false;
+		}
+
+		// Workers drain the queue before they exit
+		m_Condition.notify_all();
+		for (std::thread& thread : m_Threads)
+			thread.join();
+	}
+
+	std::future<void> ThreadPool::Submit(std::function<void()>&& task)
+	{
+		std::packaged_task<void()> packagedTask(std::move(task));
+		std::future<void> future = packagedTask.get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Tasks.push(std::move(packagedTask));
+		}
+
+		m_Condition.notify_one();
+		return future;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::packaged_task<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return !m_Running || !m_Tasks.empty(); });
+
+				if (m_Tasks.empty())
+					return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+}
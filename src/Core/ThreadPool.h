@@ -0,0 +1,42 @@
+#pragma once
+#include "Core.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace VkLibrary {
+
+	// NOTE: Fixed set of worker threads, tasks run in submission order on whichever worker is free
+	// Tasks must not wait on other tasks of the same pool, a full pool would deadlock
+
+	class ThreadPool
+	{
+	public:
+		// Zero uses one thread per hardware thread, minus the main thread
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+	public:
+		std::future<void> Submit(std::function<void()>&& task);
+
+		inline uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_Threads;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		std::queue<std::packaged_task<void()>> m_Tasks;
+		bool m_Running = true;
+	};
+
+}
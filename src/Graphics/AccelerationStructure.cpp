@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "AccelerationStructure.h"
+#include "BarrierBatch.h"
 #include "Core/Application.h"
 #include <glm/gtc/type_ptr.hpp>
 
@@ -13,23 +14,25 @@ namespace VkLibrary {
 
 	AccelerationStructure::~AccelerationStructure()
 	{
-		VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
-		VulkanAllocator allocator("AccelerationStructure");
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		for (auto blAS : m_BottomLevelAccelerationStructure)
+		// Trace rays of frames in flight may still traverse the structures
+		std::vector<VulkanAccelerationStructureInfo> accelerationStructures = m_BottomLevelAccelerationStructure;
+		accelerationStructures.push_back(m_TopLevelAccelerationStructure);
+
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), accelerationStructures = std::move(accelerationStructures)]()
 		{
-			allocator.DestroyBuffer(blAS.ASBuffer, blAS.ASMemory);
-			allocator.DestroyBuffer(blAS.ScratchBuffer, blAS.ScratchMemory);
-			allocator.DestroyBuffer(blAS.InstancesBuffer, blAS.InstancesMemory);
-			allocator.DestroyBuffer(blAS.InstancesUploadBuffer, blAS.InstancesUploadMemory);
-			vkDestroyAccelerationStructureKHR(device, blAS.AccelerationStructure, nullptr);
-		}
-		
-		allocator.DestroyBuffer(m_TopLevelAccelerationStructure.ASBuffer, m_TopLevelAccelerationStructure.ASMemory);
-		allocator.DestroyBuffer(m_TopLevelAccelerationStructure.ScratchBuffer, m_TopLevelAccelerationStructure.ScratchMemory);
-		allocator.DestroyBuffer(m_TopLevelAccelerationStructure.InstancesBuffer, m_TopLevelAccelerationStructure.InstancesMemory);
-		allocator.DestroyBuffer(m_TopLevelAccelerationStructure.InstancesUploadBuffer, m_TopLevelAccelerationStructure.InstancesUploadMemory);
-		vkDestroyAccelerationStructureKHR(device, m_TopLevelAccelerationStructure.AccelerationStructure, nullptr);
+			VulkanAllocator allocator("AccelerationStructure");
+
+			for (auto& accelerationStructure : accelerationStructures)
+			{
+				allocator.DestroyBuffer(accelerationStructure.ASBuffer, accelerationStructure.ASMemory);
+				allocator.DestroyBuffer(accelerationStructure.ScratchBuffer, accelerationStructure.ScratchMemory);
+				allocator.DestroyBuffer(accelerationStructure.InstancesBuffer, accelerationStructure.InstancesMemory);
+				allocator.DestroyBuffer(accelerationStructure.InstancesUploadBuffer, accelerationStructure.InstancesUploadMemory);
+				vkDestroyAccelerationStructureKHR(device, accelerationStructure.AccelerationStructure, nullptr);
+			}
+		});
 	}
 
 	void AccelerationStructure::Init()
@@ -47,6 +50,12 @@ namespace VkLibrary {
 				CreateBottomLevelAccelerationStructure(m_Specification.Mesh, submeshes[i], info);
 			}
 
+			// One barrier for all bottom level builds instead of one per build
+			BarrierBatch barriers;
+			barriers.AddMemoryBarrier(VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+				VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+			barriers.Flush(Application::GetVulkanDevice()->GetImmediateContext().GetCommandBuffer());
+
 			CreateTopLevelAccelerationStructure();
 
 			UpdateMaterialData();
@@ -61,30 +70,62 @@ namespace VkLibrary {
 		m_MaterialData = std::vector<MaterialBuffer>();
 		m_Textures = std::vector<Ref<Texture2D>>();
 
-		// Materials
+		// Materials, texture indices stay indices into m_Textures since the hit shaders sample the pipeline's texture array
+		auto toTextureIndex = [this](int textureIndex)
+		{
+			return textureIndex == -1 ? -1 : textureIndex + (int)m_TextureIndexOffset;
+		};
+
 		m_MaterialData.reserve(m_Specification.Mesh->GetMaterialData().size()); // TODO: per mesh
 		m_Textures.reserve(m_Specification.Mesh->GetTextures().size()); // TODO: per mesh
-		for (auto& buffer : m_Specification.Mesh->GetMaterialBuffers())
+		for (const auto& buffer : m_Specification.Mesh->GetMaterialBuffers())
 		{	
-			buffer.data.AlbedoMapIndex += m_TextureIndexOffset;
-			buffer.data.MetallicRoughnessMapIndex += m_TextureIndexOffset;
-			buffer.data.NormalMapIndex += m_TextureIndexOffset;
-			m_MaterialData.emplace_back(buffer);
+			MaterialBuffer& material = m_MaterialData.emplace_back(buffer);
+			material.data.AlbedoMapIndex = toTextureIndex(buffer.data.AlbedoMapIndex);
+			material.data.MetallicRoughnessMapIndex = toTextureIndex(buffer.data.MetallicRoughnessMapIndex);
+			material.data.NormalMapIndex = toTextureIndex(buffer.data.NormalMapIndex);
 		}
 		for (const auto& texture : m_Specification.Mesh->GetTextures())
 		{
 			m_Textures.emplace_back(texture);
 		}
 
-		m_MaterialDataStorageBuffer = CreateRef<StorageBuffer>(nullptr, sizeof(MaterialBuffer) * m_MaterialData.size());
-		void* buffer = m_MaterialDataStorageBuffer->Map<void>();
-		memcpy(buffer, m_MaterialData.data(), m_MaterialDataStorageBuffer->GetSize());
-		m_MaterialDataStorageBuffer->Unmap();
+		m_MaterialDataStorageBuffers.clear();
+		m_MaterialDataStorageBuffers.resize(Application::GetSwapchain()->GetFramesInFlight());
+		for (MaterialBufferCopy& copy : m_MaterialDataStorageBuffers)
+			copy.Buffer = CreateRef<StorageBuffer>(m_MaterialData.data(), sizeof(MaterialBuffer) * m_MaterialData.size(), "MaterialDataStorageBuffer");
 
 		m_MaterialIndexOffset += m_MaterialData.size();
 		m_TextureIndexOffset += m_Textures.size();
 	}
 
+	void AccelerationStructure::UpdateMaterial(uint32_t materialIndex, const MaterialBuffer& material)
+	{
+		ASSERT(materialIndex < m_MaterialData.size(), "Material index out of range");
+
+		// Frames in flight may still read every copy, the changed entry is written to each when its frame comes around
+		m_MaterialData[materialIndex] = material;
+		for (MaterialBufferCopy& copy : m_MaterialDataStorageBuffers)
+		{
+			copy.DirtyBegin = std::min(copy.DirtyBegin, materialIndex);
+			copy.DirtyEnd = std::max(copy.DirtyEnd, materialIndex + 1);
+		}
+	}
+
+	void AccelerationStructure::FlushMaterialChanges(uint32_t frameIndex)
+	{
+		ASSERT(frameIndex < m_MaterialDataStorageBuffers.size(), "Frame index out of range");
+
+		// BeginFrame waited on the fence of this frame, the GPU is done reading its copy
+		MaterialBufferCopy& copy = m_MaterialDataStorageBuffers[frameIndex];
+		if (copy.DirtyBegin >= copy.DirtyEnd)
+			return;
+
+		copy.Buffer->SetData(&m_MaterialData[copy.DirtyBegin], copy.DirtyBegin * sizeof(MaterialBuffer), (copy.DirtyEnd - copy.DirtyBegin) * sizeof(MaterialBuffer));
+		copy.DirtyBegin = UINT32_MAX;
+		copy.DirtyEnd = 0;
+	}
+
 
 	void AccelerationStructure::CreateTopLevelAccelerationStructure()
 	{
@@ -101,10 +142,13 @@ namespace VkLibrary {
 
 			SubmeshData& submeshData = m_SubmeshData[i];
 
-			submeshData.BufferIndex = 0; // TODO: when we support multiple Meshes, this needs to be Mesh index (not submesh)
+			// Addresses of the geometry pool block the mesh was allocated from
+			submeshData.VertexBufferAddress = GeometryPool::GetVertexBufferAddress(m_Specification.Mesh->GetGeometry().Block);
+			submeshData.IndexBufferAddress = GeometryPool::GetIndexBufferAddress(m_Specification.Mesh->GetGeometry().Block);
 			submeshData.VertexOffset = submesh.VertexOffset;
 			submeshData.IndexOffset = submesh.IndexOffset;
 			submeshData.MaterialIndex = m_MaterialIndexOffset + submesh.MaterialIndex; // TODO: this is a GLOBAL INDEX for all meshes
+			submeshData.Padding = 0;
 
 			glm::mat4 rmWorldTransform = glm::transpose(m_Specification.Transform * submesh.WorldTransform); // Row-major
 
@@ -192,28 +236,21 @@ namespace VkLibrary {
 		accelerationStructureBuildRangeInfo.transformOffset = 0;
 		std::vector<VkAccelerationStructureBuildRangeInfoKHR*> accelerationBuildStructureRangeInfos = { &accelerationStructureBuildRangeInfo };
 
-		VkCommandBuffer commandBuffer = Application::GetVulkanDevice()->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+		// Recorded into the immediate batch, rendering waits on it so the build never blocks the CPU
+		VkCommandBuffer commandBuffer = Application::GetVulkanDevice()->GetImmediateContext().GetCommandBuffer();
 		vkCmdBuildAccelerationStructuresKHR(commandBuffer, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
 
-		VkMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-		barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
-		barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
-		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			0, 1, &barrier, 0, nullptr, 0, nullptr);
-
-		Application::GetVulkanDevice()->FlushCommandBuffer(commandBuffer, true);
+		BarrierBatch barriers;
+		barriers.AddMemoryBarrier(VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+			VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+		barriers.Flush(commandBuffer);
 
 		VkAccelerationStructureDeviceAddressInfoKHR acceleration_device_address_info{};
 		acceleration_device_address_info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
 		acceleration_device_address_info.accelerationStructure = m_TopLevelAccelerationStructure.AccelerationStructure;
 		m_TopLevelAccelerationStructure.DeviceAddress = vkGetAccelerationStructureDeviceAddressKHR(device, &acceleration_device_address_info);
 
-		{
-			SubmeshData* submeshData = m_SubmeshDataStorageBuffer->Map<SubmeshData>();
-			memcpy(submeshData, m_SubmeshData.data(), sizeof(SubmeshData) * m_SubmeshData.size());
-			m_SubmeshDataStorageBuffer->Unmap();
-		}
+		m_SubmeshDataStorageBuffer->SetData(m_SubmeshData.data(), 0, sizeof(SubmeshData) * m_SubmeshData.size());
 	}
 
 	void AccelerationStructure::CreateBottomLevelAccelerationStructure(Ref<Mesh> mesh, const SubMesh& submesh, VulkanAccelerationStructureInfo& outInfo)
@@ -221,18 +258,18 @@ namespace VkLibrary {
 		VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
 		VulkanAllocator allocator("AccelerationStructure");
 
-		const auto& vertexBuffer = mesh->GetVertexBuffer();
-		const auto& indexBuffer = mesh->GetIndexBuffer();
-
 		uint32_t primitiveCount = submesh.IndexCount / 3;
 
+		// Geometry pool block the mesh was allocated from
+		uint32_t block = mesh->GetGeometry().Block;
+
 		VkAccelerationStructureGeometryTrianglesDataKHR trianglesData{};
 		trianglesData.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
-		trianglesData.vertexData.deviceAddress = VulkanAllocator::GetBufferDeviceAddress(mesh->GetVertexBuffer()->GetBuffer()) + submesh.VertexOffset * sizeof(Vertex); // Modified
+		trianglesData.vertexData.deviceAddress = GeometryPool::GetVertexBufferAddress(block) + submesh.VertexOffset * sizeof(Vertex);
 		trianglesData.vertexStride = sizeof(Vertex);
 		trianglesData.maxVertex = submesh.VertexCount;
 		trianglesData.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
-		trianglesData.indexData.deviceAddress = VulkanAllocator::GetBufferDeviceAddress(mesh->GetIndexBuffer()->GetBuffer()) + submesh.IndexOffset * sizeof(uint32_t); // Modified
+		trianglesData.indexData.deviceAddress = GeometryPool::GetIndexBufferAddress(block) + submesh.IndexOffset * sizeof(uint32_t);
 		trianglesData.indexType = VK_INDEX_TYPE_UINT32;
 
 		VkAccelerationStructureGeometryDataKHR geometryData{};
@@ -286,17 +323,10 @@ namespace VkLibrary {
 		VkAccelerationStructureBuildRangeInfoKHR buildInfo = { primitiveCount, 0, 0, 0 }; // TODO: offsets here?
 		buildRangeInfos[0] = &buildInfo;
 
-		VkCommandBuffer commandBuffer = Application::GetVulkanDevice()->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+		// Recorded into the immediate batch, rendering waits on it so the build never blocks the CPU
+		// Bottom level builds are independent of each other, Init places one barrier before the top level build
+		VkCommandBuffer commandBuffer = Application::GetVulkanDevice()->GetImmediateContext().GetCommandBuffer();
 		vkCmdBuildAccelerationStructuresKHR(commandBuffer, 1, &inputs, buildRangeInfos.data());
-
-		VkMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-		barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
-		barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
-		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-			0, 1, &barrier, 0, nullptr, 0, nullptr);
-
-		Application::GetVulkanDevice()->FlushCommandBuffer(commandBuffer, true);
 	}
 
 }
\ No newline at end of file
@@ -25,12 +25,15 @@ namespace VkLibrary {
 		VmaAllocation InstancesUploadMemory = nullptr;
 	};
 
+	// Hit shaders read vertices and indices through the buffer addresses (buffer_reference), so meshes in any geometry pool block work
 	struct SubmeshData
 	{
-		uint32_t BufferIndex;
+		uint64_t VertexBufferAddress;
+		uint64_t IndexBufferAddress;
 		uint32_t VertexOffset;
 		uint32_t IndexOffset;
 		uint32_t MaterialIndex;
+		uint32_t Padding;
 	};
 
 	class AccelerationStructure
@@ -41,10 +44,19 @@ namespace VkLibrary {
 
 		void UpdateMaterialData();
 
+		// Material texture indices have to be mesh texture indices, see GetTextures
+		void UpdateMaterial(uint32_t materialIndex, const MaterialBuffer& material);
+
 		const VkAccelerationStructureKHR& GetAccelerationStructure() { return m_TopLevelAccelerationStructure.AccelerationStructure; }
 		Ref<StorageBuffer> GetSubmeshDataStorageBuffer() const { return m_SubmeshDataStorageBuffer; }
 
-		Ref<StorageBuffer> GetMaterialBuffer() const { return m_MaterialDataStorageBuffer; }
+		// Material texture indices refer to GetTextures, which is bound to the ray tracing pipeline's texture array (binding 9)
+		// Descriptors have to be written from the textures when binding, streamed textures replace their image once resident
+		// Writes pending material changes into the copy of the frame, call once per frame after the swapchain's BeginFrame
+		void FlushMaterialChanges(uint32_t frameIndex);
+
+		// Copy of the frame in flight, bind it every frame after FlushMaterialChanges
+		Ref<StorageBuffer> GetMaterialBuffer(uint32_t frameIndex) const { return m_MaterialDataStorageBuffers[frameIndex].Buffer; }
 		const std::vector<Ref<Texture2D>>& GetTextures() const { return m_Textures; }
 
 		const AccelerationStructureSpecification& GetSpecification() const { return m_Specification; }
@@ -61,7 +73,17 @@ namespace VkLibrary {
 		VulkanAccelerationStructureInfo m_TopLevelAccelerationStructure;
 		std::vector<VulkanAccelerationStructureInfo> m_BottomLevelAccelerationStructure;
 
-		Ref<StorageBuffer> m_MaterialDataStorageBuffer;
+		// One copy per frame in flight, a copy is only written once the fence of its frame was waited on
+		struct MaterialBufferCopy
+		{
+			Ref<StorageBuffer> Buffer;
+
+			// Materials changed since the copy was last written
+			uint32_t DirtyBegin = UINT32_MAX;
+			uint32_t DirtyEnd = 0;
+		};
+
+		std::vector<MaterialBufferCopy> m_MaterialDataStorageBuffers;
 		Ref<StorageBuffer> m_SubmeshDataStorageBuffer;
 		std::vector<SubmeshData> m_SubmeshData;
 		
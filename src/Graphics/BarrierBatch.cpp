@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "BarrierBatch.h"
+#include "Image.h"
+
+namespace VkLibrary {
+
+	namespace Utils {
+
+		static const VkAccessFlags2KHR s_WriteAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR |
+			VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR | VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR |
+			VK_ACCESS_2_HOST_WRITE_BIT_KHR | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+	}
+
+	void BarrierBatch::AddMemoryBarrier(VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+	{
+		VkMemoryBarrier2KHR& barrier = m_MemoryBarriers.emplace_back();
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+		barrier.srcStageMask = srcStages;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstStageMask = dstStages;
+		barrier.dstAccessMask = dstAccess;
+	}
+
+	void BarrierBatch::AddBufferBarrier(VkBuffer buffer, VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess,
+		VkDeviceSize offset, VkDeviceSize size)
+	{
+		VkBufferMemoryBarrier2KHR& barrier = m_BufferBarriers.emplace_back();
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+		barrier.srcStageMask = srcStages;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstStageMask = dstStages;
+		barrier.dstAccessMask = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+	}
+
+	void BarrierBatch::AddImageBarrier(VkImage image, const VkImageSubresourceRange& range, VkImageLayout oldLayout, VkImageLayout newLayout,
+		VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+	{
+		VkImageMemoryBarrier2KHR& barrier = m_ImageBarriers.emplace_back();
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+		barrier.srcStageMask = srcStages;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstStageMask = dstStages;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = range;
+	}
+
+	void BarrierBatch::TransitionImage(Image& image, VkImageLayout newLayout, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+	{
+		TransitionImage(image.GetState(), image.GetImage(), image.GetSubresourceRange(), newLayout, dstStages, dstAccess);
+	}
+
+	void BarrierBatch::TransitionImage(ResourceState& state, VkImage image, const VkImageSubresourceRange& range, VkImageLayout newLayout, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+	{
+		VkPipelineStageFlags2KHR srcStages;
+		VkAccessFlags2KHR srcAccess;
+		VkImageLayout oldLayout;
+		if (!Transition(state, newLayout, dstStages, dstAccess, srcStages, srcAccess, oldLayout))
+			return;
+
+		if (oldLayout != newLayout || srcAccess)
+			AddImageBarrier(image, range, oldLayout, newLayout, srcStages, srcAccess, dstStages, dstAccess);
+		else
+			AddMemoryBarrier(srcStages, VK_ACCESS_2_NONE_KHR, dstStages, VK_ACCESS_2_NONE_KHR);
+	}
+
+	void BarrierBatch::TransitionBuffer(ResourceState& state, VkBuffer buffer, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess)
+	{
+		VkPipelineStageFlags2KHR srcStages;
+		VkAccessFlags2KHR srcAccess;
+		VkImageLayout oldLayout;
+		if (!Transition(state, VK_IMAGE_LAYOUT_UNDEFINED, dstStages, dstAccess, srcStages, srcAccess, oldLayout))
+			return;
+
+		if (srcAccess)
+			AddBufferBarrier(buffer, srcStages, srcAccess, dstStages, dstAccess);
+		else
+			AddMemoryBarrier(srcStages, VK_ACCESS_2_NONE_KHR, dstStages, VK_ACCESS_2_NONE_KHR);
+	}
+
+	bool BarrierBatch::Transition(ResourceState& state, VkImageLayout newLayout, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess,
+		VkPipelineStageFlags2KHR& outSrcStages, VkAccessFlags2KHR& outSrcAccess, VkImageLayout& outOldLayout)
+	{
+		bool write = IsWriteAccess(dstAccess);
+		bool layoutChange = state.Layout != newLayout;
+
+		outOldLayout = state.Layout;
+
+		if (write || layoutChange)
+		{
+			// Waits for the last write and every read since, reads only need an execution dependency
+			outSrcStages = state.WriteStages | state.ReadStages;
+			outSrcAccess = state.WriteAccess;
+			bool needed = layoutChange || outSrcStages != VK_PIPELINE_STAGE_2_NONE_KHR;
+
+			// A layout transition counts as a write that later reads from other stages have to wait for
+			state.WriteStages = dstStages;
+			state.WriteAccess = dstAccess & Utils::s_WriteAccessMask;
+			state.ReadStages = write ? VK_PIPELINE_STAGE_2_NONE_KHR : dstStages;
+			state.VisibleStages = write ? VK_PIPELINE_STAGE_2_NONE_KHR : dstStages;
+			state.VisibleAccess = write ? VK_ACCESS_2_NONE_KHR : dstAccess;
+			state.Layout = newLayout;
+			return needed;
+		}
+
+		bool visible = (state.VisibleStages & dstStages) == dstStages && (state.VisibleAccess & dstAccess) == dstAccess;
+		bool needed = state.WriteStages != VK_PIPELINE_STAGE_2_NONE_KHR && !visible;
+
+		outSrcStages = state.WriteStages;
+		outSrcAccess = state.WriteAccess;
+
+		if (needed)
+		{
+			state.VisibleStages |= dstStages;
+			state.VisibleAccess |= dstAccess;
+		}
+
+		state.ReadStages |= dstStages;
+		return needed;
+	}
+
+	void BarrierBatch::Flush(VkCommandBuffer commandBuffer)
+	{
+		if (IsEmpty())
+			return;
+
+		VkDependencyInfoKHR dependencyInfo{};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.memoryBarrierCount = (uint32_t)m_MemoryBarriers.size();
+		dependencyInfo.pMemoryBarriers = m_MemoryBarriers.data();
+		dependencyInfo.bufferMemoryBarrierCount = (uint32_t)m_BufferBarriers.size();
+		dependencyInfo.pBufferMemoryBarriers = m_BufferBarriers.data();
+		dependencyInfo.imageMemoryBarrierCount = (uint32_t)m_ImageBarriers.size();
+		dependencyInfo.pImageMemoryBarriers = m_ImageBarriers.data();
+
+		vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+
+		m_MemoryBarriers.clear();
+		m_BufferBarriers.clear();
+		m_ImageBarriers.clear();
+	}
+
+	bool BarrierBatch::IsWriteAccess(VkAccessFlags2KHR access)
+	{
+		return access & Utils::s_WriteAccessMask;
+	}
+
+	VkAccessFlags2KHR BarrierBatch::GetWriteAccess(VkAccessFlags2KHR access)
+	{
+		return access & Utils::s_WriteAccessMask;
+	}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Core/Core.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	class Image;
+
+	// Last synchronized accesses of an image or buffer in recording order
+	struct ResourceState
+	{
+		VkPipelineStageFlags2KHR WriteStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+		VkAccessFlags2KHR WriteAccess = VK_ACCESS_2_NONE_KHR;
+		VkPipelineStageFlags2KHR ReadStages = VK_PIPELINE_STAGE_2_NONE_KHR; // Stages that read since the last write
+
+		// Stages and accesses the last write was already made visible to
+		VkPipelineStageFlags2KHR VisibleStages = VK_PIPELINE_STAGE_2_NONE_KHR;
+		VkAccessFlags2KHR VisibleAccess = VK_ACCESS_2_NONE_KHR;
+
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	// NOTE: Collects memory, buffer and image barriers and records all of them with a single vkCmdPipelineBarrier2
+	// Transition functions derive the source scope from a tracked ResourceState and drop barriers that are not needed,
+	// reads after reads in the same layout and reads the last write was already made visible to
+	// Tracked state follows recording order, it is only correct if command buffers are submitted in the order they were recorded
+
+	class BarrierBatch
+	{
+	public:
+		void AddMemoryBarrier(VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess);
+
+		void AddBufferBarrier(VkBuffer buffer, VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess,
+			VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		void AddImageBarrier(VkImage image, const VkImageSubresourceRange& range, VkImageLayout oldLayout, VkImageLayout newLayout,
+			VkPipelineStageFlags2KHR srcStages, VkAccessFlags2KHR srcAccess, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess);
+
+		// Transition to a layout and access without knowing the previous one, state is updated to the new access
+		void TransitionImage(Image& image, VkImageLayout newLayout, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess);
+		void TransitionImage(ResourceState& state, VkImage image, const VkImageSubresourceRange& range, VkImageLayout newLayout, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess);
+		void TransitionBuffer(ResourceState& state, VkBuffer buffer, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess);
+
+		void Flush(VkCommandBuffer commandBuffer);
+
+		inline bool IsEmpty() const { return m_MemoryBarriers.empty() && m_BufferBarriers.empty() && m_ImageBarriers.empty(); }
+
+	public:
+		static bool IsWriteAccess(VkAccessFlags2KHR access);
+		static VkAccessFlags2KHR GetWriteAccess(VkAccessFlags2KHR access);
+
+	private:
+		// Shared by images and buffers, returns true if a barrier is needed and fills its source scope
+		static bool Transition(ResourceState& state, VkImageLayout newLayout, VkPipelineStageFlags2KHR dstStages, VkAccessFlags2KHR dstAccess,
+			VkPipelineStageFlags2KHR& outSrcStages, VkAccessFlags2KHR& outSrcAccess, VkImageLayout& outOldLayout);
+
+	private:
+		std::vector<VkMemoryBarrier2KHR> m_MemoryBarriers;
+		std::vector<VkBufferMemoryBarrier2KHR> m_BufferBarriers;
+		std::vector<VkImageMemoryBarrier2KHR> m_ImageBarriers;
+	};
+
+}
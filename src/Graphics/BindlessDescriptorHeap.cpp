@@ -0,0 +1,276 @@
+#include "pch.h"
+#include "BindlessDescriptorHeap.h"
+#include "VulkanTools.h"
+#include "Core/Application.h"
+#include <mutex>
+
+namespace VkLibrary {
+
+	struct DescriptorIndexPool
+	{
+		std::vector<uint32_t> FreeIndices;
+		uint32_t NextIndex = 0;
+		uint32_t Capacity = 0;
+
+		uint32_t Allocate()
+		{
+			if (!FreeIndices.empty())
+			{
+				uint32_t index = FreeIndices.back();
+				FreeIndices.pop_back();
+				return index;
+			}
+
+			if (NextIndex >= Capacity)
+				return BindlessDescriptorHeap::InvalidIndex;
+
+			return NextIndex++;
+		}
+
+		void Free(uint32_t index)
+		{
+			FreeIndices.push_back(index);
+		}
+	};
+
+	struct BindlessDescriptorHeapData
+	{
+		VkDevice Device = VK_NULL_HANDLE;
+
+		VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+		VkDescriptorPool Pool = VK_NULL_HANDLE;
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+		std::mutex Mutex;
+		DescriptorIndexPool Textures;
+		DescriptorIndexPool StorageBuffers;
+	};
+
+	static BindlessDescriptorHeapData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static const uint32_t s_MaxBindlessTextures = 16384;
+		static const uint32_t s_MaxBindlessStorageBuffers = 8192;
+
+		// Per stage limits count every set of a pipeline layout, this much is left to the other sets
+		// The ray tracing layout alone declares 2048 textures and over 4096 storage buffers of its own
+		static const uint32_t s_ReservedPerStageDescriptors = 8192;
+
+		static uint32_t GetPerStageCapacity(uint32_t limit)
+		{
+			return limit > s_ReservedPerStageDescriptors ? limit - s_ReservedPerStageDescriptors : 0;
+		}
+
+		static void WriteDescriptor(uint32_t binding, uint32_t index, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo)
+		{
+			VkWriteDescriptorSet writeDescriptor{};
+			writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptor.dstSet = s_Data->DescriptorSet;
+			writeDescriptor.dstBinding = binding;
+			writeDescriptor.dstArrayElement = index;
+			writeDescriptor.descriptorCount = 1;
+			writeDescriptor.descriptorType = type;
+			writeDescriptor.pImageInfo = imageInfo;
+			writeDescriptor.pBufferInfo = bufferInfo;
+
+			vkUpdateDescriptorSets(s_Data->Device, 1, &writeDescriptor, 0, nullptr);
+		}
+
+	}
+
+	void BindlessDescriptorHeap::Init()
+	{
+		s_Data = new BindlessDescriptorHeapData();
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		s_Data->Device = device->GetLogicalDevice();
+
+		// Clamp heap size to what the device supports for update after bind sets
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2(device->GetPhysicalDevice(), &properties);
+
+		// Combined image samplers count as sampled images and as samplers, and the heap is visible to every stage
+		s_Data->Textures.Capacity = std::min({ Utils::s_MaxBindlessTextures,
+			indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+			indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+			Utils::GetPerStageCapacity(indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages),
+			Utils::GetPerStageCapacity(indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers) });
+
+		s_Data->StorageBuffers.Capacity = std::min({ Utils::s_MaxBindlessStorageBuffers,
+			indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+			Utils::GetPerStageCapacity(indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers) });
+
+		// Both arrays together count against the per stage resource limit, storage buffers give way first
+		uint32_t perStageResources = Utils::GetPerStageCapacity(indexingProperties.maxPerStageUpdateAfterBindResources);
+		s_Data->Textures.Capacity = std::min(s_Data->Textures.Capacity, perStageResources);
+		s_Data->StorageBuffers.Capacity = std::min(s_Data->StorageBuffers.Capacity, perStageResources - s_Data->Textures.Capacity);
+
+		ASSERT(s_Data->Textures.Capacity > 0 && s_Data->StorageBuffers.Capacity > 0, "Device limits leave no room for the bindless descriptor heap");
+
+		// Create layout, only the last binding can have a variable count
+		std::array<VkDescriptorSetLayoutBinding, 2> bindings = {
+			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL, TextureBinding, s_Data->Textures.Capacity),
+			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL, StorageBufferBinding, s_Data->StorageBuffers.Capacity),
+		};
+
+		const VkDescriptorBindingFlags bindlessFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		std::array<VkDescriptorBindingFlags, 2> bindingFlags = {
+			bindlessFlags,
+			bindlessFlags | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT,
+		};
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = (uint32_t)bindingFlags.size();
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = (uint32_t)bindings.size();
+		layoutInfo.pBindings = bindings.data();
+
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(s_Data->Device, &layoutInfo, nullptr, &s_Data->Layout));
+
+		// Create pool holding the single heap set
+		std::array<VkDescriptorPoolSize, 2> poolSizes = {
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, s_Data->Textures.Capacity },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, s_Data->StorageBuffers.Capacity },
+		};
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		VK_CHECK_RESULT(vkCreateDescriptorPool(s_Data->Device, &poolInfo, nullptr, &s_Data->Pool));
+
+		// Allocate set
+		VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{};
+		variableCountInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+		variableCountInfo.descriptorSetCount = 1;
+		variableCountInfo.pDescriptorCounts = &s_Data->StorageBuffers.Capacity;
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.pNext = &variableCountInfo;
+		allocateInfo.descriptorPool = s_Data->Pool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &s_Data->Layout;
+
+		VK_CHECK_RESULT(vkAllocateDescriptorSets(s_Data->Device, &allocateInfo, &s_Data->DescriptorSet));
+
+		LOG_INFO("Bindless descriptor heap: {} textures, {} storage buffers", s_Data->Textures.Capacity, s_Data->StorageBuffers.Capacity);
+	}
+
+	void BindlessDescriptorHeap::Shutdown()
+	{
+		vkDestroyDescriptorPool(s_Data->Device, s_Data->Pool, nullptr);
+		vkDestroyDescriptorSetLayout(s_Data->Device, s_Data->Layout, nullptr);
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	uint32_t BindlessDescriptorHeap::RegisterTexture(const VkDescriptorImageInfo& imageInfo)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		uint32_t index = s_Data->Textures.Allocate();
+		if (index == InvalidIndex)
+		{
+			LOG_ERROR("Bindless descriptor heap is out of texture slots ({})", s_Data->Textures.Capacity);
+			return InvalidIndex;
+		}
+
+		Utils::WriteDescriptor(TextureBinding, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &imageInfo, nullptr);
+		return index;
+	}
+
+	void BindlessDescriptorHeap::UpdateTexture(uint32_t index, const VkDescriptorImageInfo& imageInfo)
+	{
+		ASSERT(index < s_Data->Textures.Capacity, "Invalid bindless texture index");
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::WriteDescriptor(TextureBinding, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &imageInfo, nullptr);
+	}
+
+	void BindlessDescriptorHeap::ReleaseTexture(uint32_t index)
+	{
+		if (index == InvalidIndex || !s_Data)
+			return;
+
+		// Frames in flight may still index the slot, only hand it out again once they have finished
+		Application::GetVulkanDevice()->GetDeletionQueue().Push([index]()
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			s_Data->Textures.Free(index);
+		});
+	}
+
+	uint32_t BindlessDescriptorHeap::RegisterStorageBuffer(const VkDescriptorBufferInfo& bufferInfo)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		uint32_t index = s_Data->StorageBuffers.Allocate();
+		if (index == InvalidIndex)
+		{
+			LOG_ERROR("Bindless descriptor heap is out of storage buffer slots ({})", s_Data->StorageBuffers.Capacity);
+			return InvalidIndex;
+		}
+
+		Utils::WriteDescriptor(StorageBufferBinding, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &bufferInfo);
+		return index;
+	}
+
+	void BindlessDescriptorHeap::UpdateStorageBuffer(uint32_t index, const VkDescriptorBufferInfo& bufferInfo)
+	{
+		ASSERT(index < s_Data->StorageBuffers.Capacity, "Invalid bindless storage buffer index");
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::WriteDescriptor(StorageBufferBinding, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &bufferInfo);
+	}
+
+	void BindlessDescriptorHeap::ReleaseStorageBuffer(uint32_t index)
+	{
+		if (index == InvalidIndex || !s_Data)
+			return;
+
+		// Frames in flight may still index the slot, only hand it out again once they have finished
+		Application::GetVulkanDevice()->GetDeletionQueue().Push([index]()
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			s_Data->StorageBuffers.Free(index);
+		});
+	}
+
+	bool BindlessDescriptorHeap::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+	VkDescriptorSetLayout BindlessDescriptorHeap::GetDescriptorSetLayout()
+	{
+		return s_Data->Layout;
+	}
+
+	VkDescriptorSet BindlessDescriptorHeap::GetDescriptorSet()
+	{
+		return s_Data->DescriptorSet;
+	}
+
+	void BindlessDescriptorHeap::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, SetIndex, 1, &s_Data->DescriptorSet, 0, nullptr);
+	}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Core/Core.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	// NOTE: Shaders opt in by declaring the heap at BindlessDescriptorHeap::SetIndex, their pipeline layouts then use the heap layout
+	// layout(set = 4, binding = 0) uniform sampler2D u_Textures[];
+	// layout(set = 4, binding = 1) buffer StorageBuffers { ... } u_StorageBuffers[];
+	// Pipelines that do not declare it do not pay for the update after bind set. Materials still bind textures through set 3
+	// and ray tracing through binding 9, the heap is for shaders written against it
+
+	class BindlessDescriptorHeap
+	{
+	public:
+		static constexpr uint32_t SetIndex = 4;
+		static constexpr uint32_t TextureBinding = 0;
+		static constexpr uint32_t StorageBufferBinding = 1;
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		static void Init();
+		static void Shutdown();
+
+		// Indices are stable until released, released indices are reused by later registrations
+		static uint32_t RegisterTexture(const VkDescriptorImageInfo& imageInfo);
+		static void UpdateTexture(uint32_t index, const VkDescriptorImageInfo& imageInfo);
+		static void ReleaseTexture(uint32_t index);
+
+		static uint32_t RegisterStorageBuffer(const VkDescriptorBufferInfo& bufferInfo);
+		static void UpdateStorageBuffer(uint32_t index, const VkDescriptorBufferInfo& bufferInfo);
+		static void ReleaseStorageBuffer(uint32_t index);
+
+		static bool IsInitialized();
+
+		static VkDescriptorSetLayout GetDescriptorSetLayout();
+		static VkDescriptorSet GetDescriptorSet();
+
+		// Binds the heap at SetIndex, stays bound across pipelines whose layouts match up to the heap
+		static void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout);
+	};
+
+}
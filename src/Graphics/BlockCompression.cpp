@@ -0,0 +1,452 @@
+#include "pch.h"
+#include "BlockCompression.h"
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BLOCK_COMPRESSION_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define BLOCK_COMPRESSION_SSE2 0
+#endif
+
+namespace VkLibrary {
+
+	namespace Utils {
+
+		// BC4 palette index of each of the 8 evenly spaced steps from the minimum to the maximum
+		// Endpoint 0 is the maximum and endpoint 1 the minimum, indices 2 to 7 interpolate from the maximum down
+		static const uint8_t s_BC4IndexFromStep[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+
+		// Edge blocks repeat the last row and column, repeated pixels do not change the fitted endpoints
+		static void LoadBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[16][4])
+		{
+			for (uint32_t y = 0; y < 4; y++)
+			{
+				uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+				for (uint32_t x = 0; x < 4; x++)
+				{
+					uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+					memcpy(block[y * 4 + x], rgba + ((uint64_t)sourceY * width + sourceX) * 4, 4);
+				}
+			}
+		}
+
+		static void GetRange(const uint8_t values[16], uint8_t& outMin, uint8_t& outMax)
+		{
+#if BLOCK_COMPRESSION_SSE2
+			__m128i minValues = _mm_loadu_si128((const __m128i*)values);
+			__m128i maxValues = minValues;
+			// Fold the 16 values in half until the first byte holds the result
+			minValues = _mm_min_epu8(minValues, _mm_srli_si128(minValues, 8));
+			maxValues = _mm_max_epu8(maxValues, _mm_srli_si128(maxValues, 8));
+			minValues = _mm_min_epu8(minValues, _mm_srli_si128(minValues, 4));
+			maxValues = _mm_max_epu8(maxValues, _mm_srli_si128(maxValues, 4));
+			minValues = _mm_min_epu8(minValues, _mm_srli_si128(minValues, 2));
+			maxValues = _mm_max_epu8(maxValues, _mm_srli_si128(maxValues, 2));
+			minValues = _mm_min_epu8(minValues, _mm_srli_si128(minValues, 1));
+			maxValues = _mm_max_epu8(maxValues, _mm_srli_si128(maxValues, 1));
+
+			outMin = (uint8_t)(_mm_cvtsi128_si32(minValues) & 0xff);
+			outMax = (uint8_t)(_mm_cvtsi128_si32(maxValues) & 0xff);
+#else
+			outMin = 255;
+			outMax = 0;
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				outMin = std::min(outMin, values[i]);
+				outMax = std::max(outMax, values[i]);
+			}
+#endif
+		}
+
+		static void SelectIndicesBC4(const uint8_t values[16], uint8_t minValue, uint8_t maxValue, uint8_t indices[16])
+		{
+			float scale = 7.0f / (float)(maxValue - minValue);
+
+#if BLOCK_COMPRESSION_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			__m128i bytes = _mm_loadu_si128((const __m128i*)values);
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+			__m128i words[4] = { _mm_unpacklo_epi16(low, zero), _mm_unpackhi_epi16(low, zero), _mm_unpacklo_epi16(high, zero), _mm_unpackhi_epi16(high, zero) };
+
+			const __m128 minVector = _mm_set1_ps((float)minValue);
+			const __m128 scaleVector = _mm_set1_ps(scale);
+			const __m128 half = _mm_set1_ps(0.5f);
+
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				__m128 value = _mm_cvtepi32_ps(words[i]);
+				__m128i steps = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(value, minVector), scaleVector), half));
+
+				alignas(16) int32_t stepValues[4];
+				_mm_store_si128((__m128i*)stepValues, steps);
+				for (uint32_t j = 0; j < 4; j++)
+					indices[i * 4 + j] = s_BC4IndexFromStep[std::min(stepValues[j], 7)];
+			}
+#else
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				int32_t step = (int32_t)((float)(values[i] - minValue) * scale + 0.5f);
+				indices[i] = s_BC4IndexFromStep[std::min(step, 7)];
+			}
+#endif
+		}
+
+		static void EncodeBC4Block(const uint8_t values[16], uint8_t* output)
+		{
+			uint8_t minValue, maxValue;
+			GetRange(values, minValue, maxValue);
+
+			// Maximum first selects the mode with 6 interpolated values
+			output[0] = maxValue;
+			output[1] = minValue;
+
+			uint64_t indexBits = 0;
+			if (minValue != maxValue)
+			{
+				uint8_t indices[16];
+				SelectIndicesBC4(values, minValue, maxValue, indices);
+
+				for (uint32_t i = 0; i < 16; i++)
+					indexBits |= (uint64_t)indices[i] << (3 * i);
+			}
+
+			// 48 bits of 3 bit indices, little endian
+			for (uint32_t i = 0; i < 6; i++)
+				output[2 + i] = (uint8_t)(indexBits >> (8 * i));
+		}
+
+		static uint16_t PackRGB565(const float color[3])
+		{
+			uint32_t r = (uint32_t)std::clamp(color[0] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f);
+			uint32_t g = (uint32_t)std::clamp(color[1] * (63.0f / 255.0f) + 0.5f, 0.0f, 63.0f);
+			uint32_t b = (uint32_t)std::clamp(color[2] * (31.0f / 255.0f) + 0.5f, 0.0f, 31.0f);
+			return (uint16_t)((r << 11) | (g << 5) | b);
+		}
+
+		static void UnpackRGB565(uint16_t color, float output[3])
+		{
+			uint32_t r = (color >> 11) & 31;
+			uint32_t g = (color >> 5) & 63;
+			uint32_t b = color & 31;
+			output[0] = (float)((r << 3) | (r >> 2));
+			output[1] = (float)((g << 2) | (g >> 4));
+			output[2] = (float)((b << 3) | (b >> 2));
+		}
+
+		// Pixels are stored per channel so four of them fit in one register
+		static void SelectIndicesBC1(const float pixels[3][16], const float palette[4][3], uint8_t indices[16])
+		{
+#if BLOCK_COMPRESSION_SSE2
+			for (uint32_t i = 0; i < 16; i += 4)
+			{
+				__m128 r = _mm_loadu_ps(&pixels[0][i]);
+				__m128 g = _mm_loadu_ps(&pixels[1][i]);
+				__m128 b = _mm_loadu_ps(&pixels[2][i]);
+
+				__m128 bestDistance = _mm_set1_ps(FLT_MAX);
+				__m128i bestIndex = _mm_setzero_si128();
+				for (int32_t p = 0; p < 4; p++)
+				{
+					__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p][0]));
+					__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p][1]));
+					__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p][2]));
+					__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+					__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, bestDistance));
+					bestDistance = _mm_min_ps(distance, bestDistance);
+					bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+				}
+
+				alignas(16) int32_t bestIndices[4];
+				_mm_store_si128((__m128i*)bestIndices, bestIndex);
+				for (uint32_t j = 0; j < 4; j++)
+					indices[i + j] = (uint8_t)bestIndices[j];
+			}
+#else
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				float bestDistance = FLT_MAX;
+				for (uint8_t p = 0; p < 4; p++)
+				{
+					float dr = pixels[0][i] - palette[p][0];
+					float dg = pixels[1][i] - palette[p][1];
+					float db = pixels[2][i] - palette[p][2];
+					float distance = dr * dr + dg * dg + db * db;
+
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						indices[i] = p;
+					}
+				}
+			}
+#endif
+		}
+
+		static void EncodeBC1Block(const uint8_t block[16][4], uint8_t* output)
+		{
+			float pixels[3][16];
+			float mean[3] = { 0.0f, 0.0f, 0.0f };
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					pixels[c][i] = (float)block[i][c];
+					mean[c] += pixels[c][i] / 16.0f;
+				}
+			}
+
+			// Endpoints lie on the principal axis of the colors, found by power iteration on their covariance
+			float covariance[3][3] = {};
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				float d[3] = { pixels[0][i] - mean[0], pixels[1][i] - mean[1], pixels[2][i] - mean[2] };
+				for (uint32_t row = 0; row < 3; row++)
+				{
+					for (uint32_t column = 0; column < 3; column++)
+						covariance[row][column] += d[row] * d[column];
+				}
+			}
+
+			uint32_t largest = 0;
+			for (uint32_t c = 1; c < 3; c++)
+			{
+				if (covariance[c][c] > covariance[largest][largest])
+					largest = c;
+			}
+
+			float axis[3] = { covariance[largest][0], covariance[largest][1], covariance[largest][2] };
+			for (uint32_t iteration = 0; iteration < 8; iteration++)
+			{
+				float next[3];
+				for (uint32_t row = 0; row < 3; row++)
+					next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+
+				float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+				if (length < 1e-6f)
+					break;
+
+				for (uint32_t c = 0; c < 3; c++)
+					axis[c] = next[c] / length;
+			}
+
+			float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+			uint16_t color0, color1;
+			if (axisLength < 1e-6f)
+			{
+				// Solid block
+				color0 = color1 = PackRGB565(mean);
+			}
+			else
+			{
+				for (uint32_t c = 0; c < 3; c++)
+					axis[c] /= axisLength;
+
+				float minProjection = FLT_MAX, maxProjection = -FLT_MAX;
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					float projection = (pixels[0][i] - mean[0]) * axis[0] + (pixels[1][i] - mean[1]) * axis[1] + (pixels[2][i] - mean[2]) * axis[2];
+					minProjection = std::min(minProjection, projection);
+					maxProjection = std::max(maxProjection, projection);
+				}
+
+				float endpoint0[3], endpoint1[3];
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					endpoint0[c] = mean[c] + axis[c] * maxProjection;
+					endpoint1[c] = mean[c] + axis[c] * minProjection;
+				}
+
+				color0 = PackRGB565(endpoint0);
+				color1 = PackRGB565(endpoint1);
+			}
+
+			// Larger endpoint first selects the opaque mode with 2 interpolated colors
+			if (color0 < color1)
+				std::swap(color0, color1);
+
+			uint32_t indexBits = 0;
+			if (color0 != color1)
+			{
+				float palette[4][3];
+				UnpackRGB565(color0, palette[0]);
+				UnpackRGB565(color1, palette[1]);
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+					palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+				}
+
+				uint8_t indices[16];
+				SelectIndicesBC1(pixels, palette, indices);
+
+				for (uint32_t i = 0; i < 16; i++)
+					indexBits |= (uint32_t)indices[i] << (2 * i);
+			}
+
+			output[0] = (uint8_t)color0;
+			output[1] = (uint8_t)(color0 >> 8);
+			output[2] = (uint8_t)color1;
+			output[3] = (uint8_t)(color1 >> 8);
+			for (uint32_t i = 0; i < 4; i++)
+				output[4 + i] = (uint8_t)(indexBits >> (8 * i));
+		}
+
+		static float SRGBToLinear(uint8_t value)
+		{
+			static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> result;
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					float v = (float)i / 255.0f;
+					result[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+				}
+				return result;
+			}();
+
+			return table[value];
+		}
+
+		static uint8_t LinearToSRGB(float value)
+		{
+			value = std::clamp(value, 0.0f, 1.0f);
+			float v = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+			return (uint8_t)(v * 255.0f + 0.5f);
+		}
+
+	}
+
+	void BlockCompression::CompressBC1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* output)
+	{
+		uint32_t blocksX = (width + 3) / 4;
+		uint32_t blocksY = (height + 3) / 4;
+
+		uint8_t block[16][4];
+		for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				Utils::LoadBlock(rgba, width, height, blockX, blockY, block);
+				Utils::EncodeBC1Block(block, output + ((uint64_t)blockY * blocksX + blockX) * 8);
+			}
+		}
+	}
+
+	void BlockCompression::CompressBC4(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t channel, uint8_t* output)
+	{
+		uint32_t blocksX = (width + 3) / 4;
+		uint32_t blocksY = (height + 3) / 4;
+
+		uint8_t block[16][4];
+		uint8_t values[16];
+		for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				Utils::LoadBlock(rgba, width, height, blockX, blockY, block);
+				for (uint32_t i = 0; i < 16; i++)
+					values[i] = block[i][channel];
+
+				Utils::EncodeBC4Block(values, output + ((uint64_t)blockY * blocksX + blockX) * 8);
+			}
+		}
+	}
+
+	void BlockCompression::CompressBC5(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t channelX, uint32_t channelY, uint8_t* output)
+	{
+		uint32_t blocksX = (width + 3) / 4;
+		uint32_t blocksY = (height + 3) / 4;
+
+		uint8_t block[16][4];
+		uint8_t valuesX[16], valuesY[16];
+		for (uint32_t blockY = 0; blockY < blocksY; blockY++)
+		{
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+			{
+				Utils::LoadBlock(rgba, width, height, blockX, blockY, block);
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					valuesX[i] = block[i][channelX];
+					valuesY[i] = block[i][channelY];
+				}
+
+				// Red block followed by green block
+				uint8_t* blockOutput = output + ((uint64_t)blockY * blocksX + blockX) * 16;
+				Utils::EncodeBC4Block(valuesX, blockOutput);
+				Utils::EncodeBC4Block(valuesY, blockOutput + 8);
+			}
+		}
+	}
+
+	void BlockCompression::Downsample(const uint8_t* rgba, uint32_t width, uint32_t height, DownsampleMode mode, uint8_t* output)
+	{
+		uint32_t outputWidth = std::max(width / 2, 1u);
+		uint32_t outputHeight = std::max(height / 2, 1u);
+
+		for (uint32_t y = 0; y < outputHeight; y++)
+		{
+			// Odd sizes and 1 pixel wide levels sample the last row or column twice
+			uint32_t sourceRows[2] = { std::min(y * 2, height - 1), std::min(y * 2 + 1, height - 1) };
+
+			for (uint32_t x = 0; x < outputWidth; x++)
+			{
+				uint32_t sourceColumns[2] = { std::min(x * 2, width - 1), std::min(x * 2 + 1, width - 1) };
+
+				float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (uint32_t row : sourceRows)
+				{
+					for (uint32_t column : sourceColumns)
+					{
+						const uint8_t* pixel = rgba + ((uint64_t)row * width + column) * 4;
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							if (mode == DownsampleMode::SRGB)
+								sum[c] += Utils::SRGBToLinear(pixel[c]);
+							else if (mode == DownsampleMode::Normal)
+								sum[c] += (float)pixel[c] / 255.0f * 2.0f - 1.0f;
+							else
+								sum[c] += (float)pixel[c];
+						}
+
+						sum[3] += (float)pixel[3];
+					}
+				}
+
+				uint8_t* outputPixel = output + ((uint64_t)y * outputWidth + x) * 4;
+				if (mode == DownsampleMode::SRGB)
+				{
+					for (uint32_t c = 0; c < 3; c++)
+						outputPixel[c] = Utils::LinearToSRGB(sum[c] / 4.0f);
+				}
+				else if (mode == DownsampleMode::Normal)
+				{
+					float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+					float normal[3] = { 0.0f, 0.0f, 1.0f };
+					if (length > 1e-6f)
+					{
+						for (uint32_t c = 0; c < 3; c++)
+							normal[c] = sum[c] / length;
+					}
+
+					for (uint32_t c = 0; c < 3; c++)
+						outputPixel[c] = (uint8_t)std::clamp((normal[c] * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f, 255.0f);
+				}
+				else
+				{
+					for (uint32_t c = 0; c < 3; c++)
+						outputPixel[c] = (uint8_t)(sum[c] / 4.0f + 0.5f);
+				}
+
+				outputPixel[3] = (uint8_t)(sum[3] / 4.0f + 0.5f);
+			}
+		}
+	}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+namespace VkLibrary {
+
+	enum class DownsampleMode
+	{
+		Linear, SRGB, Normal
+	};
+
+	// NOTE: Block encoders for 4x4 compressed formats, no external libraries involved
+	// Sources are tightly packed RGBA8 images, edge blocks of images that are not a multiple of 4 repeat the last row and column
+	// Endpoints are fitted to the block's range (BC4, BC5) or principal axis (BC1), indices are picked with SSE2 when available
+	// Output receives ((width + 3) / 4) * ((height + 3) / 4) blocks, 8 bytes each for BC1 and BC4, 16 bytes for BC5
+
+	class BlockCompression
+	{
+	public:
+		// Opaque RGB, alpha is ignored
+		static void CompressBC1(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* output);
+
+		// One channel, 0 to 3 for red to alpha
+		static void CompressBC4(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t channel, uint8_t* output);
+
+		// Two channels, stored as red and green
+		static void CompressBC5(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t channelX, uint32_t channelY, uint8_t* output);
+
+		// 2x2 box filter into a max(width / 2, 1) by max(height / 2, 1) image
+		// SRGB filters color in linear space, Normal decodes the vectors and renormalizes the average
+		static void Downsample(const uint8_t* rgba, uint32_t width, uint32_t height, DownsampleMode mode, uint8_t* output);
+	};
+
+}
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "CommandPoolRegistry.h"
+#include "VulkanTools.h"
+#include "Core/Application.h"
+#include <mutex>
+#include <thread>
+
+namespace VkLibrary {
+
+	struct ThreadCommandPool
+	{
+		VkCommandPool Pool = VK_NULL_HANDLE;
+
+		// Allocated once and handed out again after every reset
+		std::vector<VkCommandBuffer> CommandBuffers[2];
+		uint32_t UsedCount[2] = {};
+	};
+
+	struct ThreadCommandPools
+	{
+		std::vector<ThreadCommandPool> Frames;
+	};
+
+	struct CommandPoolRegistryData
+	{
+		VkDevice Device = VK_NULL_HANDLE;
+		uint32_t QueueFamily = 0;
+		uint32_t FramesInFlight = 0;
+		uint32_t FrameIndex = 0;
+
+		std::mutex Mutex;
+		std::unordered_map<std::thread::id, Scope<ThreadCommandPools>> Threads;
+	};
+
+	static CommandPoolRegistryData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static ThreadCommandPools& GetThreadPools()
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+			Scope<ThreadCommandPools>& pools = s_Data->Threads[std::this_thread::get_id()];
+			if (pools)
+				return *pools;
+
+			pools = CreateScope<ThreadCommandPools>();
+			pools->Frames.resize(s_Data->FramesInFlight);
+
+			for (ThreadCommandPool& frame : pools->Frames)
+			{
+				VkCommandPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+				poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+				poolInfo.queueFamilyIndex = s_Data->QueueFamily;
+				VK_CHECK_RESULT(vkCreateCommandPool(s_Data->Device, &poolInfo, nullptr, &frame.Pool));
+			}
+
+			return *pools;
+		}
+
+	}
+
+	void CommandPoolRegistry::Init(uint32_t framesInFlight)
+	{
+		s_Data = new CommandPoolRegistryData();
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		s_Data->Device = device->GetLogicalDevice();
+		s_Data->QueueFamily = device->GetQueueFamilyIndices().Graphics;
+		s_Data->FramesInFlight = framesInFlight;
+	}
+
+	void CommandPoolRegistry::Shutdown()
+	{
+		for (auto& [threadId, pools] : s_Data->Threads)
+		{
+			for (ThreadCommandPool& frame : pools->Frames)
+				vkDestroyCommandPool(s_Data->Device, frame.Pool, nullptr);
+		}
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void CommandPoolRegistry::BeginFrame(uint32_t frameIndex)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		s_Data->FrameIndex = frameIndex;
+
+		for (auto& [threadId, pools] : s_Data->Threads)
+		{
+			ThreadCommandPool& frame = pools->Frames[frameIndex];
+			VK_CHECK_RESULT(vkResetCommandPool(s_Data->Device, frame.Pool, 0));
+
+			frame.UsedCount[0] = 0;
+			frame.UsedCount[1] = 0;
+		}
+	}
+
+	VkCommandBuffer CommandPoolRegistry::AllocateCommandBuffer(VkCommandBufferLevel level)
+	{
+		ThreadCommandPool& frame = Utils::GetThreadPools().Frames[s_Data->FrameIndex];
+
+		// Only the owning thread touches its pool between resets
+		uint32_t levelIndex = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? 0 : 1;
+		std::vector<VkCommandBuffer>& commandBuffers = frame.CommandBuffers[levelIndex];
+		uint32_t& usedCount = frame.UsedCount[levelIndex];
+
+		if (usedCount == commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = frame.Pool;
+			allocInfo.level = level;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(s_Data->Device, &allocInfo, &commandBuffer));
+			commandBuffers.push_back(commandBuffer);
+		}
+
+		return commandBuffers[usedCount++];
+	}
+
+	bool CommandPoolRegistry::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+	uint32_t CommandPoolRegistry::GetThreadCount()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		return (uint32_t)s_Data->Threads.size();
+	}
+
+}
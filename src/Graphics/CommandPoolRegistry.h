@@ -0,0 +1,26 @@
+#pragma once
+#include "Core/Core.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	// NOTE: Every thread that records gets its own graphics command pool per frame in flight, so recording never contends on a pool
+	// Pools of a frame are reset together in BeginFrame once its fence was waited on, command buffers are reused afterwards
+	// Command buffers are only valid for the frame they were allocated in and must be recorded on the allocating thread
+
+	class CommandPoolRegistry
+	{
+	public:
+		static void Init(uint32_t framesInFlight);
+		static void Shutdown();
+
+		// Workers must be idle, the pools of frameIndex are reset here
+		static void BeginFrame(uint32_t frameIndex);
+
+		static VkCommandBuffer AllocateCommandBuffer(VkCommandBufferLevel level);
+
+		static bool IsInitialized();
+		static uint32_t GetThreadCount();
+	};
+
+}
@@ -13,11 +13,15 @@ namespace VkLibrary {
 
     ComputePipeline::~ComputePipeline()
     {
-        VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
+        Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-        vkDestroyPipeline(device, m_Pipeline, nullptr);
-        if (m_OwnLayout)
-            vkDestroyPipelineLayout(device, m_Specification.PipelineLayout, nullptr);
+        VkPipelineLayout pipelineLayout = m_OwnLayout ? m_Specification.PipelineLayout : VK_NULL_HANDLE;
+        device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), pipeline = m_Pipeline, pipelineLayout]()
+        {
+            vkDestroyPipeline(device, pipeline, nullptr);
+            if (pipelineLayout)
+                vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        });
     }
 
     void ComputePipeline::Init()
@@ -55,12 +59,15 @@ namespace VkLibrary {
 
 		ASSERT(m_Specification.Shader->GetShaderCreateInfo().size() == 1, "Compute pipeline must only have one stage");
 
+		SpecializationData specializationData;
+
 		// Create compute pipeline
 		VkComputePipelineCreateInfo computePipelineCreateInfo{};
 		computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
 		computePipelineCreateInfo.layout = m_Specification.PipelineLayout;
 		computePipelineCreateInfo.stage = m_Specification.Shader->GetShaderCreateInfo()[0];
-		VK_CHECK_RESULT(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr, &m_Pipeline));
+		computePipelineCreateInfo.stage.pSpecializationInfo = m_Specification.SpecializationConstants.GetSpecializationInfo(*m_Specification.Shader, specializationData);
+		VK_CHECK_RESULT(vkCreateComputePipelines(device, Application::GetVulkanDevice()->GetPipelineCache(), 1, &computePipelineCreateInfo, nullptr, &m_Pipeline));
     }
 
 }
\ No newline at end of file
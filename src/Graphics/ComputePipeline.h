@@ -1,6 +1,7 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include "Shader.h"
+#include "SpecializationConstants.h"
 
 namespace VkLibrary {
 
@@ -8,6 +9,7 @@ namespace VkLibrary {
 	{
 		Ref<Shader> Shader;
 		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+		SpecializationConstants SpecializationConstants;
 	};
 
 	class ComputePipeline
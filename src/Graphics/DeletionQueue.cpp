@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "DeletionQueue.h"
+
+namespace VkLibrary {
+
+	DeletionQueue::~DeletionQueue()
+	{
+		if (!m_Entries.empty())
+			LOG_WARN("Deletion queue destroyed with {} pending deleters", m_Entries.size());
+	}
+
+	void DeletionQueue::Push(std::function<void()>&& deleter)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Entries.push_back({ m_CurrentFrame, std::move(deleter) });
+	}
+
+	void DeletionQueue::BeginFrame(uint32_t framesInFlight)
+	{
+		std::vector<std::function<void()>> expired;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_CurrentFrame++;
+
+			// Entries are pushed in frame order, so only the front can be expired
+			while (!m_Entries.empty() && m_Entries.front().Frame + framesInFlight <= m_CurrentFrame)
+			{
+				expired.push_back(std::move(m_Entries.front().Deleter));
+				m_Entries.pop_front();
+			}
+		}
+
+		// Run outside the lock, deleters may release other resources
+		for (auto& deleter : expired)
+			deleter();
+	}
+
+	void DeletionQueue::Flush()
+	{
+		while (true)
+		{
+			std::deque<Entry> entries;
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				entries.swap(m_Entries);
+			}
+
+			if (entries.empty())
+				break;
+
+			for (auto& entry : entries)
+				entry.Deleter();
+		}
+	}
+
+	size_t DeletionQueue::GetSize()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Entries.size();
+	}
+
+}
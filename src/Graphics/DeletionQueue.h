@@ -0,0 +1,46 @@
+#pragma once
+#include "pch.h"
+#include <functional>
+#include <deque>
+#include <mutex>
+
+namespace VkLibrary {
+
+	// NOTE: Resources still referenced by in flight command buffers are destroyed once the frame they were released in has finished
+	// Deleters capture handles by value, the owning object is usually gone by the time they run
+
+	class DeletionQueue
+	{
+	public:
+		DeletionQueue() = default;
+		~DeletionQueue();
+
+		DeletionQueue(const DeletionQueue&) = delete;
+		DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+	public:
+		void Push(std::function<void()>&& deleter);
+
+		// Starts a new frame and runs every deleter released at least framesInFlight frames ago
+		// Must be called after the fence of the oldest frame in flight was waited on
+		void BeginFrame(uint32_t framesInFlight);
+
+		// Runs every deleter, the device has to be idle
+		void Flush();
+
+		inline uint64_t GetCurrentFrame() const { return m_CurrentFrame; }
+		size_t GetSize();
+
+	private:
+		struct Entry
+		{
+			uint64_t Frame = 0;
+			std::function<void()> Deleter;
+		};
+
+		std::mutex m_Mutex;
+		std::deque<Entry> m_Entries;
+		uint64_t m_CurrentFrame = 0;
+	};
+
+}
@@ -0,0 +1,246 @@
+#include "pch.h"
+#include "DescriptorAllocator.h"
+#include "DescriptorSetLayoutCache.h"
+#include "VulkanTools.h"
+
+namespace VkLibrary {
+
+	namespace Utils {
+
+		// Descriptors of each type reserved per set
+		static const std::vector<std::pair<VkDescriptorType, float>> s_PoolSizeRatios =
+		{
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+			{ VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 0.5f },
+		};
+
+		// Pools of layouts with large arrays hold fewer sets so one pool stays within this many descriptors of a type
+		static const uint32_t s_MaxDescriptorsPerType = 16384;
+
+		// A layout fits the general class when a fresh pool reserves enough of every type for each of its sets
+		static bool FitsPoolSizeRatios(const std::vector<VkDescriptorPoolSize>& counts)
+		{
+			for (const VkDescriptorPoolSize& count : counts)
+			{
+				auto it = std::find_if(s_PoolSizeRatios.begin(), s_PoolSizeRatios.end(), [&count](auto& ratio) { return ratio.first == count.type; });
+				if (it == s_PoolSizeRatios.end() || it->second < (float)count.descriptorCount)
+					return false;
+			}
+
+			return true;
+		}
+
+		static uint32_t RoundUpToPowerOfTwo(uint32_t value)
+		{
+			uint32_t result = 1;
+			while (result < value)
+				result *= 2;
+
+			return result;
+		}
+
+	}
+
+	DescriptorAllocator::DescriptorAllocator(VkDevice device, const DescriptorAllocatorSpecification& specification)
+		:	m_Device(device), m_Specification(specification)
+	{
+		// General class
+		m_SizeClasses.emplace_back();
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		for (DescriptorPool& pool : m_Pools)
+		{
+			vkDestroyDescriptorPool(m_Device, pool.Pool, nullptr);
+		}
+	}
+
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+		uint32_t sizeClass = GetSizeClass(layout);
+		uint32_t currentPool = m_SizeClasses[sizeClass].CurrentPool;
+
+		// Try the current pool of the class first, then pools that may have space left after sets were freed or the allocator was reset
+		bool allocated = currentPool != UINT32_MAX && !m_Pools[currentPool].Full && TryAllocate(currentPool, layout, descriptorSet);
+		for (uint32_t i = 0; i < m_Pools.size() && !allocated; i++)
+		{
+			if (i == currentPool || m_Pools[i].SizeClass != sizeClass || m_Pools[i].Full)
+				continue;
+
+			if (TryAllocate(i, layout, descriptorSet))
+			{
+				currentPool = i;
+				allocated = true;
+			}
+		}
+
+		// Every pool of the class is full so grow
+		if (!allocated)
+		{
+			currentPool = CreatePool(sizeClass);
+			allocated = TryAllocate(currentPool, layout, descriptorSet);
+			ASSERT(allocated, "Could not allocate descriptor set from a new pool");
+		}
+
+		m_SizeClasses[sizeClass].CurrentPool = currentPool;
+
+		if (m_Specification.FreeIndividualSets)
+			m_SetPools[descriptorSet] = currentPool;
+
+		return descriptorSet;
+	}
+
+	void DescriptorAllocator::Free(VkDescriptorSet descriptorSet)
+	{
+		ASSERT(m_Specification.FreeIndividualSets, "Sets from transient allocators can not be freed individually");
+
+		if (descriptorSet == VK_NULL_HANDLE)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_SetPools.find(descriptorSet);
+		if (it == m_SetPools.end())
+		{
+			LOG_WARN("Descriptor set was not allocated by this allocator");
+			return;
+		}
+
+		DescriptorPool& pool = m_Pools[it->second];
+		VK_CHECK_RESULT(vkFreeDescriptorSets(m_Device, pool.Pool, 1, &descriptorSet));
+		pool.AllocatedSets--;
+		pool.Full = false;
+
+		m_SetPools.erase(it);
+	}
+
+	void DescriptorAllocator::Reset()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (DescriptorPool& pool : m_Pools)
+		{
+			VK_CHECK_RESULT(vkResetDescriptorPool(m_Device, pool.Pool, 0));
+			pool.AllocatedSets = 0;
+			pool.Full = false;
+		}
+
+		m_SetPools.clear();
+	}
+
+	uint32_t DescriptorAllocator::GetSizeClass(VkDescriptorSetLayout layout)
+	{
+		auto it = m_LayoutSizeClasses.find(layout);
+		if (it != m_LayoutSizeClasses.end())
+			return it->second;
+
+		uint32_t sizeClass = 0;
+
+		std::vector<VkDescriptorPoolSize> counts;
+		if (m_Specification.LayoutCache && m_Specification.LayoutCache->GetDescriptorCounts(layout, counts) && !Utils::FitsPoolSizeRatios(counts))
+		{
+			// Rounded so layouts with similar arrays share pools
+			for (VkDescriptorPoolSize& count : counts)
+				count.descriptorCount = Utils::RoundUpToPowerOfTwo(count.descriptorCount);
+
+			auto sameCounts = [&counts](const SizeClass& other)
+			{
+				return std::equal(counts.begin(), counts.end(), other.SetCounts.begin(), other.SetCounts.end(),
+					[](const VkDescriptorPoolSize& a, const VkDescriptorPoolSize& b) { return a.type == b.type && a.descriptorCount == b.descriptorCount; });
+			};
+
+			auto classIt = std::find_if(m_SizeClasses.begin() + 1, m_SizeClasses.end(), sameCounts);
+			sizeClass = (uint32_t)(classIt - m_SizeClasses.begin());
+
+			if (classIt == m_SizeClasses.end())
+				m_SizeClasses.push_back({ counts });
+		}
+
+		m_LayoutSizeClasses[layout] = sizeClass;
+		return sizeClass;
+	}
+
+	bool DescriptorAllocator::TryAllocate(uint32_t poolIndex, VkDescriptorSetLayout layout, VkDescriptorSet& outDescriptorSet)
+	{
+		DescriptorPool& pool = m_Pools[poolIndex];
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = pool.Pool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &layout;
+
+		VkResult result = vkAllocateDescriptorSets(m_Device, &allocateInfo, &outDescriptorSet);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			pool.Full = true;
+			return false;
+		}
+
+		VK_CHECK_RESULT(result);
+		pool.AllocatedSets++;
+
+		return true;
+	}
+
+	uint32_t DescriptorAllocator::CreatePool(uint32_t sizeClass)
+	{
+		// Doubles the last pool of the same class
+		uint32_t maxSets = m_Specification.InitialSetsPerPool;
+		for (const DescriptorPool& pool : m_Pools)
+		{
+			if (pool.SizeClass == sizeClass)
+				maxSets = std::min(pool.MaxSets * 2, m_Specification.MaxSetsPerPool);
+		}
+
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		const std::vector<VkDescriptorPoolSize>& setCounts = m_SizeClasses[sizeClass].SetCounts;
+
+		if (setCounts.empty())
+		{
+			poolSizes.reserve(Utils::s_PoolSizeRatios.size());
+			for (auto& [type, ratio] : Utils::s_PoolSizeRatios)
+			{
+				poolSizes.push_back({ type, std::max(1u, (uint32_t)(ratio * maxSets)) });
+			}
+		}
+		else
+		{
+			uint32_t largestCount = 1;
+			for (const VkDescriptorPoolSize& count : setCounts)
+				largestCount = std::max(largestCount, count.descriptorCount);
+
+			maxSets = std::max(1u, std::min(maxSets, Utils::s_MaxDescriptorsPerType / largestCount));
+
+			poolSizes.reserve(setCounts.size());
+			for (const VkDescriptorPoolSize& count : setCounts)
+			{
+				poolSizes.push_back({ count.type, count.descriptorCount * maxSets });
+			}
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = m_Specification.FreeIndividualSets ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+		poolInfo.maxSets = maxSets;
+		poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		DescriptorPool& pool = m_Pools.emplace_back();
+		pool.MaxSets = maxSets;
+		pool.SizeClass = sizeClass;
+		VK_CHECK_RESULT(vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &pool.Pool));
+
+		return (uint32_t)m_Pools.size() - 1;
+	}
+
+}
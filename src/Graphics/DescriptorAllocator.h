@@ -0,0 +1,79 @@
+#pragma once
+#include "pch.h"
+#include <vulkan/vulkan.h>
+#include <mutex>
+
+namespace VkLibrary {
+
+	class DescriptorSetLayoutCache;
+
+	struct DescriptorAllocatorSpecification
+	{
+		// Sets in the first pool, every new pool doubles up to MaxSetsPerPool
+		uint32_t InitialSetsPerPool = 128;
+		uint32_t MaxSetsPerPool = 4096;
+
+		// Persistent allocators create pools with the free bit so sets can be returned individually
+		bool FreeIndividualSets = true;
+
+		// Looks up what a layout needs, layouts it does not know always use the general size class
+		DescriptorSetLayoutCache* LayoutCache = nullptr;
+	};
+
+	// NOTE: Pools belong to size classes and sets are only allocated from pools of their layout's class
+	// The general class sizes pools with fixed descriptor type ratios per set, layouts that need more of a type than
+	// those ratios (large arrays, types outside the table) get a class sized from their own counts rounded up to powers of two
+	// Pools are only destroyed with the allocator, transient allocators are reset wholesale with Reset, which keeps the pools for reuse
+
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(VkDevice device, const DescriptorAllocatorSpecification& specification = DescriptorAllocatorSpecification());
+		~DescriptorAllocator();
+
+	public:
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+		void Free(VkDescriptorSet descriptorSet);
+
+		void Reset();
+
+		inline uint32_t GetPoolCount() const { return (uint32_t)m_Pools.size(); }
+		inline uint32_t GetSizeClassCount() const { return (uint32_t)m_SizeClasses.size(); }
+
+	private:
+		struct DescriptorPool
+		{
+			VkDescriptorPool Pool = VK_NULL_HANDLE;
+			uint32_t MaxSets = 0;
+			uint32_t AllocatedSets = 0;
+			uint32_t SizeClass = 0;
+
+			// Set when an allocation failed, cleared once sets are returned to the pool
+			bool Full = false;
+		};
+
+		struct SizeClass
+		{
+			// Descriptors reserved per set, empty for the general class which uses the ratio table
+			std::vector<VkDescriptorPoolSize> SetCounts;
+			uint32_t CurrentPool = UINT32_MAX;
+		};
+
+		uint32_t GetSizeClass(VkDescriptorSetLayout layout);
+		bool TryAllocate(uint32_t poolIndex, VkDescriptorSetLayout layout, VkDescriptorSet& outDescriptorSet);
+		uint32_t CreatePool(uint32_t sizeClass);
+
+	private:
+		VkDevice m_Device = VK_NULL_HANDLE;
+		DescriptorAllocatorSpecification m_Specification;
+
+		std::mutex m_Mutex;
+		std::vector<DescriptorPool> m_Pools;
+		std::vector<SizeClass> m_SizeClasses;
+		std::unordered_map<VkDescriptorSetLayout, uint32_t> m_LayoutSizeClasses;
+
+		// Pool each set was allocated from, only tracked when sets can be freed
+		std::unordered_map<VkDescriptorSet, uint32_t> m_SetPools;
+	};
+
+}
@@ -0,0 +1,173 @@
+#include "pch.h"
+#include "DescriptorSetLayoutCache.h"
+#include "VulkanTools.h"
+
+namespace VkLibrary {
+
+	DescriptorSetLayoutCache::DescriptorSetLayoutCache(VkDevice device)
+		:	m_Device(device)
+	{
+	}
+
+	DescriptorSetLayoutCache::~DescriptorSetLayoutCache()
+	{
+		for (auto& [layout, entry] : m_LayoutEntries)
+		{
+			if (entry.UpdateTemplate)
+				vkDestroyDescriptorUpdateTemplate(m_Device, entry.UpdateTemplate, nullptr);
+
+			vkDestroyDescriptorSetLayout(m_Device, layout, nullptr);
+		}
+	}
+
+	VkDescriptorSetLayout DescriptorSetLayoutCache::GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags)
+	{
+		ASSERT(bindingFlags.empty() || bindingFlags.size() == bindings.size(), "Binding flags have to be given for every binding");
+
+		// Sort bindings by binding index together with their flags
+		std::vector<uint32_t> order(bindings.size());
+		for (uint32_t i = 0; i < order.size(); i++)
+			order[i] = i;
+
+		std::sort(order.begin(), order.end(), [&bindings](uint32_t a, uint32_t b) { return bindings[a].binding < bindings[b].binding; });
+
+		std::vector<VkDescriptorSetLayoutBinding> sortedBindings;
+		std::vector<VkDescriptorBindingFlags> sortedFlags;
+		sortedBindings.reserve(bindings.size());
+		sortedFlags.reserve(bindings.size());
+
+		// Build signature
+		std::vector<uint32_t> signature;
+		signature.reserve(bindings.size() * 5);
+		for (uint32_t index : order)
+		{
+			const VkDescriptorSetLayoutBinding& binding = bindings[index];
+			VkDescriptorBindingFlags flags = bindingFlags.empty() ? 0 : bindingFlags[index];
+
+			ASSERT(binding.pImmutableSamplers == nullptr, "Immutable samplers are not supported by the layout cache");
+
+			sortedBindings.push_back(binding);
+			sortedFlags.push_back(flags);
+
+			signature.push_back(binding.binding);
+			signature.push_back((uint32_t)binding.descriptorType);
+			signature.push_back(binding.descriptorCount);
+			signature.push_back(binding.stageFlags);
+			signature.push_back(flags);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Layouts.find(signature);
+		if (it != m_Layouts.end())
+			return it->second;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = (uint32_t)sortedFlags.size();
+		bindingFlagsInfo.pBindingFlags = sortedFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+		layoutInfo.bindingCount = (uint32_t)sortedBindings.size();
+		layoutInfo.pBindings = sortedBindings.data();
+
+		VkDescriptorSetLayout descriptorSetLayout;
+		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &descriptorSetLayout));
+
+		m_Layouts[signature] = descriptorSetLayout;
+
+		LayoutEntry& entry = m_LayoutEntries[descriptorSetLayout];
+		for (const VkDescriptorSetLayoutBinding& binding : sortedBindings)
+		{
+			entry.FirstElements[binding.binding] = entry.ElementCount;
+			entry.ElementCount += binding.descriptorCount;
+		}
+
+		entry.Bindings = std::move(sortedBindings);
+
+		return descriptorSetLayout;
+	}
+
+	VkDescriptorUpdateTemplate DescriptorSetLayoutCache::GetUpdateTemplate(VkDescriptorSetLayout layout)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_LayoutEntries.find(layout);
+		ASSERT(it != m_LayoutEntries.end(), "Layout was not created by the layout cache");
+
+		LayoutEntry& entry = it->second;
+		if (entry.UpdateTemplate)
+			return entry.UpdateTemplate;
+
+		std::vector<VkDescriptorUpdateTemplateEntry> templateEntries;
+		templateEntries.reserve(entry.Bindings.size());
+
+		for (const VkDescriptorSetLayoutBinding& binding : entry.Bindings)
+		{
+			ASSERT(binding.descriptorCount > 0, "Unsized arrays can not be updated through templates");
+
+			// One entry per binding, array elements are read one after another with the element stride
+			VkDescriptorUpdateTemplateEntry& templateEntry = templateEntries.emplace_back();
+			templateEntry.dstBinding = binding.binding;
+			templateEntry.dstArrayElement = 0;
+			templateEntry.descriptorCount = binding.descriptorCount;
+			templateEntry.descriptorType = binding.descriptorType;
+			templateEntry.offset = entry.FirstElements.at(binding.binding) * sizeof(DescriptorUpdateData);
+			templateEntry.stride = sizeof(DescriptorUpdateData);
+		}
+
+		VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+		templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		templateInfo.descriptorUpdateEntryCount = (uint32_t)templateEntries.size();
+		templateInfo.pDescriptorUpdateEntries = templateEntries.data();
+		templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		templateInfo.descriptorSetLayout = layout;
+
+		VK_CHECK_RESULT(vkCreateDescriptorUpdateTemplate(m_Device, &templateInfo, nullptr, &entry.UpdateTemplate));
+
+		return entry.UpdateTemplate;
+	}
+
+	uint32_t DescriptorSetLayoutCache::GetUpdateDataElement(VkDescriptorSetLayout layout, uint32_t binding)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_LayoutEntries.find(layout);
+		ASSERT(it != m_LayoutEntries.end(), "Layout was not created by the layout cache");
+
+		auto element = it->second.FirstElements.find(binding);
+		ASSERT(element != it->second.FirstElements.end(), "Layout has no such binding");
+		return element->second;
+	}
+
+	uint32_t DescriptorSetLayoutCache::GetUpdateDataCount(VkDescriptorSetLayout layout)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_LayoutEntries.find(layout);
+		ASSERT(it != m_LayoutEntries.end(), "Layout was not created by the layout cache");
+		return it->second.ElementCount;
+	}
+
+	bool DescriptorSetLayoutCache::GetDescriptorCounts(VkDescriptorSetLayout layout, std::vector<VkDescriptorPoolSize>& outCounts)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_LayoutEntries.find(layout);
+		if (it == m_LayoutEntries.end())
+			return false;
+
+		std::map<VkDescriptorType, uint32_t> counts;
+		for (const VkDescriptorSetLayoutBinding& binding : it->second.Bindings)
+			counts[binding.descriptorType] += binding.descriptorCount;
+
+		outCounts.clear();
+		for (auto& [type, count] : counts)
+			outCounts.push_back({ type, count });
+
+		return true;
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "pch.h"
+#include <vulkan/vulkan.h>
+#include <mutex>
+
+namespace VkLibrary {
+
+	// Element of the packed array read by descriptor update templates, bindings are laid out one after another in binding order
+	// and array bindings take one element per array element, GetUpdateDataElement returns where a binding starts
+	union DescriptorUpdateData
+	{
+		VkDescriptorImageInfo ImageInfo;
+		VkDescriptorBufferInfo BufferInfo;
+		VkAccelerationStructureKHR AccelerationStructure;
+	};
+
+	// NOTE: Layouts are keyed by their binding signature including binding flags and live until the device is destroyed
+	// Update templates cover every binding including arrays, unsized arrays can not be written through a template
+
+	class DescriptorSetLayoutCache
+	{
+	public:
+		DescriptorSetLayoutCache(VkDevice device);
+		~DescriptorSetLayoutCache();
+
+	public:
+		// Returns a layout shared by everything that declares the same bindings
+		VkDescriptorSetLayout GetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags = {});
+
+		// Returns an update template for a layout created by this cache, data is an array of GetUpdateDataCount DescriptorUpdateData
+		VkDescriptorUpdateTemplate GetUpdateTemplate(VkDescriptorSetLayout layout);
+
+		// First DescriptorUpdateData element of a binding, array element i of the binding is read from element + i
+		uint32_t GetUpdateDataElement(VkDescriptorSetLayout layout, uint32_t binding);
+		uint32_t GetUpdateDataCount(VkDescriptorSetLayout layout);
+
+		// Descriptors of each type one set of the layout needs, sorted by type, false for layouts from elsewhere
+		bool GetDescriptorCounts(VkDescriptorSetLayout layout, std::vector<VkDescriptorPoolSize>& outCounts);
+
+	private:
+		struct LayoutEntry
+		{
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+			VkDescriptorUpdateTemplate UpdateTemplate = VK_NULL_HANDLE;
+
+			// Binding to its first element in the update data
+			std::unordered_map<uint32_t, uint32_t> FirstElements;
+			uint32_t ElementCount = 0;
+		};
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+
+		std::mutex m_Mutex;
+		std::map<std::vector<uint32_t>, VkDescriptorSetLayout> m_Layouts;
+		std::unordered_map<VkDescriptorSetLayout, LayoutEntry> m_LayoutEntries;
+	};
+
+}
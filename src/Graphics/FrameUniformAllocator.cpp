@@ -0,0 +1,227 @@
+#include "pch.h"
+#include "FrameUniformAllocator.h"
+#include "VulkanAllocator.h"
+#include "VulkanTools.h"
+#include "Core/Application.h"
+#include <atomic>
+#include <mutex>
+
+namespace VkLibrary {
+
+	// Buffer holding one region per frame in flight and the set that exposes it
+	struct FrameUniformBlock
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VmaAllocation Allocation = nullptr;
+		uint8_t* MappedData = nullptr;
+		bool Coherent = true;
+
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+		uint32_t SizePerFrame = 0;
+		std::atomic<uint32_t> Head{ 0 };
+	};
+
+	struct FrameUniformAllocatorData
+	{
+		VkDevice Device = VK_NULL_HANDLE;
+		VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+
+		uint32_t FramesInFlight = 0;
+		uint32_t Alignment = 0;
+		uint32_t MaxAllocationSize = 0;
+		uint32_t FrameIndex = 0;
+
+		// Allocations read the current block without locking, the mutex is only taken to replace it
+		std::atomic<FrameUniformBlock*> Current{ nullptr };
+
+		// Blocks replaced this frame, still referenced by command buffers being recorded
+		std::mutex Mutex;
+		std::vector<FrameUniformBlock*> RetiredBlocks;
+	};
+
+	static FrameUniformAllocatorData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+		{
+			return (value + alignment - 1) & ~(alignment - 1);
+		}
+
+		static FrameUniformBlock* CreateBlock(uint32_t sizePerFrame)
+		{
+			FrameUniformBlock* block = new FrameUniformBlock();
+			block->SizePerFrame = sizePerFrame;
+
+			// Pad the end so offset + range of the last allocation stays inside the buffer
+			VkBufferCreateInfo bufferCreateInfo = {};
+			bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferCreateInfo.size = (VkDeviceSize)sizePerFrame * s_Data->FramesInFlight + s_Data->MaxAllocationSize;
+			bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VulkanAllocator allocator("FrameUniformAllocator");
+			block->Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, block->Buffer, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+			block->MappedData = (uint8_t*)allocator.GetMappedData(block->Allocation);
+			block->Coherent = allocator.IsHostCoherent(block->Allocation);
+
+			VkTools::SetBufferName(block->Buffer, "FrameUniformAllocator");
+
+			block->DescriptorSet = Application::GetVulkanDevice()->GetDescriptorAllocator().Allocate(s_Data->Layout);
+
+			// Descriptor range is fixed, so every allocation exposes this many bytes to the shader
+			VkDescriptorBufferInfo bufferInfo{};
+			bufferInfo.buffer = block->Buffer;
+			bufferInfo.offset = 0;
+			bufferInfo.range = s_Data->MaxAllocationSize;
+
+			VkWriteDescriptorSet writeDescriptor{};
+			writeDescriptor.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptor.dstSet = block->DescriptorSet;
+			writeDescriptor.dstBinding = FrameUniformAllocator::Binding;
+			writeDescriptor.descriptorCount = 1;
+			writeDescriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			writeDescriptor.pBufferInfo = &bufferInfo;
+
+			vkUpdateDescriptorSets(s_Data->Device, 1, &writeDescriptor, 0, nullptr);
+
+			return block;
+		}
+
+		static void DestroyBlock(FrameUniformBlock* block)
+		{
+			Application::GetVulkanDevice()->GetDescriptorAllocator().Free(block->DescriptorSet);
+
+			VulkanAllocator allocator("FrameUniformAllocator");
+			allocator.DestroyBuffer(block->Buffer, block->Allocation);
+
+			delete block;
+		}
+
+		static void FlushBlock(FrameUniformBlock* block)
+		{
+			uint32_t used = std::min(block->Head.load(), block->SizePerFrame);
+			if (block->Coherent || used == 0)
+				return;
+
+			VulkanAllocator allocator("FrameUniformAllocator");
+			allocator.FlushAllocation(block->Allocation, s_Data->FrameIndex * block->SizePerFrame, used);
+		}
+
+	}
+
+	void FrameUniformAllocator::Init(uint32_t sizePerFrame)
+	{
+		s_Data = new FrameUniformAllocatorData();
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		s_Data->Device = device->GetLogicalDevice();
+		s_Data->FramesInFlight = Application::GetSwapchain()->GetFramesInFlight();
+
+		const VkPhysicalDeviceLimits& limits = device->GetDeviceProperties().properties.limits;
+		s_Data->Alignment = (uint32_t)std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 16);
+		sizePerFrame = Utils::AlignUp(sizePerFrame, s_Data->Alignment);
+
+		s_Data->MaxAllocationSize = std::min({ limits.maxUniformBufferRange, 64u * 1024u, sizePerFrame });
+
+		// Layout matches what shaders declaring the set get from the layout cache
+		std::vector<VkDescriptorSetLayoutBinding> bindings = {
+			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL, Binding),
+		};
+		s_Data->Layout = device->GetDescriptorSetLayoutCache().GetLayout(bindings);
+
+		s_Data->Current = Utils::CreateBlock(sizePerFrame);
+
+		LOG_INFO("Frame uniform allocator: {} KB per frame, {} frames, {} byte alignment", sizePerFrame / 1024, s_Data->FramesInFlight, s_Data->Alignment);
+	}
+
+	void FrameUniformAllocator::Shutdown()
+	{
+		for (FrameUniformBlock* block : s_Data->RetiredBlocks)
+			Utils::DestroyBlock(block);
+
+		Utils::DestroyBlock(s_Data->Current);
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void FrameUniformAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		// Blocks replaced last frame can go once the frames that may still read them have finished
+		for (FrameUniformBlock* block : s_Data->RetiredBlocks)
+			Application::GetVulkanDevice()->GetDeletionQueue().Push([block]() { Utils::DestroyBlock(block); });
+
+		s_Data->RetiredBlocks.clear();
+
+		s_Data->FrameIndex = frameIndex;
+		s_Data->Current.load()->Head = 0;
+	}
+
+	void FrameUniformAllocator::Flush()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		for (FrameUniformBlock* block : s_Data->RetiredBlocks)
+			Utils::FlushBlock(block);
+
+		Utils::FlushBlock(s_Data->Current);
+	}
+
+	FrameUniformAllocation FrameUniformAllocator::Allocate(uint32_t size)
+	{
+		ASSERT(size <= s_Data->MaxAllocationSize, "Allocation is larger than the uniform descriptor range");
+
+		uint32_t alignedSize = Utils::AlignUp(size, s_Data->Alignment);
+
+		while (true)
+		{
+			FrameUniformBlock* block = s_Data->Current;
+			uint32_t offset = block->Head.fetch_add(alignedSize);
+
+			if (offset + alignedSize <= block->SizePerFrame)
+			{
+				FrameUniformAllocation allocation;
+				allocation.Offset = s_Data->FrameIndex * block->SizePerFrame + offset;
+				allocation.Size = size;
+				allocation.Data = block->MappedData + allocation.Offset;
+				allocation.DescriptorSet = block->DescriptorSet;
+				return allocation;
+			}
+
+			// Out of space, replace the block with one twice the size unless another thread already did
+			// Allocations made earlier this frame keep using the old block, it is destroyed once the frame has finished
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			if (s_Data->Current != block)
+				continue;
+
+			FrameUniformBlock* grownBlock = Utils::CreateBlock(block->SizePerFrame * 2);
+			s_Data->RetiredBlocks.push_back(block);
+			s_Data->Current = grownBlock;
+
+			LOG_WARN("Frame uniform allocator grew to {} KB per frame", grownBlock->SizePerFrame / 1024);
+		}
+	}
+
+	void FrameUniformAllocator::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, const FrameUniformAllocation& allocation)
+	{
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, SetIndex, 1, &allocation.DescriptorSet, 1, &allocation.Offset);
+	}
+
+	bool FrameUniformAllocator::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+	uint32_t FrameUniformAllocator::GetMaxAllocationSize()
+	{
+		return s_Data->MaxAllocationSize;
+	}
+
+	VkDescriptorSetLayout FrameUniformAllocator::GetDescriptorSetLayout()
+	{
+		return s_Data->Layout;
+	}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "Core/Core.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	struct FrameUniformAllocation
+	{
+		void* Data = nullptr;
+		uint32_t Offset = 0; // Dynamic offset into the ring buffer
+		uint32_t Size = 0;
+
+		// Set of the buffer the allocation lives in, changes when the allocator grows
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+		inline bool IsValid() const { return Data != nullptr; }
+	};
+
+	// NOTE: Shaders declare per-draw data as layout(set = 5, binding = 0) uniform ..., the set is shared by all shaders and
+	// bound with the allocation offset as dynamic offset. Allocations are only valid for the frame they were made in
+	// A frame that runs out of space moves to a buffer twice the size with its own set, Bind uses the set of the allocation
+	// The old buffer stays alive until the frames that recorded allocations from it have finished
+
+	class FrameUniformAllocator
+	{
+	public:
+		static constexpr uint32_t SetIndex = 5;
+		static constexpr uint32_t Binding = 0;
+
+		static void Init(uint32_t sizePerFrame = 4 * 1024 * 1024);
+		static void Shutdown();
+
+		// Called by the swapchain once the fence of the frame has signaled
+		static void BeginFrame(uint32_t frameIndex);
+
+		// Flushes the memory written this frame, only does work on non-coherent memory
+		static void Flush();
+
+		static FrameUniformAllocation Allocate(uint32_t size);
+
+		template<typename T>
+		static FrameUniformAllocation Allocate(const T& data)
+		{
+			FrameUniformAllocation allocation = Allocate((uint32_t)sizeof(T));
+			if (allocation.IsValid())
+				memcpy(allocation.Data, &data, sizeof(T));
+
+			return allocation;
+		}
+
+		static void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, const FrameUniformAllocation& allocation);
+
+		static bool IsInitialized();
+
+		// Largest block a shader can read from a single allocation
+		static uint32_t GetMaxAllocationSize();
+
+		static VkDescriptorSetLayout GetDescriptorSetLayout();
+	};
+
+}
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Framebuffer.h"
+#include "VulkanExtensions.h"
 #include "Core/Application.h"
 
 namespace VkLibrary {
@@ -7,15 +8,31 @@ namespace VkLibrary {
 	Framebuffer::Framebuffer(const FramebufferSpecification& specification)
 		:	m_Specification(specification)
 	{
+		m_DynamicRendering = m_Specification.DynamicRendering && Application::GetVulkanDevice()->IsDynamicRenderingSupported();
 		Resize(m_Specification.Width, m_Specification.Height);
 	}
 
 	Framebuffer::~Framebuffer()
 	{
+		Release();
+	}
+
+	void Framebuffer::Release()
+	{
+		if (!m_Framebuffer)
+			return;
+
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		vkDestroyRenderPass(device->GetLogicalDevice(), m_RenderPass, nullptr);
-		vkDestroyFramebuffer(device->GetLogicalDevice(), m_Framebuffer, nullptr);
+		// Command buffers of frames in flight may still reference the old framebuffer
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), renderPass = m_RenderPass, framebuffer = m_Framebuffer]()
+		{
+			vkDestroyRenderPass(device, renderPass, nullptr);
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
+		});
+
+		m_RenderPass = VK_NULL_HANDLE;
+		m_Framebuffer = VK_NULL_HANDLE;
 	}
 
 	void Framebuffer::InitAttachmentImages()
@@ -84,8 +101,13 @@ namespace VkLibrary {
 
 	void Framebuffer::CreateFramebuffer()
 	{
+		Release();
 		InitAttachmentImages();
 
+		// Attachments are bound when rendering begins, only the images depend on the size
+		if (m_DynamicRendering)
+			return;
+
 		// Collect attachment descriptions
 		std::vector<VkAttachmentDescription> attachmentDescriptions;
 		for (auto& attachment : m_ColorAttachments)
@@ -234,4 +256,113 @@ namespace VkLibrary {
 		VkTools::SetFramebufferName(m_Framebuffer, m_Specification.DebugName.c_str());
 	}
 
+	void Framebuffer::Begin(VkCommandBuffer commandBuffer)
+	{
+		VkClearValue colorClearValue = {};
+		colorClearValue.color = { m_Specification.ClearColor.r, m_Specification.ClearColor.g, m_Specification.ClearColor.b, m_Specification.ClearColor.a };
+
+		VkClearValue depthClearValue = {};
+		depthClearValue.depthStencil = { 1.0f, 0 };
+
+		uint32_t layerCount = 1;
+		for (const FramebufferAttachment& attachment : m_ColorAttachments)
+			layerCount = std::max(layerCount, attachment.Image->GetSpecification().LayerCount);
+
+		if (!m_DynamicRendering)
+		{
+			std::vector<VkClearValue> clearValues(m_ColorAttachments.size(), colorClearValue);
+			if (m_DepthAttachment)
+				clearValues.push_back(depthClearValue);
+
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = m_RenderPass;
+			renderPassInfo.framebuffer = m_Framebuffer;
+			renderPassInfo.renderArea.extent = { m_Width, m_Height };
+			renderPassInfo.clearValueCount = (uint32_t)clearValues.size();
+			renderPassInfo.pClearValues = clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			return;
+		}
+
+		// Without a render pass the layout transitions in and out of attachment layouts are recorded here
+		BarrierBatch barriers;
+		VkAttachmentLoadOp loadOp = m_Specification.ClearOnLoad ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+
+		std::vector<VkRenderingAttachmentInfoKHR> colorAttachments;
+		for (const FramebufferAttachment& attachment : m_ColorAttachments)
+		{
+			// Contents are cleared anyway, transitioning from undefined lets the driver skip preserving them
+			if (m_Specification.ClearOnLoad)
+				attachment.Image->GetState().Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			barriers.TransitionImage(*attachment.Image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+				VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR);
+
+			VkRenderingAttachmentInfoKHR& attachmentInfo = colorAttachments.emplace_back();
+			attachmentInfo = {};
+			attachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			attachmentInfo.imageView = attachment.Image->GetDescriptorImageInfo().imageView;
+			attachmentInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachmentInfo.loadOp = loadOp;
+			attachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachmentInfo.clearValue = colorClearValue;
+		}
+
+		VkRenderingAttachmentInfoKHR depthAttachment = {};
+		if (m_DepthAttachment)
+		{
+			if (m_Specification.ClearOnLoad)
+				m_DepthAttachment.Image->GetState().Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			barriers.TransitionImage(*m_DepthAttachment.Image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR);
+
+			depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			depthAttachment.imageView = m_DepthAttachment.Image->GetDescriptorImageInfo().imageView;
+			depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			depthAttachment.loadOp = loadOp;
+			depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			depthAttachment.clearValue = depthClearValue;
+		}
+
+		barriers.Flush(commandBuffer);
+
+		bool hasStencil = m_DepthAttachment && VkTools::IsStencilFormat(m_DepthAttachment.Description.format);
+
+		VkRenderingInfoKHR renderingInfo = {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.renderArea.extent = { m_Width, m_Height };
+		renderingInfo.layerCount = layerCount;
+		renderingInfo.colorAttachmentCount = (uint32_t)colorAttachments.size();
+		renderingInfo.pColorAttachments = colorAttachments.data();
+		renderingInfo.pDepthAttachment = m_DepthAttachment ? &depthAttachment : nullptr;
+		renderingInfo.pStencilAttachment = hasStencil ? &depthAttachment : nullptr;
+
+		vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+	}
+
+	void Framebuffer::End(VkCommandBuffer commandBuffer)
+	{
+		if (!m_DynamicRendering)
+		{
+			vkCmdEndRenderPass(commandBuffer);
+			return;
+		}
+
+		vkCmdEndRenderingKHR(commandBuffer);
+
+		// Same final layouts the render pass path uses, so descriptors written for either path stay valid
+		BarrierBatch barriers;
+		for (const FramebufferAttachment& attachment : m_ColorAttachments)
+			barriers.TransitionImage(*attachment.Image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+
+		if (m_DepthAttachment)
+			barriers.TransitionImage(*m_DepthAttachment.Image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+
+		barriers.Flush(commandBuffer);
+	}
+
 }
\ No newline at end of file
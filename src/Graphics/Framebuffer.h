@@ -11,6 +11,10 @@ namespace VkLibrary {
 		bool ClearOnLoad = true;
 		glm::vec4 ClearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
 		std::vector<ImageFormat> AttachmentFormats;
+
+		// Renders with vkCmdBeginRendering instead of render pass and framebuffer objects, pipelines are then built
+		// from AttachmentFormats and stay valid across resizes. Ignored if the device does not support it
+		bool DynamicRendering = false;
 		
 		std::string DebugName = "Framebuffer";
 	};
@@ -35,8 +39,14 @@ namespace VkLibrary {
 		bool Resize(uint32_t width, uint32_t height);
 		void CreateFramebuffer();
 
+		// Begins rendering to all attachments with a full size render area, attachments are left readable by fragment shaders after End
+		void Begin(VkCommandBuffer commandBuffer);
+		void End(VkCommandBuffer commandBuffer);
+
+		// Null with dynamic rendering
 		inline VkFramebuffer GetFramebuffer() { return m_Framebuffer; }
 		inline VkRenderPass GetRenderPass() { return m_RenderPass; }
+		inline bool UsesDynamicRendering() const { return m_DynamicRendering; }
 
 		inline uint32_t GetWidth() { return m_Width; }
 		inline uint32_t GetHeight() { return m_Height; }
@@ -51,11 +61,13 @@ namespace VkLibrary {
 
 	private:
 		void InitAttachmentImages();
+		void Release();
 
 	private:
 		FramebufferSpecification m_Specification;
 		uint32_t m_Width = 0;
 		uint32_t m_Height = 0;
+		bool m_DynamicRendering = false;
 
 		VkFramebuffer m_Framebuffer = VK_NULL_HANDLE;
 		VkRenderPass m_RenderPass = VK_NULL_HANDLE;
@@ -0,0 +1,266 @@
+#include "pch.h"
+#include "GeometryPool.h"
+#include "VulkanAllocator.h"
+#include "VulkanBuffers.h"
+#include "VulkanTools.h"
+#include "UploadContext.h"
+#include "Core/Application.h"
+#include <mutex>
+
+namespace VkLibrary {
+
+	struct GeometryBlock
+	{
+		BufferInfo VertexBuffer;
+		BufferInfo IndexBuffer;
+		uint64_t VertexBufferAddress = 0;
+		uint64_t IndexBufferAddress = 0;
+
+		Scope<OffsetAllocator> VertexAllocator;
+		Scope<OffsetAllocator> IndexAllocator;
+	};
+
+	struct GeometryPoolData
+	{
+		uint32_t VertexStride = 0;
+		uint32_t VerticesPerBlock = 0;
+		uint32_t IndicesPerBlock = 0;
+
+		// Block buffers are bound as storage buffers as well, no single allocation can be larger than this
+		uint64_t MaxBufferRange = 0;
+
+		std::mutex Mutex;
+		std::vector<Scope<GeometryBlock>> Blocks;
+	};
+
+	static GeometryPoolData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static void CreateGeometryBuffer(VkDeviceSize size, VkBufferUsageFlags usage, const char* debugName, BufferInfo& outBufferInfo)
+		{
+			VkBufferCreateInfo bufferCreateInfo = {};
+			bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferCreateInfo.size = size;
+			bufferCreateInfo.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VulkanAllocator allocator(debugName);
+			outBufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY, outBufferInfo.Buffer);
+
+			VkTools::SetBufferName(outBufferInfo.Buffer, debugName);
+		}
+
+		// Called with the mutex held
+		static uint32_t CreateBlock(uint32_t maxVertices, uint32_t maxIndices)
+		{
+			Scope<GeometryBlock> block = CreateScope<GeometryBlock>();
+
+			CreateGeometryBuffer((VkDeviceSize)maxVertices * s_Data->VertexStride, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, "GeometryPool Vertices", block->VertexBuffer);
+			CreateGeometryBuffer((VkDeviceSize)maxIndices * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, "GeometryPool Indices", block->IndexBuffer);
+
+			block->VertexBufferAddress = VulkanAllocator::GetBufferDeviceAddress(block->VertexBuffer.Buffer);
+			block->IndexBufferAddress = VulkanAllocator::GetBufferDeviceAddress(block->IndexBuffer.Buffer);
+
+			// Offsets are managed in elements, not bytes
+			block->VertexAllocator = CreateScope<OffsetAllocator>(maxVertices);
+			block->IndexAllocator = CreateScope<OffsetAllocator>(maxIndices);
+
+			s_Data->Blocks.push_back(std::move(block));
+
+			LOG_INFO("Geometry pool block {}: {} vertices ({} MB), {} indices ({} MB)", s_Data->Blocks.size() - 1,
+				maxVertices, ((uint64_t)maxVertices * s_Data->VertexStride) >> 20, maxIndices, ((uint64_t)maxIndices * sizeof(uint32_t)) >> 20);
+
+			return (uint32_t)s_Data->Blocks.size() - 1;
+		}
+
+		static bool TryAllocate(GeometryBlock& block, uint32_t vertexCount, uint32_t indexCount, GeometryAllocation& outAllocation)
+		{
+			outAllocation.Vertices = block.VertexAllocator->Allocate(vertexCount);
+			outAllocation.Indices = block.IndexAllocator->Allocate(indexCount);
+
+			if (outAllocation.IsValid())
+				return true;
+
+			if (outAllocation.Vertices.IsValid())
+				block.VertexAllocator->Free(outAllocation.Vertices);
+			if (outAllocation.Indices.IsValid())
+				block.IndexAllocator->Free(outAllocation.Indices);
+
+			outAllocation = GeometryAllocation();
+			return false;
+		}
+
+		static GeometryBlock& GetBlock(uint32_t block)
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			ASSERT(block < s_Data->Blocks.size(), "Geometry pool block out of range");
+			return *s_Data->Blocks[block];
+		}
+
+	}
+
+	void GeometryPool::Init(uint32_t vertexStride, uint32_t verticesPerBlock, uint32_t indicesPerBlock)
+	{
+		s_Data = new GeometryPoolData();
+		s_Data->VertexStride = vertexStride;
+		s_Data->VerticesPerBlock = verticesPerBlock;
+		s_Data->IndicesPerBlock = indicesPerBlock;
+		s_Data->MaxBufferRange = Application::GetVulkanDevice()->GetDeviceProperties().properties.limits.maxStorageBufferRange;
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::CreateBlock(verticesPerBlock, indicesPerBlock);
+	}
+
+	void GeometryPool::Shutdown()
+	{
+		VulkanAllocator allocator("GeometryPool");
+		for (Scope<GeometryBlock>& block : s_Data->Blocks)
+		{
+			allocator.DestroyBuffer(block->VertexBuffer.Buffer, block->VertexBuffer.Allocation);
+			allocator.DestroyBuffer(block->IndexBuffer.Buffer, block->IndexBuffer.Allocation);
+		}
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	GeometryAllocation GeometryPool::Allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		GeometryAllocation allocation;
+		GeometryBlock* block = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+			for (uint32_t i = 0; i < s_Data->Blocks.size() && !block; i++)
+			{
+				if (Utils::TryAllocate(*s_Data->Blocks[i], vertexCount, indexCount, allocation))
+				{
+					allocation.Block = i;
+					block = s_Data->Blocks[i].get();
+				}
+			}
+
+			// Every block is full, add one that is at least large enough for this allocation
+			if (!block)
+			{
+				uint32_t maxVertices = std::max(s_Data->VerticesPerBlock, vertexCount);
+				uint32_t maxIndices = std::max(s_Data->IndicesPerBlock, indexCount);
+
+				if ((uint64_t)vertexCount * s_Data->VertexStride > s_Data->MaxBufferRange || (uint64_t)indexCount * sizeof(uint32_t) > s_Data->MaxBufferRange)
+				{
+					LOG_ERROR("Geometry is too large for the geometry pool ({} vertices, {} indices requested)", vertexCount, indexCount);
+					return allocation;
+				}
+
+				uint32_t blockIndex = Utils::CreateBlock(maxVertices, maxIndices);
+				if (Utils::TryAllocate(*s_Data->Blocks[blockIndex], vertexCount, indexCount, allocation))
+				{
+					allocation.Block = blockIndex;
+					block = s_Data->Blocks[blockIndex].get();
+				}
+			}
+		}
+
+		if (!block)
+		{
+			LOG_ERROR("Geometry pool could not allocate {} vertices, {} indices", vertexCount, indexCount);
+			return allocation;
+		}
+
+		allocation.VertexOffset = allocation.Vertices.Offset;
+		allocation.VertexCount = vertexCount;
+		allocation.IndexOffset = allocation.Indices.Offset;
+		allocation.IndexCount = indexCount;
+
+		// Upload both ranges with one submit
+		uint32_t vertexDataSize = vertexCount * s_Data->VertexStride;
+		uint32_t indexDataSize = indexCount * sizeof(uint32_t);
+
+		UploadBatch batch = UploadContext::Begin();
+		VkBuffer vertexStagingBuffer = UploadContext::Stage(batch, vertices, vertexDataSize, "GeometryPool Vertex Staging");
+		VkBuffer indexStagingBuffer = UploadContext::Stage(batch, indices, indexDataSize, "GeometryPool Index Staging");
+
+		VkBufferCopy vertexCopy = {};
+		vertexCopy.dstOffset = (VkDeviceSize)allocation.VertexOffset * s_Data->VertexStride;
+		vertexCopy.size = vertexDataSize;
+		vkCmdCopyBuffer(batch.CommandBuffer, vertexStagingBuffer, block->VertexBuffer.Buffer, 1, &vertexCopy);
+
+		VkBufferCopy indexCopy = {};
+		indexCopy.dstOffset = (VkDeviceSize)allocation.IndexOffset * sizeof(uint32_t);
+		indexCopy.size = indexDataSize;
+		vkCmdCopyBuffer(batch.CommandBuffer, indexStagingBuffer, block->IndexBuffer.Buffer, 1, &indexCopy);
+
+		// Only the written ranges change hands, the rest of the pool stays in use by the graphics queue
+		VkAccessFlags dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		UploadContext::ReleaseBuffer(batch, block->VertexBuffer.Buffer, vertexCopy.dstOffset, vertexCopy.size, dstAccessMask, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		UploadContext::ReleaseBuffer(batch, block->IndexBuffer.Buffer, indexCopy.dstOffset, indexCopy.size, dstAccessMask, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		UploadContext::Submit(batch);
+
+		return allocation;
+	}
+
+	void GeometryPool::Free(GeometryAllocation& allocation)
+	{
+		if (!s_Data || !allocation.IsValid())
+			return;
+
+		// Freed ranges are recycled by the next allocations, only free once frames in flight no longer read them
+		Application::GetVulkanDevice()->GetDeletionQueue().Push([block = allocation.Block, vertices = allocation.Vertices, indices = allocation.Indices]()
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			s_Data->Blocks[block]->VertexAllocator->Free(vertices);
+			s_Data->Blocks[block]->IndexAllocator->Free(indices);
+		});
+
+		allocation = GeometryAllocation();
+	}
+
+	void GeometryPool::Bind(VkCommandBuffer commandBuffer, uint32_t block)
+	{
+		GeometryBlock& geometryBlock = Utils::GetBlock(block);
+
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometryBlock.VertexBuffer.Buffer, &offset);
+		vkCmdBindIndexBuffer(commandBuffer, geometryBlock.IndexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	bool GeometryPool::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+	uint32_t GeometryPool::GetBlockCount()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		return (uint32_t)s_Data->Blocks.size();
+	}
+
+	uint32_t GeometryPool::GetVertexStride()
+	{
+		return s_Data->VertexStride;
+	}
+
+	VkBuffer GeometryPool::GetVertexBuffer(uint32_t block)
+	{
+		return Utils::GetBlock(block).VertexBuffer.Buffer;
+	}
+
+	VkBuffer GeometryPool::GetIndexBuffer(uint32_t block)
+	{
+		return Utils::GetBlock(block).IndexBuffer.Buffer;
+	}
+
+	uint64_t GeometryPool::GetVertexBufferAddress(uint32_t block)
+	{
+		return Utils::GetBlock(block).VertexBufferAddress;
+	}
+
+	uint64_t GeometryPool::GetIndexBufferAddress(uint32_t block)
+	{
+		return Utils::GetBlock(block).IndexBufferAddress;
+	}
+
+}
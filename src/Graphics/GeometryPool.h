@@ -0,0 +1,54 @@
+#pragma once
+#include "Core/Core.h"
+#include "Memory/OffsetAllocator.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	struct GeometryAllocation
+	{
+		OffsetAllocation Vertices;
+		OffsetAllocation Indices;
+
+		// Block holding both ranges, see GeometryPool::GetVertexBuffer and GetIndexBuffer
+		uint32_t Block = 0;
+
+		// In elements, usable directly as vertexOffset / firstIndex of indexed draws
+		uint32_t VertexOffset = 0;
+		uint32_t VertexCount = 0;
+		uint32_t IndexOffset = 0;
+		uint32_t IndexCount = 0;
+
+		inline bool IsValid() const { return Vertices.IsValid() && Indices.IsValid(); }
+	};
+
+	// NOTE: Mesh geometry lives in blocks of one device local vertex buffer and one index buffer each, so a scene
+	// draws with a single bind per block and acceleration structures build from the block's buffer addresses
+	// The pool starts with one block and adds another when an allocation fits in none of them, blocks are never
+	// moved or resized so offsets, addresses and descriptors of existing allocations stay valid
+
+	class GeometryPool
+	{
+	public:
+		// Sizes of a block, larger blocks are created for allocations that do not fit
+		static void Init(uint32_t vertexStride, uint32_t verticesPerBlock = 1024 * 1024, uint32_t indicesPerBlock = 4 * 1024 * 1024);
+		static void Shutdown();
+
+		// Vertices are vertexStride bytes each, indices are uint32_t and relative to the first vertex of the allocation
+		// Returns an invalid allocation when no block could be created, callers have to check IsValid
+		static GeometryAllocation Allocate(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+		static void Free(GeometryAllocation& allocation);
+
+		static void Bind(VkCommandBuffer commandBuffer, uint32_t block = 0);
+
+		static bool IsInitialized();
+
+		static uint32_t GetBlockCount();
+		static uint32_t GetVertexStride();
+		static VkBuffer GetVertexBuffer(uint32_t block = 0);
+		static VkBuffer GetIndexBuffer(uint32_t block = 0);
+		static uint64_t GetVertexBufferAddress(uint32_t block = 0);
+		static uint64_t GetIndexBufferAddress(uint32_t block = 0);
+	};
+
+}
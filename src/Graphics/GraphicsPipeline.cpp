@@ -19,10 +19,14 @@ namespace VkLibrary {
 
 	GraphicsPipeline::~GraphicsPipeline()
 	{
-		VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		vkDestroyPipeline(device, m_Pipeline, nullptr);
-		vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+		// Pipelines can be swapped while frames that bound them are still in flight
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), pipeline = m_Pipeline, pipelineLayout = m_PipelineLayout]()
+		{
+			vkDestroyPipeline(device, pipeline, nullptr);
+			vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		});
 	}
 
 	void GraphicsPipeline::Init()
@@ -104,6 +108,28 @@ namespace VkLibrary {
 		multisampling.alphaToCoverageEnable = VK_FALSE;
 		multisampling.alphaToOneEnable = VK_FALSE;
 
+		// Attachment formats replace the render pass when rendering dynamically
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		for (ImageFormat attachmentFormat : m_Specification.AttachmentFormats)
+		{
+			VkFormat format = Image::ImageFormatToVulkan(attachmentFormat);
+			if (VkTools::IsDepthFormat(format))
+				depthFormat = format;
+			else
+				colorFormats.push_back(format);
+		}
+
+		VkPipelineRenderingCreateInfoKHR renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		renderingInfo.colorAttachmentCount = (uint32_t)colorFormats.size();
+		renderingInfo.pColorAttachmentFormats = colorFormats.data();
+		renderingInfo.depthAttachmentFormat = depthFormat;
+		renderingInfo.stencilAttachmentFormat = VkTools::IsStencilFormat(depthFormat) ? depthFormat : VK_FORMAT_UNDEFINED;
+
+		bool dynamicRendering = m_Specification.TargetRenderPass == VK_NULL_HANDLE;
+		ASSERT(!dynamicRendering || Application::GetVulkanDevice()->IsDynamicRenderingSupported(), "Pipeline without render pass needs dynamic rendering");
+
 		// Color blending attachment
 		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
 		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
@@ -121,8 +147,10 @@ namespace VkLibrary {
 		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
 		colorBlending.logicOpEnable = VK_FALSE;
 		colorBlending.logicOp = VK_LOGIC_OP_COPY;
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
+		// Every color attachment is blended the same way
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(dynamicRendering ? colorFormats.size() : 1, colorBlendAttachment);
+		colorBlending.attachmentCount = (uint32_t)colorBlendAttachments.size();
+		colorBlending.pAttachments = colorBlendAttachments.data();
 		colorBlending.blendConstants[0] = 0.0f;
 		colorBlending.blendConstants[1] = 0.0f;
 		colorBlending.blendConstants[2] = 0.0f;
@@ -172,11 +200,18 @@ namespace VkLibrary {
 		depthStencilState.stencilTestEnable = VK_FALSE;
 		depthStencilState.front = depthStencilState.back;
 
-		const std::vector<VkPipelineShaderStageCreateInfo>& shaderCreateInfo = m_Specification.Shader->GetShaderCreateInfo();
+		// Every stage gets the same specialization info, constants a stage does not declare are ignored
+		SpecializationData specializationData;
+		const VkSpecializationInfo* specializationInfo = m_Specification.SpecializationConstants.GetSpecializationInfo(*m_Specification.Shader, specializationData);
+
+		std::vector<VkPipelineShaderStageCreateInfo> shaderCreateInfo = m_Specification.Shader->GetShaderCreateInfo();
+		for (VkPipelineShaderStageCreateInfo& stageInfo : shaderCreateInfo)
+			stageInfo.pSpecializationInfo = specializationInfo;
 
 		// Create pipeline
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = dynamicRendering ? &renderingInfo : nullptr;
 		pipelineInfo.stageCount = (uint32_t)shaderCreateInfo.size();
 		pipelineInfo.pStages = shaderCreateInfo.data();
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -193,7 +228,7 @@ namespace VkLibrary {
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineInfo.basePipelineIndex = -1;
 
-		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline));
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, Application::GetVulkanDevice()->GetPipelineCache(), 1, &pipelineInfo, nullptr, &m_Pipeline));
 	}
 
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "Shader.h"
 #include "VertexBufferLayout.h"
+#include "SpecializationConstants.h"
+#include "Image.h"
 #include <vulkan/vulkan.h>
 
 namespace VkLibrary {
@@ -10,8 +12,12 @@ namespace VkLibrary {
 		Ref<Shader> Shader = nullptr;
 		Ref<VertexBufferLayout> Layout = nullptr;
 		VkRenderPass TargetRenderPass = VK_NULL_HANDLE;
+
+		// Used with dynamic rendering if no render pass is set, same order as the framebuffer's attachment formats
+		std::vector<ImageFormat> AttachmentFormats;
 		bool DepthWrite = true;
 		bool Blend = true;
+		SpecializationConstants SpecializationConstants;
 	};
 
 	// NOTE: Possible problem with deleting pipeline layouts not owned by this class
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Image.h"
 #include "VulkanBuffers.h"
+#include "UploadContext.h"
 #include "Core/Application.h"
 
 namespace VkLibrary {
@@ -20,19 +21,47 @@ namespace VkLibrary {
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		uint64_t expectedSize = m_Specification.Width * m_Specification.Height * m_Specification.Depth * GetImageFormatSize(m_Specification.Format);
-
 		VkFormat format = ImageFormatToVulkan(m_Specification.Format);
 		bool isDepthFormat = VkTools::IsDepthFormat(format);
 		bool isCube = m_Specification.Usage == ImageUsage::TEXTURE_CUBE || m_Specification.Usage == ImageUsage::STORAGE_IMAGE_CUBE;
+		bool isTexture = m_Specification.Usage == ImageUsage::TEXTURE_2D || m_Specification.Usage == ImageUsage::TEXTURE_CUBE;
+		bool isCompressed = IsCompressedFormat(m_Specification.Format);
 		uint32_t layerCount = isCube ? 6 : m_Specification.LayerCount;
 		VkImageAspectFlags aspectFlag = isDepthFormat ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
 
+		uint32_t fullMipLevels = m_Specification.Depth > 1 ? 1 : GetMipLevelCount(m_Width, m_Height);
+		m_MipLevels = m_Specification.MipLevels ? std::min(m_Specification.MipLevels, fullMipLevels) : fullMipLevels;
+
+		// Compressed levels come from the buffer, only create the ones it contains
+		if (isTexture && isCompressed && m_Buffer)
+		{
+			uint32_t levelsInBuffer = 0;
+			uint64_t offset = 0;
+			while (levelsInBuffer < m_MipLevels)
+			{
+				uint64_t levelSize = GetImageSize(m_Specification.Format, std::max(m_Width >> levelsInBuffer, 1u), std::max(m_Height >> levelsInBuffer, 1u)) * layerCount;
+				if (offset + levelSize > m_Buffer.Size)
+					break;
+
+				offset += levelSize;
+				levelsInBuffer++;
+			}
+
+			ASSERT(levelsInBuffer > 0, "Buffer is smaller than the first level");
+			if (levelsInBuffer < m_MipLevels)
+				LOG_WARN("{0}: buffer only contains {1} of {2} mip levels", m_Specification.DebugName, levelsInBuffer, m_MipLevels);
+
+			m_MipLevels = levelsInBuffer;
+		}
+
+		bool generateMips = isTexture && !isCompressed && m_Buffer && m_MipLevels > 1;
+		uint64_t expectedSize = GetImageSize(m_Specification.Format, m_Width, m_Height, m_MipLevels) * layerCount * m_Specification.Depth;
+
 		VkImageCreateInfo imageCreateInfo = {};
 		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageCreateInfo.imageType = m_Specification.Depth > 1 ? VK_IMAGE_TYPE_3D : VK_IMAGE_TYPE_2D;
 		imageCreateInfo.format = format;
-		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.mipLevels = m_MipLevels;
 		imageCreateInfo.arrayLayers = layerCount;
 		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -52,6 +81,10 @@ namespace VkLibrary {
 		else if (m_Specification.Usage == ImageUsage::TEXTURE_2D || m_Specification.Usage == ImageUsage::TEXTURE_CUBE)
 		{
 			imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+			// Each level is blitted from the one above it
+			if (generateMips)
+				imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 		}
 
 		if (isCube)
@@ -72,82 +105,90 @@ namespace VkLibrary {
 
 		m_DescriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		if ((m_Specification.Usage == ImageUsage::TEXTURE_2D || m_Specification.Usage == ImageUsage::TEXTURE_CUBE) && m_Buffer)
-		{
-			StagingBuffer stagingBuffer(m_Buffer.Data, m_Buffer.Size, m_Specification.DebugName + ", Staging Buffer");
-			VkCommandBuffer commandBuffer = device->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+		m_SubresourceRange.aspectMask = aspectFlag;
+		m_SubresourceRange.baseMipLevel = 0;
+		m_SubresourceRange.levelCount = m_MipLevels;
+		m_SubresourceRange.baseArrayLayer = 0;
+		m_SubresourceRange.layerCount = layerCount;
 
-			VkImageSubresourceRange range;
-			range.aspectMask = aspectFlag;
-			range.baseMipLevel = 0;
-			range.levelCount = 1;
-			range.baseArrayLayer = 0;
-			range.layerCount = layerCount;
+		if (isTexture && m_Buffer)
+		{
+			UploadBatch batch = UploadContext::Begin();
+			VkBuffer stagingBuffer = UploadContext::Stage(batch, m_Buffer.Data, m_Buffer.Size, m_Specification.DebugName + ", Staging Buffer");
 
 			// Transfer image from undefined layout to transfer destination optimal layout
-			VkTools::InsertImageMemoryBarrier(
-				commandBuffer,
-				m_ImageInfo.Image,
-				0,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				range);
-
-			VkBufferImageCopy copyRegion = {};
-			copyRegion.bufferOffset = 0;
-			copyRegion.bufferRowLength = 0;
-			copyRegion.bufferImageHeight = 0;
-			copyRegion.imageSubresource.aspectMask = aspectFlag;
-			copyRegion.imageSubresource.mipLevel = 0;
-			copyRegion.imageSubresource.baseArrayLayer = 0;
-			copyRegion.imageSubresource.layerCount = layerCount;
-			copyRegion.imageExtent = { m_Width, m_Height, m_Specification.Depth };
+			// Recorded on the upload queue, the tracked state only describes the graphics queue
+			BarrierBatch barriers;
+			barriers.AddImageBarrier(m_ImageInfo.Image, m_SubresourceRange, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_PIPELINE_STAGE_2_COPY_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR);
+			barriers.Flush(batch.CommandBuffer);
+
+			// Compressed buffers hold every level, uncompressed ones only the first
+			std::vector<VkBufferImageCopy> copyRegions(isCompressed ? m_MipLevels : 1);
+			VkDeviceSize bufferOffset = 0;
+			for (uint32_t level = 0; level < copyRegions.size(); level++)
+			{
+				uint32_t levelWidth = std::max(m_Width >> level, 1u);
+				uint32_t levelHeight = std::max(m_Height >> level, 1u);
+
+				VkBufferImageCopy& copyRegion = copyRegions[level];
+				copyRegion.bufferOffset = bufferOffset;
+				copyRegion.bufferRowLength = 0;
+				copyRegion.bufferImageHeight = 0;
+				copyRegion.imageSubresource.aspectMask = aspectFlag;
+				copyRegion.imageSubresource.mipLevel = level;
+				copyRegion.imageSubresource.baseArrayLayer = 0;
+				copyRegion.imageSubresource.layerCount = layerCount;
+				copyRegion.imageExtent = { levelWidth, levelHeight, m_Specification.Depth };
+
+				bufferOffset += GetImageSize(m_Specification.Format, levelWidth, levelHeight) * layerCount;
+			}
 
 			// Copy staging buffer to image on the GPU
-			vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.GetBuffer(), m_ImageInfo.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
-
-			// Transfer image from transfer destination optimal layout to shader read optimal layout
-			VkTools::InsertImageMemoryBarrier(
-				commandBuffer,
-				m_ImageInfo.Image,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_ACCESS_SHADER_READ_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-				range);
-
-			device->FlushCommandBuffer(commandBuffer, true);
+			vkCmdCopyBufferToImage(batch.CommandBuffer, stagingBuffer, m_ImageInfo.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copyRegions.size(), copyRegions.data());
+
+			if (generateMips)
+			{
+				// Blits need a graphics queue, hand the image over in transfer layout and generate the levels in the immediate batch
+				// The acquire is submitted before the immediate batch, so the blits see the first level
+				UploadContext::ReleaseImage(
+					batch,
+					m_ImageInfo.Image,
+					m_SubresourceRange,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+				UploadContext::Submit(batch);
+
+				GenerateMips(device->GetImmediateContext().GetCommandBuffer());
+			}
+			else
+			{
+				// Hand the image to the graphics queue in shader read optimal layout, textures are sampled by raster, compute and ray tracing shaders
+				UploadContext::ReleaseImage(
+					batch,
+					m_ImageInfo.Image,
+					m_SubresourceRange,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_ACCESS_SHADER_READ_BIT,
+					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+
+				UploadContext::Submit(batch);
+			}
+
+			// Upload semaphores order the acquire before any use on the graphics queue
+			m_State.Layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		}
 		else if (m_Specification.Usage == ImageUsage::STORAGE_IMAGE_2D || m_Specification.Usage == ImageUsage::STORAGE_IMAGE_CUBE)
 		{
-			VkCommandBuffer commandBuffer = device->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-			VkImageSubresourceRange range;
-			range.aspectMask = aspectFlag;
-			range.baseMipLevel = 0;
-			range.levelCount = 1;
-			range.baseArrayLayer = 0;
-			range.layerCount = layerCount;
-
-			// Transfer image from undefined layout to general layout
-			VkTools::InsertImageMemoryBarrier(
-				commandBuffer,
-				m_ImageInfo.Image,
-				0,
-				VK_ACCESS_SHADER_WRITE_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_GENERAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
-				range);
-
-			// Submit and free command buffer
-			device->FlushCommandBuffer(commandBuffer, true);
+			// Transfer image from undefined layout to general layout, recorded into the immediate batch that rendering waits on
+			BarrierBatch barriers;
+			barriers.TransitionImage(*this, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+				VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+			barriers.Flush(device->GetImmediateContext().GetCommandBuffer());
 
 			m_DescriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 		}
@@ -162,10 +203,11 @@ namespace VkLibrary {
 		imageViewCreateInfo.viewType = isCube ? VK_IMAGE_VIEW_TYPE_CUBE : (m_Specification.Depth > 1 ? VK_IMAGE_VIEW_TYPE_3D : VK_IMAGE_VIEW_TYPE_2D);
 		imageViewCreateInfo.format = format;
 		imageViewCreateInfo.flags = 0;
+		imageViewCreateInfo.components = m_Specification.Swizzle;
 		imageViewCreateInfo.subresourceRange = {};
 		imageViewCreateInfo.subresourceRange.aspectMask = aspectFlag;
 		imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
-		imageViewCreateInfo.subresourceRange.levelCount = 1;
+		imageViewCreateInfo.subresourceRange.levelCount = m_MipLevels;
 		imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
 		imageViewCreateInfo.subresourceRange.layerCount = layerCount;
 		imageViewCreateInfo.image = m_ImageInfo.Image;
@@ -183,7 +225,7 @@ namespace VkLibrary {
 		samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 		samplerCreateInfo.mipLodBias = 0.0f;
 		samplerCreateInfo.minLod = 0.0f;
-		samplerCreateInfo.maxLod = 20.0f;
+		samplerCreateInfo.maxLod = (float)m_MipLevels;
 		samplerCreateInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_WHITE;
 
 		VK_CHECK_RESULT(vkCreateSampler(device->GetLogicalDevice(), &samplerCreateInfo, nullptr, &m_ImageInfo.Sampler));
@@ -193,21 +235,76 @@ namespace VkLibrary {
 		m_DescriptorImageInfo.sampler = m_ImageInfo.Sampler;
 	}
 
-	void Image::Release()
+	void Image::GenerateMips(VkCommandBuffer commandBuffer)
 	{
-		VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		VkFormat format = ImageFormatToVulkan(m_Specification.Format);
+
+		// Every format this is used with supports blits, linear filtering is optional for some of them
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(device->GetPhysicalDevice(), format, &formatProperties);
+		VkFilter filter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+		VkImageSubresourceRange levelRange = m_SubresourceRange;
+		levelRange.levelCount = 1;
+
+		BarrierBatch barriers;
+		for (uint32_t level = 1; level < m_MipLevels; level++)
+		{
+			// Previous level was written by the copy or the last blit, it is only read from now on
+			levelRange.baseMipLevel = level - 1;
+			barriers.AddImageBarrier(m_ImageInfo.Image, levelRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR);
+			barriers.Flush(commandBuffer);
+
+			VkImageBlit blit = {};
+			blit.srcSubresource.aspectMask = m_SubresourceRange.aspectMask;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = m_SubresourceRange.layerCount;
+			blit.srcOffsets[1] = { (int32_t)std::max(m_Width >> (level - 1), 1u), (int32_t)std::max(m_Height >> (level - 1), 1u), 1 };
+			blit.dstSubresource = blit.srcSubresource;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstOffsets[1] = { (int32_t)std::max(m_Width >> level, 1u), (int32_t)std::max(m_Height >> level, 1u), 1 };
+
+			vkCmdBlitImage(commandBuffer, m_ImageInfo.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ImageInfo.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit);
+		}
 
+		// All levels but the last were read by blits, the last one was written by the final blit
+		VkPipelineStageFlags2KHR shaderStages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR;
+
+		levelRange.baseMipLevel = 0;
+		levelRange.levelCount = m_MipLevels - 1;
+		barriers.AddImageBarrier(m_ImageInfo.Image, levelRange, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_NONE_KHR, shaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+
+		levelRange.baseMipLevel = m_MipLevels - 1;
+		levelRange.levelCount = 1;
+		barriers.AddImageBarrier(m_ImageInfo.Image, levelRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_2_BLIT_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, shaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR);
+		barriers.Flush(commandBuffer);
+	}
+
+	void Image::Release()
+	{
 		if (!m_ImageInfo.Image)
 			return;
 
-		VulkanAllocator allocator(m_Specification.DebugName);
-		allocator.DestroyImage(m_ImageInfo.Image, m_ImageInfo.MemoryAllocation);
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		vkDestroyImageView(device, m_ImageInfo.ImageView, nullptr);
-		vkDestroySampler(device, m_ImageInfo.Sampler, nullptr);
+		// Frames in flight may still sample or render to the image
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), imageInfo = m_ImageInfo, debugName = m_Specification.DebugName]()
+		{
+			VulkanAllocator allocator(debugName);
+			allocator.DestroyImage(imageInfo.Image, imageInfo.MemoryAllocation);
+
+			vkDestroyImageView(device, imageInfo.ImageView, nullptr);
+			vkDestroySampler(device, imageInfo.Sampler, nullptr);
+		});
 
 		m_ImageInfo.Image = nullptr;
 		m_ImageInfo.MemoryAllocation = nullptr;
+		m_State = {};
 		m_ImageInfo.ImageView = nullptr;
 		m_ImageInfo.Sampler = nullptr;
 	}
@@ -231,9 +328,14 @@ namespace VkLibrary {
 		{
 		case ImageFormat::RGBA8:		    return 4;
 		case ImageFormat::SRGBA8:		    return 4;
-		case ImageFormat::BC7_SRGB:			return 4;
+		case ImageFormat::BC7_SRGB:			return 16;
 		case ImageFormat::RGBA32F:			return 16;
 		case ImageFormat::DEPTH24_STENCIL8: return 4;
+		case ImageFormat::BC7_UNORM:		return 16;
+		case ImageFormat::BC1_SRGB:			return 8;
+		case ImageFormat::BC1_UNORM:		return 8;
+		case ImageFormat::BC4_UNORM:		return 8;
+		case ImageFormat::BC5_UNORM:		return 16;
 		}
 
 		ASSERT(false, "Unknown Type");
@@ -249,10 +351,58 @@ namespace VkLibrary {
 		case ImageFormat::BC7_SRGB:			return VK_FORMAT_BC7_SRGB_BLOCK;
 		case ImageFormat::RGBA32F:			return VK_FORMAT_R32G32B32A32_SFLOAT;
 		case ImageFormat::DEPTH24_STENCIL8: return VK_FORMAT_D24_UNORM_S8_UINT;
+		case ImageFormat::BC7_UNORM:		return VK_FORMAT_BC7_UNORM_BLOCK;
+		case ImageFormat::BC1_SRGB:			return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		case ImageFormat::BC1_UNORM:		return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case ImageFormat::BC4_UNORM:		return VK_FORMAT_BC4_UNORM_BLOCK;
+		case ImageFormat::BC5_UNORM:		return VK_FORMAT_BC5_UNORM_BLOCK;
 		}
 
 		ASSERT(false, "Unknown Type");
 		return (VkFormat)0;
 	};
 
+	bool Image::IsCompressedFormat(ImageFormat format)
+	{
+		switch (format)
+		{
+		case ImageFormat::BC7_SRGB:
+		case ImageFormat::BC7_UNORM:
+		case ImageFormat::BC1_SRGB:
+		case ImageFormat::BC1_UNORM:
+		case ImageFormat::BC4_UNORM:
+		case ImageFormat::BC5_UNORM:
+			return true;
+		}
+
+		return false;
+	}
+
+	uint32_t Image::GetMipLevelCount(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		while ((std::max(width, height) >> levels) > 0)
+			levels++;
+
+		return levels;
+	}
+
+	uint64_t Image::GetImageSize(ImageFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		uint64_t size = 0;
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			uint64_t levelWidth = std::max(width >> level, 1u);
+			uint64_t levelHeight = std::max(height >> level, 1u);
+
+			// Block compressed levels are padded to whole 4x4 blocks
+			if (IsCompressedFormat(format))
+				size += ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * GetImageFormatSize(format);
+			else
+				size += levelWidth * levelHeight * GetImageFormatSize(format);
+		}
+
+		return size;
+	}
+
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Memory/Buffer.h"
 #include "VulkanTools.h"
 #include "VulkanAllocator.h"
+#include "BarrierBatch.h"
 
 namespace VkLibrary {
 
@@ -10,9 +11,11 @@ namespace VkLibrary {
 		NONE = -1, FRAMEBUFFER_ATTACHMENT, TEXTURE_2D, TEXTURE_CUBE, STORAGE_IMAGE_2D, STORAGE_IMAGE_CUBE
 	};
 
+	// Values are stored in texture files, new formats go to the end
 	enum class ImageFormat
 	{
-		NONE = -1, RGBA8, SRGBA8, BC7_SRGB, RGBA32F, DEPTH24_STENCIL8
+		NONE = -1, RGBA8, SRGBA8, BC7_SRGB, RGBA32F, DEPTH24_STENCIL8,
+		BC7_UNORM, BC1_SRGB, BC1_UNORM, BC4_UNORM, BC5_UNORM
 	};
 
 	struct ImageInfo
@@ -31,10 +34,18 @@ namespace VkLibrary {
 		uint32_t LayerCount = 1;
 		ImageFormat Format = ImageFormat::NONE;
 		ImageUsage Usage = ImageUsage::NONE;
+
+		// 0 creates the full chain down to 1x1, only 2D and cube images have more than one level
+		// Uncompressed textures only upload the first level and generate the rest with blits,
+		// compressed textures expect every level in the buffer, one after another from the largest
+		uint32_t MipLevels = 1;
+
+		// Applied by the view, e.g. to sample one and two channel formats in the channels shaders expect
+		VkComponentMapping Swizzle = {};
+
 		std::string DebugName = "Image";
 	};
 
-	// TODO: Add support for resource deletion queue in Release()
 	// TODO: Move Data into constructor
 	// TODO: Make Data into buffer
 
@@ -51,25 +62,44 @@ namespace VkLibrary {
 		uint32_t GetWidth() const { return m_Width; }
 		uint32_t GetHeight() const { return m_Height; }
 		uint32_t GetSize() const { return m_Size; }
+		uint32_t GetMipLevels() const { return m_MipLevels; }
 
+		inline VkImage GetImage() const { return m_ImageInfo.Image; }
 		inline Buffer GetBuffer() const { return m_Buffer; }
+		// Bytes per pixel, or per 4x4 block for compressed formats
 		static uint32_t GetImageFormatSize(ImageFormat format);
 		static VkFormat ImageFormatToVulkan(ImageFormat format);
+		static bool IsCompressedFormat(ImageFormat format);
+
+		// Levels of a full chain down to 1x1
+		static uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+		// Bytes of the first mipLevels levels of one layer, compressed formats are rounded up to whole blocks
+		static uint64_t GetImageSize(ImageFormat format, uint32_t width, uint32_t height, uint32_t mipLevels = 1);
 		
 		inline const VkDescriptorImageInfo& GetDescriptorImageInfo() const { return m_DescriptorImageInfo; }
 		inline const ImageSpecification& GetSpecification() const { return m_Specification; }
+		inline const VkImageSubresourceRange& GetSubresourceRange() const { return m_SubresourceRange; }
+
+		// Layout and last access in recording order, kept up to date by BarrierBatch::TransitionImage
+		// Render passes change the layout on their own, attachments are not tracked across them
+		inline ResourceState& GetState() { return m_State; }
+		inline VkImageLayout GetLayout() const { return m_State.Layout; }
 
 	private:
 		void Init();
+		void GenerateMips(VkCommandBuffer commandBuffer);
 
 	private:
 		uint32_t m_Width = 0;
 		uint32_t m_Height = 0;
 		uint32_t m_Size = 0;
+		uint32_t m_MipLevels = 1;
 		Buffer m_Buffer;
 
 		ImageInfo m_ImageInfo;
 		VkDescriptorImageInfo m_DescriptorImageInfo;
+		VkImageSubresourceRange m_SubresourceRange = {};
+		ResourceState m_State;
 
 		ImageSpecification m_Specification;
 	};
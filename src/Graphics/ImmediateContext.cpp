@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "ImmediateContext.h"
+#include "VulkanTools.h"
+
+namespace VkLibrary {
+
+	ImmediateContext::ImmediateContext(VkDevice device, VkQueue queue, uint32_t queueFamily, std::mutex& queueMutex)
+		: m_Device(device), m_Queue(queue), m_QueueMutex(queueMutex)
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+		VK_CHECK_RESULT(vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool));
+
+		VkSemaphoreTypeCreateInfo semaphoreTypeInfo{};
+		semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		semaphoreTypeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &semaphoreTypeInfo;
+		VK_CHECK_RESULT(vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_Semaphore));
+	}
+
+	ImmediateContext::~ImmediateContext()
+	{
+		WaitIdle();
+
+		vkDestroySemaphore(m_Device, m_Semaphore, nullptr);
+		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+	}
+
+	VkCommandBuffer ImmediateContext::GetCommandBuffer()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_OpenCommandBuffer)
+			return m_OpenCommandBuffer;
+
+		if (!m_FreeCommandBuffers.empty())
+		{
+			m_OpenCommandBuffer = m_FreeCommandBuffers.back();
+			m_FreeCommandBuffers.pop_back();
+		}
+		else
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_CommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(m_Device, &allocInfo, &m_OpenCommandBuffer));
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(m_OpenCommandBuffer, &beginInfo));
+
+		return m_OpenCommandBuffer;
+	}
+
+	uint64_t ImmediateContext::Submit()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return SubmitBatch();
+	}
+
+	uint64_t ImmediateContext::Submit(VkCommandBuffer commandBuffer)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Work recorded into the batch so far was recorded first, keep that order on the queue
+		SubmitBatch();
+		return SubmitCommandBuffer(commandBuffer);
+	}
+
+	bool ImmediateContext::IsComplete(uint64_t ticket)
+	{
+		return GetCompletedTicket() >= ticket;
+	}
+
+	void ImmediateContext::Wait(uint64_t ticket)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// Waiting on the open batch submits it
+			if (ticket > m_LastSubmittedTicket)
+				SubmitBatch();
+
+			ASSERT(ticket <= m_LastSubmittedTicket, "Waiting on a ticket that was never submitted");
+		}
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_Semaphore;
+		waitInfo.pValues = &ticket;
+		VK_CHECK_RESULT(vkWaitSemaphores(m_Device, &waitInfo, UINT64_MAX));
+	}
+
+	void ImmediateContext::WaitIdle()
+	{
+		uint64_t ticket = Submit();
+		Wait(ticket);
+		Update();
+	}
+
+	void ImmediateContext::Update()
+	{
+		uint64_t completedTicket = GetCompletedTicket();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		RecycleCommandBuffers(completedTicket);
+	}
+
+	uint64_t ImmediateContext::GetCompletedTicket()
+	{
+		uint64_t value = 0;
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(m_Device, m_Semaphore, &value));
+		return value;
+	}
+
+	uint64_t ImmediateContext::SubmitCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		uint64_t ticket = m_LastSubmittedTicket + 1;
+
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.signalSemaphoreValueCount = 1;
+		timelineSubmitInfo.pSignalSemaphoreValues = &ticket;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &m_Semaphore;
+
+		std::lock_guard<std::mutex> queueLock(m_QueueMutex);
+		VK_CHECK_RESULT(vkQueueSubmit(m_Queue, 1, &submitInfo, VK_NULL_HANDLE));
+
+		m_LastSubmittedTicket = ticket;
+		return ticket;
+	}
+
+	uint64_t ImmediateContext::SubmitBatch()
+	{
+		if (!m_OpenCommandBuffer)
+			return m_LastSubmittedTicket;
+
+		VK_CHECK_RESULT(vkEndCommandBuffer(m_OpenCommandBuffer));
+
+		uint64_t ticket = SubmitCommandBuffer(m_OpenCommandBuffer);
+		m_InFlightBatches.push_back({ ticket, m_OpenCommandBuffer });
+		m_OpenCommandBuffer = VK_NULL_HANDLE;
+
+		return ticket;
+	}
+
+	void ImmediateContext::RecycleCommandBuffers(uint64_t completedTicket)
+	{
+		while (!m_InFlightBatches.empty() && m_InFlightBatches.front().Ticket <= completedTicket)
+		{
+			VkCommandBuffer commandBuffer = m_InFlightBatches.front().CommandBuffer;
+			VK_CHECK_RESULT(vkResetCommandBuffer(commandBuffer, 0));
+
+			m_FreeCommandBuffers.push_back(commandBuffer);
+			m_InFlightBatches.pop_front();
+		}
+	}
+
+}
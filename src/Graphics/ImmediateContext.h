@@ -0,0 +1,69 @@
+#pragma once
+#include "pch.h"
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <mutex>
+
+namespace VkLibrary {
+
+	// NOTE: One shot GPU work (uploads, acceleration structure builds, texture conversions) is recorded into a shared batch
+	// Every submission signals the next value of a timeline semaphore, the value is the ticket to poll or wait on
+	// The frame waits on the last submitted ticket, so work that is only consumed by rendering never has to be waited on by the CPU
+
+	class ImmediateContext
+	{
+	public:
+		ImmediateContext(VkDevice device, VkQueue queue, uint32_t queueFamily, std::mutex& queueMutex);
+		~ImmediateContext();
+
+		ImmediateContext(const ImmediateContext&) = delete;
+		ImmediateContext& operator=(const ImmediateContext&) = delete;
+
+	public:
+		// Command buffer of the open batch, recorded work goes out with the next Submit
+		VkCommandBuffer GetCommandBuffer();
+
+		// Submits the open batch, returns the last submitted ticket when nothing was recorded
+		uint64_t Submit();
+
+		// Submits an ended command buffer after the open batch, the caller keeps ownership of it
+		uint64_t Submit(VkCommandBuffer commandBuffer);
+
+		bool IsComplete(uint64_t ticket);
+		void Wait(uint64_t ticket);
+		void WaitIdle();
+
+		// Frees command buffers of finished batches, called once per frame
+		void Update();
+
+		uint64_t GetCompletedTicket();
+		inline uint64_t GetLastSubmittedTicket() const { return m_LastSubmittedTicket; }
+		inline VkSemaphore GetSemaphore() const { return m_Semaphore; }
+
+	private:
+		uint64_t SubmitCommandBuffer(VkCommandBuffer commandBuffer);
+		uint64_t SubmitBatch();
+		void RecycleCommandBuffers(uint64_t completedTicket);
+
+	private:
+		struct InFlightBatch
+		{
+			uint64_t Ticket = 0;
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		};
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VkQueue m_Queue = VK_NULL_HANDLE;
+		std::mutex& m_QueueMutex;
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkSemaphore m_Semaphore = VK_NULL_HANDLE;
+
+		std::mutex m_Mutex;
+		VkCommandBuffer m_OpenCommandBuffer = VK_NULL_HANDLE;
+		std::deque<InFlightBatch> m_InFlightBatches;
+		std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+
+		uint64_t m_LastSubmittedTicket = 0;
+	};
+
+}
@@ -16,9 +16,27 @@ namespace VkLibrary {
 		const auto& bufferDescriptions = m_Shader->GetShaderBufferDescriptions();
 		const auto& resourceDescriptions = m_Shader->GetShaderResourceDescriptions();
 		const auto& pushConstantRanges = m_Shader->GetPushConstantRanges();
-		const auto& writeDescriptorSets = m_Shader->GetWriteDescriptorSets();
 
-		if (writeDescriptorSets.find(3) == writeDescriptorSets.end())
+		for (const auto& pushConstant : pushConstantRanges)
+		{
+			if (pushConstant.Name == "u_MaterialData")
+			{
+				m_PushConstantRangeDescription = pushConstant;
+				break;
+			}
+		}
+
+		// Material block is placed after other push constants, so the buffer starts at its first member
+		if (m_PushConstantRangeDescription.Size != -1 && !m_PushConstantRangeDescription.Members.empty())
+		{
+			m_BufferOffset = UINT32_MAX;
+			for (const auto& member : m_PushConstantRangeDescription.Members)
+				m_BufferOffset = std::min(m_BufferOffset, member.Offset);
+
+			m_Buffer.resize(m_PushConstantRangeDescription.Size - m_BufferOffset, 0);
+		}
+
+		if (bufferDescriptions.find(3) == bufferDescriptions.end() && resourceDescriptions.find(3) == resourceDescriptions.end())
 			return;
 
 		if (s_DefaultCubeMap == nullptr)
@@ -52,128 +70,115 @@ namespace VkLibrary {
 		}
 
 
-		int UniformBufferCount = 0;
-		int StorageBuffersCount = 0;
-		if (bufferDescriptions.find(3) != bufferDescriptions.end())
-		{
-			for (const auto& [binding, bufferDescriptions] : bufferDescriptions.at(3))
-			{
-				if (bufferDescriptions.Type == ShaderDescriptorType::UNIFORM_BUFFER)
-					UniformBufferCount++;
-				else if (bufferDescriptions.Type == ShaderDescriptorType::STORAGE_BUFFER)
-					StorageBuffersCount++;
+		// Packed update data holds one element per descriptor, array bindings take one element per array element
+		VkDescriptorSetLayout layout = m_Shader->GetDescriptorSetLayouts()[3];
+		DescriptorSetLayoutCache& layoutCache = device->GetDescriptorSetLayoutCache();
+		uint32_t elementCount = layoutCache.GetUpdateDataCount(layout);
 
-				m_WriteDescriptorSets[bufferDescriptions.Name] = m_Shader->FindWriteDescriptorSet(bufferDescriptions.Name);
-			}
-		}
+		m_DescriptorData.resize(elementCount, DescriptorUpdateData{});
+		m_ImageInfos.resize(elementCount, nullptr);
 
-		int SampledImagesCount = 0;
-		int StorageImagesCount = 0;
+		// Bind default textures until the material sets its own
 		if (resourceDescriptions.find(3) != resourceDescriptions.end())
 		{
-			for (const auto& [binding, resourceDescriptions] : resourceDescriptions.at(3))
+			for (const auto& [binding, resourceDescription] : resourceDescriptions.at(3))
 			{
-				if (resourceDescriptions.Type == ShaderDescriptorType::TEXTURE_2D || resourceDescriptions.Type == ShaderDescriptorType::TEXTURE_CUBE)
-					SampledImagesCount++;
-				else if (resourceDescriptions.Type == ShaderDescriptorType::STORAGE_IMAGE_2D || resourceDescriptions.Type == ShaderDescriptorType::STORAGE_IMAGE_CUBE)
-					StorageImagesCount++;
-
-				m_WriteDescriptorSets[resourceDescriptions.Name] = m_Shader->FindWriteDescriptorSet(resourceDescriptions.Name);
-
-				if (resourceDescriptions.Type == ShaderDescriptorType::TEXTURE_2D || resourceDescriptions.Type == ShaderDescriptorType::STORAGE_IMAGE_2D)
-				{
-					m_WriteDescriptorSets[resourceDescriptions.Name].pImageInfo = &s_DefaultTexture->GetDescriptorImageInfo();
-				}
-				else if (resourceDescriptions.Type == ShaderDescriptorType::TEXTURE_CUBE || resourceDescriptions.Type == ShaderDescriptorType::STORAGE_IMAGE_CUBE)
-				{
-					m_WriteDescriptorSets[resourceDescriptions.Name].pImageInfo = &s_DefaultCubeMap->GetDescriptorImageInfo();
-				}
+				const VkDescriptorImageInfo* defaultImageInfo = nullptr;
+				if (resourceDescription.Type == ShaderDescriptorType::TEXTURE_2D || resourceDescription.Type == ShaderDescriptorType::STORAGE_IMAGE_2D)
+					defaultImageInfo = &s_DefaultTexture->GetDescriptorImageInfo();
+				else if (resourceDescription.Type == ShaderDescriptorType::TEXTURE_CUBE || resourceDescription.Type == ShaderDescriptorType::STORAGE_IMAGE_CUBE)
+					defaultImageInfo = &s_DefaultCubeMap->GetDescriptorImageInfo();
+
+				if (!defaultImageInfo)
+					continue;
+
+				uint32_t firstElement = layoutCache.GetUpdateDataElement(layout, binding);
+				for (uint32_t i = 0; i < resourceDescription.ArraySize; i++)
+					m_ImageInfos[firstElement + i] = defaultImageInfo;
 			}
 		}
 
-		std::vector<VkDescriptorPoolSize> poolSizes;
-		
-		if (UniformBufferCount > 0)
-		{
-			VkDescriptorPoolSize size = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, UniformBufferCount };
-			poolSizes.push_back(size);
-		}
-		if (StorageBuffersCount > 0)
-		{
-			VkDescriptorPoolSize size = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, StorageBuffersCount };
-			poolSizes.push_back(size);
-		}
-		if (SampledImagesCount > 0)
-		{
-			VkDescriptorPoolSize size = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SampledImagesCount };
-			poolSizes.push_back(size);
-		}
-		if (StorageImagesCount > 0)
-		{
-			VkDescriptorPoolSize size = { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, StorageImagesCount };
-			poolSizes.push_back(size);
-		}
+		m_DescriptorSet = device->GetDescriptorAllocator().Allocate(layout);
+		m_UpdateTemplate = m_Shader->GetDescriptorUpdateTemplate(3);
+	}
 
-		VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
-		descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		descriptorPoolCreateInfo.flags = 0;
-		descriptorPoolCreateInfo.maxSets = 1;
-		descriptorPoolCreateInfo.poolSizeCount = poolSizes.size();
-		descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+	Material::~Material()
+	{
+		if (!m_DescriptorSet)
+			return;
 
-		VK_CHECK_RESULT(vkCreateDescriptorPool(device->GetLogicalDevice(), &descriptorPoolCreateInfo, nullptr, &m_Pool));
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		device->GetDeletionQueue().Push([allocator = &device->GetDescriptorAllocator(), descriptorSet = m_DescriptorSet]()
+		{
+			allocator->Free(descriptorSet);
+		});
+	}
 
-		m_DescriptorSet = m_Shader->AllocateDescriptorSet(m_Pool, 3);
+	void Material::UpdateDescriptorSet()
+	{
+		if (m_DescriptorSet == VK_NULL_HANDLE)
+			return;
 
-		for (auto& [name, writeDescriptorSet] : m_WriteDescriptorSets)
+		for (uint32_t element = 0; element < m_ImageInfos.size(); element++)
 		{
-			writeDescriptorSet.dstSet = m_DescriptorSet;
+			if (m_ImageInfos[element])
+				m_DescriptorData[element].ImageInfo = *m_ImageInfos[element];
 		}
 
-		for (const auto& pushConstant : pushConstantRanges)
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		vkUpdateDescriptorSetWithTemplate(device->GetLogicalDevice(), m_DescriptorSet, m_UpdateTemplate, m_DescriptorData.data());
+	}
+
+	MaterialParameter Material::GetParameter(const std::string& name) const
+	{
+		for (const auto& member : m_PushConstantRangeDescription.Members)
 		{
-			if (pushConstant.Name == "u_MaterialData")
+			if (member.Name == name)
 			{
-				m_PushConstantRangeDescription = pushConstant;
-				break;
+				MaterialParameter parameter;
+				parameter.Offset = member.Offset - m_BufferOffset;
+				parameter.Size = member.Size;
+				parameter.Type = member.Type;
+				return parameter;
 			}
 		}
 
-		if (m_PushConstantRangeDescription.Size != -1)
-		{
-			m_Buffer = (uint8_t*)malloc(m_PushConstantRangeDescription.Size);
-			memset(m_Buffer, 0.0f, m_PushConstantRangeDescription.Size);
-		}
+		LOG_WARN("Material parameter {} not found in {}", name, m_Shader->GetPath().string());
+		return MaterialParameter();
 	}
 
-	Material::~Material()
+	void Material::PushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
 	{
+		if (m_Buffer.empty())
+			return;
+
+		vkCmdPushConstants(commandBuffer, pipelineLayout, m_PushConstantRangeDescription.ShaderStage, m_BufferOffset, (uint32_t)m_Buffer.size(), m_Buffer.data());
+		ClearDirty();
 	}
 
-	void Material::UpdateDescriptorSet()
+	void Material::PushDirtyConstants(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
 	{
-		std::vector<VkWriteDescriptorSet> writeDescriptors;
-		writeDescriptors.reserve(m_WriteDescriptorSets.size());
+		if (!IsDirty())
+			return;
 
-		for (auto& [name, writeDescriptorSet] : m_WriteDescriptorSets)
-		{
-			writeDescriptors.push_back(writeDescriptorSet);
-		}
+		// Push constant offsets and sizes have to be multiples of 4
+		uint32_t begin = m_DirtyBegin & ~3u;
+		uint32_t end = std::min((m_DirtyEnd + 3) & ~3u, (uint32_t)m_Buffer.size());
 
-		Ref<VulkanDevice> device = Application::GetVulkanDevice();
-		vkUpdateDescriptorSets(device->GetLogicalDevice(), writeDescriptors.size(), writeDescriptors.data(), 0, NULL);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, m_PushConstantRangeDescription.ShaderStage, m_BufferOffset + begin, end - begin, m_Buffer.data() + begin);
+		ClearDirty();
 	}
 
-	void Material::SetTexture(const std::string& name, Ref<Image>& image)
+	void Material::SetTexture(const std::string& name, Ref<Image>& image, uint32_t arrayIndex)
 	{
-		if (image->GetSpecification().Usage == ImageUsage::STORAGE_IMAGE_2D || image->GetSpecification().Usage == ImageUsage::TEXTURE_2D)
-		{
-			m_WriteDescriptorSets.at(name).pImageInfo = &image->GetDescriptorImageInfo();
-		}
-		else if (image->GetSpecification().Usage == ImageUsage::STORAGE_IMAGE_CUBE || image->GetSpecification().Usage == ImageUsage::TEXTURE_CUBE)
-		{
-			m_WriteDescriptorSets.at(name).pImageInfo = &image->GetDescriptorImageInfo();
-		}
+		const ShaderResourceDescription& resourceDescription = m_Shader->FindResourceDescription(name);
+		ASSERT(resourceDescription.Set == 3, "Materials can only set textures in set 3");
+		ASSERT(arrayIndex < resourceDescription.ArraySize, "Texture array index out of range");
+
+		DescriptorSetLayoutCache& layoutCache = Application::GetVulkanDevice()->GetDescriptorSetLayoutCache();
+		uint32_t element = layoutCache.GetUpdateDataElement(m_Shader->GetDescriptorSetLayouts()[3], resourceDescription.Binding) + arrayIndex;
+
+		m_ImageInfos[element] = &image->GetDescriptorImageInfo();
 	}
 
 }
\ No newline at end of file
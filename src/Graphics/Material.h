@@ -1,11 +1,47 @@
 #pragma once
 #include "Shader.h"
 #include "Texture.h"
+#include "DescriptorSetLayoutCache.h"
 #include <glm/glm.hpp>
 
 namespace VkLibrary {
 
+	// Resolved location of a material parameter in the push constant block
+	struct MaterialParameter
+	{
+		uint32_t Offset = 0; // Relative to the start of the material buffer
+		uint32_t Size = 0;
+		ShaderDescriptorType Type = ShaderDescriptorType::NONE;
+
+		inline bool IsValid() const { return Size != 0; }
+	};
+
+	namespace Utils {
+
+		template<typename T>
+		constexpr ShaderDescriptorType GetMaterialParameterType()
+		{
+			if constexpr (std::is_same_v<T, float>)			  return ShaderDescriptorType::FLOAT;
+			else if constexpr (std::is_same_v<T, glm::vec2>) return ShaderDescriptorType::FLOAT2;
+			else if constexpr (std::is_same_v<T, glm::vec3>) return ShaderDescriptorType::FLOAT3;
+			else if constexpr (std::is_same_v<T, glm::vec4>) return ShaderDescriptorType::FLOAT4;
+			else if constexpr (std::is_same_v<T, glm::mat4>) return ShaderDescriptorType::MAT4;
+			else if constexpr (std::is_same_v<T, int32_t>)	  return ShaderDescriptorType::INT;
+			else if constexpr (std::is_same_v<T, uint32_t>)	  return ShaderDescriptorType::UINT;
+			else return ShaderDescriptorType::NONE;
+		}
+
+		// Booleans are 32-bit in shaders and are written as uint32_t
+		template<typename T>
+		constexpr bool IsMaterialParameterCompatible(ShaderDescriptorType type)
+		{
+			return GetMaterialParameterType<T>() == type || (std::is_same_v<T, uint32_t> && type == ShaderDescriptorType::BOOL);
+		}
+
+	}
+
 	// TODO: Add prepare function to update descriptors
+	// NOTE: Resolve parameters once with GetParameter and keep the handle, setting by name searches the block every call
 	
 	class Material
 	{
@@ -16,34 +52,73 @@ namespace VkLibrary {
 	public:
 		void UpdateDescriptorSet();
 
-		void SetTexture(const std::string& name, Ref<Image>& image);
+		// Array index selects the element of a texture array binding
+		void SetTexture(const std::string& name, Ref<Image>& image, uint32_t arrayIndex = 0);
+
+		MaterialParameter GetParameter(const std::string& name) const;
+
+		template<typename T>
+		void Set(const MaterialParameter& parameter, const T& data)
+		{
+			ASSERT(parameter.IsValid(), "Invalid material parameter");
+			ASSERT(Utils::IsMaterialParameterCompatible<T>(parameter.Type) && sizeof(T) <= parameter.Size, "Material parameter type mismatch");
+
+			uint8_t* dst = m_Buffer.data() + parameter.Offset;
+			if (memcmp(dst, &data, sizeof(T)) == 0)
+				return;
+
+			memcpy(dst, &data, sizeof(T));
+
+			// Grow dirty range to include this parameter
+			m_DirtyBegin = std::min(m_DirtyBegin, parameter.Offset);
+			m_DirtyEnd = std::max(m_DirtyEnd, parameter.Offset + (uint32_t)sizeof(T));
+		}
+
+		void Set(const MaterialParameter& parameter, bool data) { Set<uint32_t>(parameter, data ? 1u : 0u); }
 
 		template<typename T>
 		void Set(const std::string& name, const T& data)
 		{
-			for (const auto& member : m_PushConstantRangeDescription.Members)
-			{
-				if (member.Name == name)
-				{
-					memcpy(m_Buffer + member.Offset - 64, &data, member.Size);
-					return;
-				}
-			}
-
-			return;
+			MaterialParameter parameter = GetParameter(name);
+			if (parameter.IsValid())
+				Set(parameter, data);
 		}
 
+		// Pushes the whole block, clears the dirty range
+		void PushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+
+		// Pushes only bytes changed since the last push, only valid if this material's constants are still current in the command buffer
+		void PushDirtyConstants(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+
+		inline bool IsDirty() const { return m_DirtyBegin < m_DirtyEnd; }
+		inline void ClearDirty() { m_DirtyBegin = UINT32_MAX; m_DirtyEnd = 0; }
+
+		// Dirty range relative to the start of the material buffer, for uploading to GPU buffers
+		inline uint32_t GetDirtyOffset() const { return IsDirty() ? m_DirtyBegin : 0; }
+		inline uint32_t GetDirtySize() const { return IsDirty() ? m_DirtyEnd - m_DirtyBegin : 0; }
+
 		inline const VkDescriptorSet& GetDescriptorSet() const { return m_DescriptorSet; }
 		inline const PushConstantRangeDescription& GetPushConstantRangeDescription() const { return m_PushConstantRangeDescription; }
-		inline const uint8_t* GetBuffer() const { return m_Buffer; }
+
+		// Buffer starts at the first member of the push constant block, not at push constant offset 0
+		inline const uint8_t* GetBuffer() const { return m_Buffer.data(); }
+		inline uint32_t GetBufferSize() const { return (uint32_t)m_Buffer.size(); }
+		inline uint32_t GetBufferOffset() const { return m_BufferOffset; }
 
 	private:
 		Ref<Shader> m_Shader;
-		uint8_t* m_Buffer;
 
-		VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+		std::vector<uint8_t> m_Buffer;
+		uint32_t m_BufferOffset = 0;
+		uint32_t m_DirtyBegin = UINT32_MAX;
+		uint32_t m_DirtyEnd = 0;
+
 		VkDescriptorSet m_DescriptorSet = VK_NULL_HANDLE;
-		std::unordered_map<std::string, VkWriteDescriptorSet> m_WriteDescriptorSets;
+		VkDescriptorUpdateTemplate m_UpdateTemplate = VK_NULL_HANDLE;
+
+		// Indexed by update data element, image infos are read when the set is updated so layout changes are picked up
+		std::vector<DescriptorUpdateData> m_DescriptorData;
+		std::vector<const VkDescriptorImageInfo*> m_ImageInfos;
 		PushConstantRangeDescription m_PushConstantRangeDescription;
 	};
 
@@ -35,8 +35,9 @@ namespace VkLibrary {
 		inline std::vector<MaterialData>& GetMaterialData() { return m_MeshSource->GetMaterialData(); };
 		inline const std::vector<Ref<Texture2D>>& GetTextures() const { return m_MeshSource->GetTextures(); }
 
-		inline Ref<VertexBuffer> GetVertexBuffer() const { return m_MeshSource->GetVertexBuffer(); }
-		inline Ref<IndexBuffer> GetIndexBuffer() const { return m_MeshSource->GetIndexBuffer(); }
+		inline const GeometryAllocation& GetGeometry() const { return m_MeshSource->GetGeometry(); }
+		inline VkBuffer GetVertexBuffer() const { return m_MeshSource->GetVertexBuffer(); }
+		inline VkBuffer GetIndexBuffer() const { return m_MeshSource->GetIndexBuffer(); }
 
 		int RayIntersection(Ray ray, const glm::mat4& transform) { return m_MeshSource->RayIntersection(ray, transform); };
 
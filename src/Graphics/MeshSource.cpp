@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "MeshSource.h"
+#include "ShaderLibrary.h"
 #include "Core/Core.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -12,6 +13,11 @@ namespace VkLibrary {
 		Init();
 	}
 
+	MeshSource::~MeshSource()
+	{
+		GeometryPool::Free(m_Geometry);
+	}
+
 	void MeshSource::Init()
 	{
 		tinygltf::TinyGLTF loader;
@@ -37,7 +43,7 @@ namespace VkLibrary {
 		ASSERT(warning.empty(), warning);
 		ASSERT(error.empty(), error);
 
-		m_DefaultShader = CreateRef<Shader>("assets/shaders/PBR.glsl");
+		m_DefaultShader = ShaderLibrary::Get("assets/shaders/PBR.glsl");
 
 		LOG_INFO("Loading vertex data...");
 		LoadVertexData();
@@ -50,8 +56,15 @@ namespace VkLibrary {
 			CalculateNodeTransforms(node, m_Model, glm::mat4(1.0f));
 		}
 
-		m_VertexBuffer = CreateRef<VertexBuffer>(m_Vertices.data(), sizeof(Vertex) * m_Vertices.size());
-		m_IndexBuffer = CreateRef<IndexBuffer>(m_Indices.data(), sizeof(uint32_t) * m_Indices.size(), m_Indices.size());
+		m_Geometry = GeometryPool::Allocate(m_Vertices.data(), (uint32_t)m_Vertices.size(), m_Indices.data(), (uint32_t)m_Indices.size());
+		ASSERT(m_Geometry.IsValid(), "Failed to allocate mesh geometry");
+
+		// Rebase submeshes onto the pool buffers
+		for (SubMesh& subMesh : m_SubMeshes)
+		{
+			subMesh.VertexOffset += m_Geometry.VertexOffset;
+			subMesh.IndexOffset += m_Geometry.IndexOffset;
+		}
 
 		LOG_INFO("Loading material data...");
 		LoadMaterialData();
@@ -264,6 +277,9 @@ namespace VkLibrary {
 			float emissiveStrength = 1.0f;
 			float useNormalMap = 0.0f;
 
+			// Textures load synchronously, materials and the ray tracing texture array keep the descriptor written at creation
+			// and would sample the placeholder of an async texture forever
+
 			// Albedo texture
 			uint32_t albedoTextureIndex = gltfMaterial.pbrMetallicRoughness.baseColorTexture.index;
 			if (albedoTextureIndex != -1)
@@ -294,6 +310,7 @@ namespace VkLibrary {
 				textureSpec.path = m_Path.parent_path() / image.uri;
 				textureSpec.DebugName = (m_Path.filename().string() + ", MetallicRoughness Texture");
 				textureSpec.compress = true;
+				textureSpec.Role = TextureRole::MetallicRoughness;
 
 				m_Textures.emplace_back(CreateRef<Texture2D>(textureSpec));
 
@@ -313,6 +330,7 @@ namespace VkLibrary {
 				textureSpec.path = m_Path.parent_path() / image.uri;
 				textureSpec.DebugName = (m_Path.filename().string() + ", Normal Texture");
 				textureSpec.compress = true;
+				textureSpec.Role = TextureRole::Normal;
 
 				m_Textures.emplace_back(CreateRef<Texture2D>(textureSpec));
 
@@ -5,6 +5,7 @@
 #include "VulkanBuffers.h"
 #include "Texture.h"
 #include "Material.h"
+#include "GeometryPool.h"
 #include <tinygltf/tiny_gltf.h>
 #include <glm/glm.hpp>
 #include <filesystem>
@@ -51,13 +52,11 @@ namespace VkLibrary {
 		int NormalMapIndex = -1;
 	};
 
-	// TODO: Pull m_DefaultShader from some shader libary instead of creating one for every mesh
-
 	class MeshSource
 	{
 	public:
 		MeshSource(const std::string_view path);
-		~MeshSource() = default;
+		~MeshSource();
 	public:
 		inline const std::vector<SubMesh>& GetSubMeshes() const { return m_SubMeshes; }
 		inline std::vector<SubMesh>& GetSubMeshes() { return m_SubMeshes; }
@@ -66,8 +65,10 @@ namespace VkLibrary {
 		inline std::vector<MaterialData>& GetMaterialData() { return m_MaterialBuffers; };
 		inline const std::vector<Ref<Texture2D>>& GetTextures() const { return m_Textures; }
 
-		inline Ref<VertexBuffer> GetVertexBuffer() const { return m_VertexBuffer; }
-		inline Ref<IndexBuffer> GetIndexBuffer() const { return m_IndexBuffer; }
+		// Geometry lives in the shared geometry pool, submesh offsets are relative to the pool buffers
+		inline const GeometryAllocation& GetGeometry() const { return m_Geometry; }
+		inline VkBuffer GetVertexBuffer() const { return GeometryPool::GetVertexBuffer(m_Geometry.Block); }
+		inline VkBuffer GetIndexBuffer() const { return GeometryPool::GetIndexBuffer(m_Geometry.Block); }
 
 		int RayIntersection(Ray ray, const glm::mat4& transform);
 
@@ -85,8 +86,7 @@ namespace VkLibrary {
 		std::vector<Vertex> m_Vertices;
 		std::vector<uint32_t> m_Indices;
 
-		Ref<VertexBuffer> m_VertexBuffer;
-		Ref<IndexBuffer> m_IndexBuffer;
+		GeometryAllocation m_Geometry;
 		
 		std::vector<Triangle> m_Triangles;
 		AABB m_BoundingBox;
@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "ParallelCommandRecorder.h"
+#include "CommandPoolRegistry.h"
+#include "VulkanTools.h"
+#include "Core/Application.h"
+
+namespace VkLibrary {
+
+	ParallelCommandRecorder::ParallelCommandRecorder(const CommandBufferInheritance& inheritance)
+		: m_Inheritance(inheritance)
+	{
+	}
+
+	ParallelCommandRecorder::~ParallelCommandRecorder()
+	{
+		// Recorded tasks may reference the caller's state, never let them outlive the recorder
+		Wait();
+	}
+
+	void ParallelCommandRecorder::Record(std::function<void(VkCommandBuffer)>&& task)
+	{
+		// Every task owns its slot, so the execution order follows the order of Record calls and workers never touch a shared vector
+		Ref<VkCommandBuffer> slot = CreateRef<VkCommandBuffer>(VK_NULL_HANDLE);
+
+		CommandBufferInheritance inheritance = m_Inheritance;
+		std::future<void> future = Application::GetThreadPool().Submit([slot, inheritance, task = std::move(task)]()
+		{
+			// Allocated on the worker so it comes from that thread's pool
+			VkCommandBuffer commandBuffer = CommandPoolRegistry::AllocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+			VkCommandBufferInheritanceInfo inheritanceInfo{};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = inheritance.RenderPass;
+			inheritanceInfo.subpass = inheritance.Subpass;
+			inheritanceInfo.framebuffer = inheritance.Framebuffer;
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			if (inheritance.RenderPass)
+				beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+			VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+			task(commandBuffer);
+			VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
+
+			*slot = commandBuffer;
+		});
+
+		m_Tasks.push_back({ slot, std::move(future) });
+	}
+
+	void ParallelCommandRecorder::Execute(VkCommandBuffer primaryCommandBuffer)
+	{
+		std::vector<VkCommandBuffer> commandBuffers = Wait();
+
+		if (!commandBuffers.empty())
+			vkCmdExecuteCommands(primaryCommandBuffer, (uint32_t)commandBuffers.size(), commandBuffers.data());
+	}
+
+	std::vector<VkCommandBuffer> ParallelCommandRecorder::Wait()
+	{
+		std::vector<VkCommandBuffer> commandBuffers;
+		commandBuffers.reserve(m_Tasks.size());
+
+		// The slot is only read after get, which orders it after the worker's write
+		for (RecordTask& task : m_Tasks)
+		{
+			task.Future.get();
+			commandBuffers.push_back(*task.CommandBuffer);
+		}
+
+		m_Tasks.clear();
+		return commandBuffers;
+	}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Core/Core.h"
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <future>
+
+namespace VkLibrary {
+
+	// Render pass state the secondary command buffers continue, leave RenderPass empty to record outside a render pass
+	struct CommandBufferInheritance
+	{
+		VkRenderPass RenderPass = VK_NULL_HANDLE;
+		uint32_t Subpass = 0;
+		VkFramebuffer Framebuffer = VK_NULL_HANDLE;
+	};
+
+	// NOTE: Every Record call records one secondary command buffer on a worker thread of the application thread pool
+	// Execute waits for all of them and executes them in the order Record was called, independent of which finished first
+	// Inside a render pass the primary has to begin it with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+	// Dynamic state such as viewport and scissor is not inherited and has to be set in every task
+
+	class ParallelCommandRecorder
+	{
+	public:
+		ParallelCommandRecorder(const CommandBufferInheritance& inheritance = CommandBufferInheritance());
+		~ParallelCommandRecorder();
+
+		ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+		ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+	public:
+		void Record(std::function<void(VkCommandBuffer)>&& task);
+
+		void Execute(VkCommandBuffer primaryCommandBuffer);
+
+	private:
+		// Returns the recorded command buffers in the order of the Record calls
+		std::vector<VkCommandBuffer> Wait();
+
+	private:
+		struct RecordTask
+		{
+			// Written only by the worker, read once the future is ready
+			Ref<VkCommandBuffer> CommandBuffer;
+			std::future<void> Future;
+		};
+
+		CommandBufferInheritance m_Inheritance;
+
+		std::vector<RecordTask> m_Tasks;
+	};
+
+}
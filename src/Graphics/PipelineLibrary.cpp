@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "PipelineLibrary.h"
+#include <mutex>
+
+namespace VkLibrary {
+
+	struct PipelineLibraryData
+	{
+		std::mutex Mutex;
+		std::unordered_map<uint64_t, Ref<ComputePipeline>> ComputePipelines;
+	};
+
+	static PipelineLibraryData* s_Data = nullptr;
+
+	void PipelineLibrary::Init()
+	{
+		s_Data = new PipelineLibraryData();
+	}
+
+	void PipelineLibrary::Shutdown()
+	{
+		s_Data->ComputePipelines.clear();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	Ref<ComputePipeline> PipelineLibrary::GetComputePipeline(const ComputePipelineSpecification& specification)
+	{
+		const uint64_t key = GetComputePipelineKey(specification);
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		auto it = s_Data->ComputePipelines.find(key);
+		if (it != s_Data->ComputePipelines.end())
+			return it->second;
+
+		Ref<ComputePipeline> pipeline = CreateRef<ComputePipeline>(specification);
+		s_Data->ComputePipelines[key] = pipeline;
+		return pipeline;
+	}
+
+	uint64_t PipelineLibrary::GetComputePipelineKey(const ComputePipelineSpecification& specification)
+	{
+		ASSERT(specification.Shader, "Compute pipeline has no shader");
+
+		// Boost style hash combine, the inputs are already well distributed
+		uint64_t key = specification.Shader->GetHash();
+		key ^= specification.SpecializationConstants.GetHash() + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+		key ^= (uint64_t)specification.PipelineLayout + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+		return key;
+	}
+
+}
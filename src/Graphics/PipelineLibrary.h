@@ -0,0 +1,22 @@
+#pragma once
+#include "Core/Core.h"
+#include "ComputePipeline.h"
+
+namespace VkLibrary {
+
+	// NOTE: Compute pipelines are keyed by the shader's SPIR-V hash, the hash of the specialization constants and the pipeline layout
+	// A compute pipeline is fully described by those, graphics and ray tracing pipelines also depend on render state and are created directly
+	// Pipelines are created through the device pipeline cache, which is saved on shutdown, so a restart skips the driver compile as well
+
+	class PipelineLibrary
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+
+		static Ref<ComputePipeline> GetComputePipeline(const ComputePipelineSpecification& specification);
+
+		static uint64_t GetComputePipelineKey(const ComputePipelineSpecification& specification);
+	};
+
+}
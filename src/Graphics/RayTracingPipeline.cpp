@@ -51,6 +51,17 @@ namespace VkLibrary {
 
 	RayTracingPipeline::~RayTracingPipeline()
 	{
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), pipeline = m_Pipeline, pipelineLayout = m_PipelineLayout, shaderBindingTable = m_ShaderBindingTable]()
+		{
+			VulkanAllocator allocator("RayTracingPipeline");
+			for (const RTBufferInfo& bufferInfo : shaderBindingTable)
+				allocator.DestroyBuffer(bufferInfo.Buffer, bufferInfo.Memory);
+
+			vkDestroyPipeline(device, pipeline, nullptr);
+			vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		});
 	}
 
 	void RayTracingPipeline::Init()
@@ -59,7 +70,7 @@ namespace VkLibrary {
 
 		const uint32_t MaxStorageBufferDescriptorCount = 2048;
 
-		std::array<VkDescriptorSetLayoutBinding, 12> layoutBindings = {
+		std::vector<VkDescriptorSetLayoutBinding> layoutBindings = {
 			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, 0),
 			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR, 1),
 			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR, 2),
@@ -74,7 +85,7 @@ namespace VkLibrary {
 			VkTools::DescriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_RAYGEN_BIT_KHR, 11),
 		};
 
-		std::array<VkDescriptorBindingFlags, layoutBindings.size()> bindingFlags =
+		std::vector<VkDescriptorBindingFlags> bindingFlags =
 		{
 			0,											// Binding 0:  Acceleration Structure
 			0,											// Binding 1:  Storage Image
@@ -85,23 +96,15 @@ namespace VkLibrary {
 			0,											// Binding 6:  Submesh Data
 			0,											// Binding 7:  Scene Buffer
 			0,											// Binding 8:  Material Buffer
-			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,	// Binding 9:  Textures
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,	// Binding 9:  Textures, AccelerationStructure::GetTextures
 			0,											// Binding 10: Skybox
 			0,											// Binding 11: Noise Texture
 		};
 
-		VkDescriptorSetLayoutBindingFlagsCreateInfo descriptorSetLayoutBindingsCreateInfo{};
-		descriptorSetLayoutBindingsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-		descriptorSetLayoutBindingsCreateInfo.pBindingFlags = bindingFlags.data();
-		descriptorSetLayoutBindingsCreateInfo.bindingCount = (uint32_t)bindingFlags.size();
-		
-		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
-		descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		descriptorSetLayoutCreateInfo.pNext = &descriptorSetLayoutBindingsCreateInfo;
-		descriptorSetLayoutCreateInfo.pBindings = layoutBindings.data();
-		descriptorSetLayoutCreateInfo.bindingCount = (uint32_t)layoutBindings.size();
-		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, nullptr, &m_DescriptorSetLayout));
+		DescriptorSetLayoutCache& layoutCache = Application::GetVulkanDevice()->GetDescriptorSetLayoutCache();
+		m_DescriptorSetLayout = layoutCache.GetLayout(layoutBindings, bindingFlags);
 
+		// Textures are read through binding 9, the pipeline does not use the bindless heap
 		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
 		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutCreateInfo.setLayoutCount = 1;
@@ -110,11 +113,12 @@ namespace VkLibrary {
 
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
 		std::vector<VkRayTracingShaderGroupCreateInfoKHR> shaderGroups;
+		SpecializationData specializationData[3];
 
 		if (m_Specification.RayGenShader)
 		{
-			const VkPipelineShaderStageCreateInfo& shaderStage = m_Specification.RayGenShader->GetShaderCreateInfo()[0];
-			shaderStages.emplace_back(shaderStage);
+			VkPipelineShaderStageCreateInfo& shaderStage = shaderStages.emplace_back(m_Specification.RayGenShader->GetShaderCreateInfo()[0]);
+			shaderStage.pSpecializationInfo = m_Specification.SpecializationConstants.GetSpecializationInfo(*m_Specification.RayGenShader, specializationData[shaderStages.size() - 1]);
 
 			VkRayTracingShaderGroupCreateInfoKHR& shaderGroup = shaderGroups.emplace_back();
 			shaderGroup.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
@@ -129,8 +133,8 @@ namespace VkLibrary {
 
 		if (m_Specification.MissShader)
 		{
-			const VkPipelineShaderStageCreateInfo& shaderStage = m_Specification.MissShader->GetShaderCreateInfo()[0];
-			shaderStages.emplace_back(shaderStage);
+			VkPipelineShaderStageCreateInfo& shaderStage = shaderStages.emplace_back(m_Specification.MissShader->GetShaderCreateInfo()[0]);
+			shaderStage.pSpecializationInfo = m_Specification.SpecializationConstants.GetSpecializationInfo(*m_Specification.MissShader, specializationData[shaderStages.size() - 1]);
 
 			VkRayTracingShaderGroupCreateInfoKHR& shaderGroup = shaderGroups.emplace_back();
 			shaderGroup.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
@@ -145,8 +149,8 @@ namespace VkLibrary {
 
 		if (m_Specification.ClosestHitShader)
 		{
-			const VkPipelineShaderStageCreateInfo& shaderStage = m_Specification.ClosestHitShader->GetShaderCreateInfo()[0];
-			shaderStages.emplace_back(shaderStage);
+			VkPipelineShaderStageCreateInfo& shaderStage = shaderStages.emplace_back(m_Specification.ClosestHitShader->GetShaderCreateInfo()[0]);
+			shaderStage.pSpecializationInfo = m_Specification.SpecializationConstants.GetSpecializationInfo(*m_Specification.ClosestHitShader, specializationData[shaderStages.size() - 1]);
 
 			VkRayTracingShaderGroupCreateInfoKHR& shaderGroup = shaderGroups.emplace_back();
 			shaderGroup.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
@@ -167,7 +171,7 @@ namespace VkLibrary {
 		rayTracingPipelineCreateInfo.pGroups = shaderGroups.data();
 		rayTracingPipelineCreateInfo.maxPipelineRayRecursionDepth = 4;
 		rayTracingPipelineCreateInfo.layout = m_PipelineLayout;
-		VK_CHECK_RESULT(vkCreateRayTracingPipelinesKHR(device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &rayTracingPipelineCreateInfo, nullptr, &m_Pipeline));
+		VK_CHECK_RESULT(vkCreateRayTracingPipelinesKHR(device, VK_NULL_HANDLE, Application::GetVulkanDevice()->GetPipelineCache(), 1, &rayTracingPipelineCreateInfo, nullptr, &m_Pipeline));
 
 		const auto& props = Application::GetVulkanDevice()->GetRayTracingPipelineProperties();
 
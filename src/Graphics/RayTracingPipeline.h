@@ -1,5 +1,6 @@
 #pragma once
 #include "Shader.h"
+#include "SpecializationConstants.h"
 #include "VulkanAllocator.h"
 #include <vulkan/vulkan.h>
 
@@ -10,6 +11,9 @@ namespace VkLibrary {
 		Ref<Shader> RayGenShader;
 		Ref<Shader> MissShader;
 		Ref<Shader> ClosestHitShader;
+
+		// Shared by all shaders, each stage only gets the constants it declares
+		SpecializationConstants SpecializationConstants;
 	};
 
 	struct RTBufferInfo
@@ -19,7 +23,6 @@ namespace VkLibrary {
 		VkStridedDeviceAddressRegionKHR StridedDeviceAddressRegion;
 	};
 
-	// TODO: Add support for resource deletion queue in destructor
 	// TODO: Set max number for storage buffers based on hardware
 
 	class RayTracingPipeline
@@ -6,7 +6,7 @@
 namespace VkLibrary {
 
 	RenderCommandBuffer::RenderCommandBuffer(uint32_t count)
-		: m_CommandBuffers(count), m_Fences(count)
+		: m_CommandBuffers(count ? count : Application::GetSwapchain()->GetFramesInFlight()), m_Fences(m_CommandBuffers.size())
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 		QueueFamilyIndices queueIndices = device->GetQueueFamilyIndices();
@@ -49,6 +49,9 @@ namespace VkLibrary {
 
 	void RenderCommandBuffer::Begin()
 	{
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		VK_CHECK_RESULT(vkWaitForFences(device->GetLogicalDevice(), 1, &m_Fences[m_CurrentIndex], VK_TRUE, UINT64_MAX));
+
 		VkCommandBufferBeginInfo begin_info = {};
 		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		vkBeginCommandBuffer(GetCommandBuffer(), &begin_info);
@@ -73,10 +76,12 @@ namespace VkLibrary {
 
 		// Submit command buffer and signal fence when it's done
 		VK_CHECK_RESULT(vkResetFences(device->GetLogicalDevice(), 1, &m_Fences[m_CurrentIndex]));
-		VK_CHECK_RESULT(vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, m_Fences[m_CurrentIndex]));
+		{
+			std::lock_guard<std::mutex> queueLock(device->GetQueueMutex());
+			VK_CHECK_RESULT(vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, m_Fences[m_CurrentIndex]));
+		}
 
 		m_CurrentIndex = (m_CurrentIndex + 1) % (uint32_t)m_CommandBuffers.size();
-		VK_CHECK_RESULT(vkWaitForFences(device->GetLogicalDevice(), 1, &m_Fences[m_CurrentIndex], VK_TRUE, UINT32_MAX));
 	}
 
 }
\ No newline at end of file
@@ -7,11 +7,13 @@ namespace VkLibrary {
 	class RenderCommandBuffer
 	{
 	public:
-		RenderCommandBuffer(uint32_t count = 1);
+		// One command buffer per frame in flight if count is 0
+		RenderCommandBuffer(uint32_t count = 0);
 		~RenderCommandBuffer();
 
 		VkCommandBuffer GetCommandBuffer() const { return m_CommandBuffers[m_CurrentIndex]; }
 		
+		// Waits until the GPU is done with the previous submission of the buffer that is reused
 		void Begin();
 		void End();
 		void Submit();
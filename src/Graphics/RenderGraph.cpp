@@ -0,0 +1,886 @@
+#include "pch.h"
+#include "RenderGraph.h"
+#include "Core/Application.h"
+
+namespace VkLibrary {
+
+	namespace Utils {
+
+		struct AccessInfo
+		{
+			VkPipelineStageFlags2KHR Stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+			VkAccessFlags2KHR Access = VK_ACCESS_2_NONE_KHR;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			bool Write = false;
+
+			VkImageUsageFlags ImageUsage = 0;
+			VkBufferUsageFlags BufferUsage = 0;
+		};
+
+		// Imported attachments like swapchain images change per frame, older framebuffers are released once this many exist
+		static const uint32_t s_MaxCachedFramebuffers = 8;
+
+		static AccessInfo GetAccessInfo(RenderGraphAccess access)
+		{
+			const VkPipelineStageFlags2KHR fragmentTests = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+			const VkAccessFlags2KHR storageAccess = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+
+			switch (access)
+			{
+			case RenderGraphAccess::ColorAttachment:        return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0 };
+			case RenderGraphAccess::DepthStencilAttachment: return { fragmentTests, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0 };
+			case RenderGraphAccess::DepthStencilRead:       return { fragmentTests, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0 };
+			case RenderGraphAccess::VertexBuffer:           return { VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED, false, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT };
+			case RenderGraphAccess::IndexBuffer:            return { VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR, VK_ACCESS_2_INDEX_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED, false, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT };
+			case RenderGraphAccess::IndirectBuffer:         return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED, false, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT };
+			case RenderGraphAccess::VertexShaderRead:       return { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::FragmentShaderRead:     return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::ComputeShaderRead:      return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::RayTracingShaderRead:   return { VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false, VK_IMAGE_USAGE_SAMPLED_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::ComputeStorageRead:     return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::ComputeStorageWrite:    return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, storageAccess, VK_IMAGE_LAYOUT_GENERAL, true, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::RayTracingStorageRead:  return { VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL, false, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::RayTracingStorageWrite: return { VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, storageAccess, VK_IMAGE_LAYOUT_GENERAL, true, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+			case RenderGraphAccess::TransferRead:           return { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT };
+			case RenderGraphAccess::TransferWrite:          return { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT };
+			case RenderGraphAccess::Present:                return { VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false, 0, 0 };
+			}
+
+			ASSERT(false, "Unknown Type");
+			return {};
+		}
+
+		static VkImageAspectFlags GetImageAspect(VkFormat format)
+		{
+			if (!VkTools::IsDepthFormat(format))
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+
+			return VkTools::IsStencilFormat(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+		}
+
+		static bool LifetimesOverlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+		{
+			return firstA <= lastB && firstB <= lastA;
+		}
+
+	}
+
+	void RenderGraphPassBuilder::Read(RenderGraphImage image, RenderGraphAccess access)
+	{
+		m_Graph.AddUse(m_PassIndex, image.Index, true, access, false);
+	}
+
+	void RenderGraphPassBuilder::Write(RenderGraphImage image, RenderGraphAccess access)
+	{
+		m_Graph.AddUse(m_PassIndex, image.Index, true, access, true);
+	}
+
+	void RenderGraphPassBuilder::Read(RenderGraphBuffer buffer, RenderGraphAccess access)
+	{
+		m_Graph.AddUse(m_PassIndex, buffer.Index, false, access, false);
+	}
+
+	void RenderGraphPassBuilder::Write(RenderGraphBuffer buffer, RenderGraphAccess access)
+	{
+		m_Graph.AddUse(m_PassIndex, buffer.Index, false, access, true);
+	}
+
+	void RenderGraphPassBuilder::Clear(RenderGraphImage image, const VkClearValue& clearValue)
+	{
+		RenderGraph::Pass& pass = m_Graph.m_Passes[m_PassIndex];
+
+		RenderGraph::Attachment* attachment = nullptr;
+		for (RenderGraph::Attachment& color : pass.ColorAttachments)
+		{
+			if (color.Image == image.Index)
+				attachment = &color;
+		}
+
+		if (pass.HasDepthAttachment && pass.DepthAttachment.Image == image.Index)
+			attachment = &pass.DepthAttachment;
+
+		ASSERT(attachment, "Image has to be written as attachment before it can be cleared");
+		attachment->Clear = true;
+		attachment->ClearValue = clearValue;
+	}
+
+	void RenderGraphPassBuilder::SetSideEffects()
+	{
+		m_Graph.m_Passes[m_PassIndex].SideEffects = true;
+	}
+
+	RenderGraph::RenderGraph(const std::string& debugName)
+		: m_DebugName(debugName)
+	{
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		ReleasePhysicalResources();
+	}
+
+	RenderGraphImage RenderGraph::CreateImage(const std::string& name, const RenderGraphImageSpecification& specification)
+	{
+		ImageResource& image = m_Images.emplace_back();
+		image.Name = name;
+		image.Format = Image::ImageFormatToVulkan(specification.Format);
+		image.Width = specification.Width;
+		image.Height = specification.Height;
+
+		m_Compiled = false;
+		return { (uint32_t)m_Images.size() - 1 };
+	}
+
+	RenderGraphBuffer RenderGraph::CreateBuffer(const std::string& name, const RenderGraphBufferSpecification& specification)
+	{
+		BufferResource& buffer = m_Buffers.emplace_back();
+		buffer.Name = name;
+		buffer.Size = specification.Size;
+
+		m_Compiled = false;
+		return { (uint32_t)m_Buffers.size() - 1 };
+	}
+
+	RenderGraphImage RenderGraph::ImportImage(const std::string& name, const RenderGraphImportedImage& importedImage)
+	{
+		ImageResource& image = m_Images.emplace_back();
+		image.Name = name;
+		image.Imported = true;
+		image.Format = importedImage.Format;
+		image.Width = importedImage.Width;
+		image.Height = importedImage.Height;
+		image.LayerCount = importedImage.LayerCount;
+		image.FinalAccess = importedImage.FinalAccess;
+		image.Image = importedImage.Image;
+		image.ImageView = importedImage.ImageView;
+		image.State.Layout = importedImage.InitialLayout;
+
+		m_Compiled = false;
+		return { (uint32_t)m_Images.size() - 1 };
+	}
+
+	RenderGraphImage RenderGraph::ImportImage(const std::string& name, Ref<Image> image, RenderGraphAccess finalAccess)
+	{
+		const ImageSpecification& specification = image->GetSpecification();
+		bool isCube = specification.Usage == ImageUsage::TEXTURE_CUBE || specification.Usage == ImageUsage::STORAGE_IMAGE_CUBE;
+
+		RenderGraphImportedImage importedImage;
+		importedImage.Image = image->GetImage();
+		importedImage.ImageView = image->GetDescriptorImageInfo().imageView;
+		importedImage.Format = Image::ImageFormatToVulkan(specification.Format);
+		importedImage.Width = image->GetWidth();
+		importedImage.Height = image->GetHeight();
+		importedImage.LayerCount = isCube ? 6 : specification.LayerCount;
+		importedImage.InitialLayout = image->GetLayout();
+		importedImage.FinalAccess = finalAccess;
+
+		RenderGraphImage handle = ImportImage(name, importedImage);
+		m_Images[handle.Index].Source = image;
+		return handle;
+	}
+
+	RenderGraphBuffer RenderGraph::ImportBuffer(const std::string& name, VkBuffer vulkanBuffer, uint64_t size)
+	{
+		BufferResource& buffer = m_Buffers.emplace_back();
+		buffer.Name = name;
+		buffer.Imported = true;
+		buffer.Size = size;
+		buffer.Buffer = vulkanBuffer;
+
+		m_Compiled = false;
+		return { (uint32_t)m_Buffers.size() - 1 };
+	}
+
+	void RenderGraph::SetImportedImage(RenderGraphImage handle, VkImage vulkanImage, VkImageView imageView, VkImageLayout currentLayout, VkPipelineStageFlags2KHR waitStages)
+	{
+		ImageResource& image = m_Images[handle.Index];
+		ASSERT(image.Imported, "Only imported images can be replaced");
+
+		image.Image = vulkanImage;
+		image.ImageView = imageView;
+
+		image.State = {};
+		image.State.Layout = currentLayout;
+		image.State.ReadStages = waitStages;
+	}
+
+	uint32_t RenderGraph::AddPass(const std::string& name, const std::function<void(RenderGraphPassBuilder&)>& setup, RenderGraphExecuteFn&& execute)
+	{
+		uint32_t passIndex = (uint32_t)m_Passes.size();
+
+		Pass& pass = m_Passes.emplace_back();
+		pass.Name = name;
+		pass.Execute = std::move(execute);
+
+		RenderGraphPassBuilder builder(*this, passIndex);
+		setup(builder);
+
+		m_Compiled = false;
+		return passIndex;
+	}
+
+	void RenderGraph::AddUse(uint32_t passIndex, uint32_t resource, bool isImage, RenderGraphAccess access, bool write)
+	{
+		ASSERT(access != RenderGraphAccess::None && access != RenderGraphAccess::Present, "Access can only be used as final access of an imported image");
+
+		Utils::AccessInfo info = Utils::GetAccessInfo(access);
+		ASSERT(info.Write == write, "Access does not match Read or Write");
+
+		Pass& pass = m_Passes[passIndex];
+
+		if (isImage)
+		{
+			ASSERT(info.ImageUsage, "Access is not valid for images");
+			m_Images[resource].Usage |= info.ImageUsage;
+
+			if (access == RenderGraphAccess::ColorAttachment)
+			{
+				pass.ColorAttachments.push_back({ resource });
+			}
+			else if (access == RenderGraphAccess::DepthStencilAttachment || access == RenderGraphAccess::DepthStencilRead)
+			{
+				ASSERT(!pass.HasDepthAttachment, "Pass can only have one depth attachment");
+				pass.DepthAttachment = { resource };
+				pass.HasDepthAttachment = true;
+			}
+		}
+		else
+		{
+			ASSERT(info.BufferUsage, "Access is not valid for buffers");
+			m_Buffers[resource].Usage |= info.BufferUsage;
+		}
+
+		for (ResourceUse& use : pass.Uses)
+		{
+			if (use.Resource != resource || use.IsImage != isImage)
+				continue;
+
+			ASSERT(!isImage || use.Layout == info.Layout, "All accesses of a pass to an image have to use the same layout");
+			use.Stages |= info.Stages;
+			use.Access |= info.Access;
+			use.Write |= info.Write;
+			return;
+		}
+
+		ResourceUse& use = pass.Uses.emplace_back();
+		use.Resource = resource;
+		use.IsImage = isImage;
+		use.Write = info.Write;
+		use.Stages = info.Stages;
+		use.Access = info.Access;
+		use.Layout = isImage ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	void RenderGraph::Compile()
+	{
+		ReleasePhysicalResources();
+
+		m_Stats = {};
+		m_Stats.PassCount = (uint32_t)m_Passes.size();
+
+		CullPasses();
+		ComputeLifetimes();
+		CreateTransientResources();
+		CreateRenderPasses();
+
+		m_Compiled = true;
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		std::vector<bool> neededImages(m_Images.size(), false);
+		std::vector<bool> neededBuffers(m_Buffers.size(), false);
+
+		// Walk backwards, a pass is needed if it writes something a later needed pass or the outside world reads
+		for (int32_t passIndex = (int32_t)m_Passes.size() - 1; passIndex >= 0; passIndex--)
+		{
+			Pass& pass = m_Passes[passIndex];
+
+			bool needed = pass.SideEffects;
+			for (const ResourceUse& use : pass.Uses)
+			{
+				if (!use.Write)
+					continue;
+
+				bool imported = use.IsImage ? m_Images[use.Resource].Imported : m_Buffers[use.Resource].Imported;
+				bool read = use.IsImage ? neededImages[use.Resource] : neededBuffers[use.Resource];
+				needed |= imported || read;
+			}
+
+			pass.Culled = !needed;
+			if (pass.Culled)
+			{
+				m_Stats.CulledPassCount++;
+				continue;
+			}
+
+			// Everything the pass touches depends on earlier writers, except attachments it clears
+			for (const ResourceUse& use : pass.Uses)
+			{
+				if (!use.IsImage)
+				{
+					neededBuffers[use.Resource] = true;
+					continue;
+				}
+
+				bool cleared = false;
+				for (const Attachment& attachment : pass.ColorAttachments)
+					cleared |= attachment.Image == use.Resource && attachment.Clear;
+				if (pass.HasDepthAttachment)
+					cleared |= pass.DepthAttachment.Image == use.Resource && pass.DepthAttachment.Clear;
+
+				if (!cleared)
+					neededImages[use.Resource] = true;
+			}
+		}
+	}
+
+	void RenderGraph::ComputeLifetimes()
+	{
+		for (ImageResource& image : m_Images)
+		{
+			image.FirstPass = UINT32_MAX;
+			image.LastPass = 0;
+		}
+
+		for (BufferResource& buffer : m_Buffers)
+		{
+			buffer.FirstPass = UINT32_MAX;
+			buffer.LastPass = 0;
+		}
+
+		for (uint32_t passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+		{
+			if (m_Passes[passIndex].Culled)
+				continue;
+
+			for (const ResourceUse& use : m_Passes[passIndex].Uses)
+			{
+				uint32_t& firstPass = use.IsImage ? m_Images[use.Resource].FirstPass : m_Buffers[use.Resource].FirstPass;
+				uint32_t& lastPass = use.IsImage ? m_Images[use.Resource].LastPass : m_Buffers[use.Resource].LastPass;
+
+				firstPass = std::min(firstPass, passIndex);
+				lastPass = passIndex;
+			}
+		}
+	}
+
+	void RenderGraph::CreateTransientResources()
+	{
+		VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
+
+		struct TransientResource
+		{
+			uint32_t Resource = 0;
+			bool IsImage = true;
+			uint32_t FirstPass = 0;
+			uint32_t LastPass = 0;
+			VkMemoryRequirements Requirements = {};
+		};
+
+		std::vector<TransientResource> transients;
+
+		for (uint32_t i = 0; i < m_Images.size(); i++)
+		{
+			ImageResource& image = m_Images[i];
+			if (image.Imported || image.FirstPass == UINT32_MAX)
+				continue;
+
+			VkImageCreateInfo imageCreateInfo = {};
+			imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageCreateInfo.format = image.Format;
+			imageCreateInfo.extent = { image.Width, image.Height, 1 };
+			imageCreateInfo.mipLevels = 1;
+			imageCreateInfo.arrayLayers = image.LayerCount;
+			imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageCreateInfo.usage = image.Usage;
+			imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VK_CHECK_RESULT(vkCreateImage(device, &imageCreateInfo, nullptr, &image.Image));
+			VkTools::SetImageName(image.Image, fmt::format("{}, {}", m_DebugName, image.Name).c_str());
+
+			TransientResource& transient = transients.emplace_back();
+			transient.Resource = i;
+			transient.IsImage = true;
+			transient.FirstPass = image.FirstPass;
+			transient.LastPass = image.LastPass;
+			vkGetImageMemoryRequirements(device, image.Image, &transient.Requirements);
+		}
+
+		for (uint32_t i = 0; i < m_Buffers.size(); i++)
+		{
+			BufferResource& buffer = m_Buffers[i];
+			if (buffer.Imported || buffer.FirstPass == UINT32_MAX)
+				continue;
+
+			VkBufferCreateInfo bufferCreateInfo = {};
+			bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferCreateInfo.size = buffer.Size;
+			bufferCreateInfo.usage = buffer.Usage;
+			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCreateInfo, nullptr, &buffer.Buffer));
+			VkTools::SetBufferName(buffer.Buffer, fmt::format("{}, {}", m_DebugName, buffer.Name).c_str());
+
+			TransientResource& transient = transients.emplace_back();
+			transient.Resource = i;
+			transient.IsImage = false;
+			transient.FirstPass = buffer.FirstPass;
+			transient.LastPass = buffer.LastPass;
+			vkGetBufferMemoryRequirements(device, buffer.Buffer, &transient.Requirements);
+		}
+
+		// Largest first, smaller resources then fill blocks whose occupants are already dead
+		std::sort(transients.begin(), transients.end(), [](const TransientResource& a, const TransientResource& b)
+		{
+			return a.Requirements.size > b.Requirements.size;
+		});
+
+		for (const TransientResource& transient : transients)
+		{
+			m_Stats.TransientBytes += transient.Requirements.size;
+
+			int32_t blockIndex = -1;
+			for (uint32_t i = 0; i < m_MemoryBlocks.size() && blockIndex < 0; i++)
+			{
+				const MemoryBlock& block = m_MemoryBlocks[i];
+				if (block.ForImages != transient.IsImage || !(block.Requirements.memoryTypeBits & transient.Requirements.memoryTypeBits))
+					continue;
+
+				bool overlaps = false;
+				for (const auto& [firstPass, lastPass] : block.Lifetimes)
+					overlaps |= Utils::LifetimesOverlap(firstPass, lastPass, transient.FirstPass, transient.LastPass);
+
+				if (!overlaps)
+					blockIndex = (int32_t)i;
+			}
+
+			if (blockIndex < 0)
+			{
+				blockIndex = (int32_t)m_MemoryBlocks.size();
+				MemoryBlock& block = m_MemoryBlocks.emplace_back();
+				block.Requirements = transient.Requirements;
+				block.ForImages = transient.IsImage;
+			}
+
+			MemoryBlock& block = m_MemoryBlocks[blockIndex];
+			block.Requirements.size = std::max(block.Requirements.size, transient.Requirements.size);
+			block.Requirements.alignment = std::max(block.Requirements.alignment, transient.Requirements.alignment);
+			block.Requirements.memoryTypeBits &= transient.Requirements.memoryTypeBits;
+			block.Lifetimes.emplace_back(transient.FirstPass, transient.LastPass);
+			block.Resources.push_back(transient.Resource);
+
+			if (transient.IsImage)
+				m_Images[transient.Resource].MemoryBlock = blockIndex;
+			else
+				m_Buffers[transient.Resource].MemoryBlock = blockIndex;
+		}
+
+		VulkanAllocator allocator(m_DebugName);
+		for (MemoryBlock& block : m_MemoryBlocks)
+		{
+			block.Allocation = allocator.AllocateMemory(block.Requirements, VMA_MEMORY_USAGE_GPU_ONLY, AllocationCategory::Transient);
+			m_Stats.AllocatedBytes += block.Requirements.size;
+
+			for (uint32_t resource : block.Resources)
+			{
+				if (block.ForImages)
+					allocator.BindImageMemory(block.Allocation, m_Images[resource].Image);
+				else
+					allocator.BindBufferMemory(block.Allocation, m_Buffers[resource].Buffer);
+			}
+
+			// Every occupant has to wait for the previous one to be done with the memory, the first one for the last
+			// occupant of the previous execution. Contents are never carried over, images always start undefined
+			auto firstPassOf = [&](uint32_t resource) { return block.ForImages ? m_Images[resource].FirstPass : m_Buffers[resource].FirstPass; };
+			std::sort(block.Resources.begin(), block.Resources.end(), [&](uint32_t a, uint32_t b) { return firstPassOf(a) < firstPassOf(b); });
+
+			for (size_t i = 0; i < block.Resources.size(); i++)
+			{
+				uint32_t previous = block.Resources[(i + block.Resources.size() - 1) % block.Resources.size()];
+				uint32_t previousLastPass = block.ForImages ? m_Images[previous].LastPass : m_Buffers[previous].LastPass;
+
+				ResourceState initialState;
+				for (const ResourceUse& use : m_Passes[previousLastPass].Uses)
+				{
+					if (use.Resource != previous || use.IsImage != block.ForImages)
+						continue;
+
+					initialState.WriteStages = use.Write ? use.Stages : VK_PIPELINE_STAGE_2_NONE_KHR;
+					initialState.WriteAccess = BarrierBatch::GetWriteAccess(use.Access);
+					initialState.ReadStages = use.Stages;
+				}
+
+				if (block.ForImages)
+					m_Images[block.Resources[i]].InitialState = initialState;
+				else
+					m_Buffers[block.Resources[i]].InitialState = initialState;
+			}
+		}
+
+		m_Stats.MemoryBlockCount = (uint32_t)m_MemoryBlocks.size();
+
+		for (ImageResource& image : m_Images)
+		{
+			if (image.Imported || !image.Image)
+				continue;
+
+			VkImageViewCreateInfo imageViewCreateInfo = {};
+			imageViewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			imageViewCreateInfo.viewType = image.LayerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+			imageViewCreateInfo.format = image.Format;
+			imageViewCreateInfo.subresourceRange.aspectMask = Utils::GetImageAspect(image.Format);
+			imageViewCreateInfo.subresourceRange.baseMipLevel = 0;
+			imageViewCreateInfo.subresourceRange.levelCount = 1;
+			imageViewCreateInfo.subresourceRange.baseArrayLayer = 0;
+			imageViewCreateInfo.subresourceRange.layerCount = image.LayerCount;
+			imageViewCreateInfo.image = image.Image;
+
+			VK_CHECK_RESULT(vkCreateImageView(device, &imageViewCreateInfo, nullptr, &image.ImageView));
+			VkTools::SetImageViewName(image.ImageView, fmt::format("{}, {}, Image View", m_DebugName, image.Name).c_str());
+		}
+	}
+
+	void RenderGraph::CreateRenderPasses()
+	{
+		VkDevice device = Application::GetVulkanDevice()->GetLogicalDevice();
+
+		for (uint32_t passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+		{
+			Pass& pass = m_Passes[passIndex];
+			if (pass.Culled || (pass.ColorAttachments.empty() && !pass.HasDepthAttachment))
+				continue;
+
+			std::vector<VkAttachmentDescription> attachmentDescriptions;
+			std::vector<VkAttachmentReference> colorAttachmentReferences;
+			VkAttachmentReference depthAttachmentReference = {};
+
+			pass.Extent = {};
+
+			// Layouts never change inside the render pass, transitions are part of the barriers in front of it
+			auto describeAttachment = [&](const Attachment& attachment, VkImageLayout layout, bool readOnly)
+			{
+				const ImageResource& image = m_Images[attachment.Image];
+
+				if (!pass.Extent.width)
+					pass.Extent = { image.Width, image.Height };
+				ASSERT(pass.Extent.width == image.Width && pass.Extent.height == image.Height, "All attachments of a pass need the same size");
+
+				// Transient contents do not have to be loaded on first use or stored on last use
+				bool firstUse = !image.Imported && image.FirstPass == passIndex;
+				bool lastUse = !image.Imported && image.LastPass == passIndex;
+
+				VkAttachmentDescription& description = attachmentDescriptions.emplace_back();
+				description.format = image.Format;
+				description.samples = VK_SAMPLE_COUNT_1_BIT;
+				description.loadOp = attachment.Clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : (firstUse ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD);
+				description.storeOp = lastUse && !readOnly ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+				description.stencilLoadOp = VkTools::IsStencilFormat(image.Format) ? description.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				description.stencilStoreOp = VkTools::IsStencilFormat(image.Format) ? description.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				description.initialLayout = layout;
+				description.finalLayout = layout;
+
+				return VkAttachmentReference{ (uint32_t)attachmentDescriptions.size() - 1, layout };
+			};
+
+			for (const Attachment& attachment : pass.ColorAttachments)
+				colorAttachmentReferences.push_back(describeAttachment(attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, false));
+
+			if (pass.HasDepthAttachment)
+			{
+				VkImageLayout layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				for (const ResourceUse& use : pass.Uses)
+				{
+					if (use.IsImage && use.Resource == pass.DepthAttachment.Image)
+						layout = use.Layout;
+				}
+
+				depthAttachmentReference = describeAttachment(pass.DepthAttachment, layout, layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+			}
+
+			VkSubpassDescription subpass = {};
+			subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+			subpass.colorAttachmentCount = (uint32_t)colorAttachmentReferences.size();
+			subpass.pColorAttachments = colorAttachmentReferences.data();
+			subpass.pDepthStencilAttachment = pass.HasDepthAttachment ? &depthAttachmentReference : nullptr;
+
+			VkRenderPassCreateInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = (uint32_t)attachmentDescriptions.size();
+			renderPassInfo.pAttachments = attachmentDescriptions.data();
+			renderPassInfo.subpassCount = 1;
+			renderPassInfo.pSubpasses = &subpass;
+
+			VK_CHECK_RESULT(vkCreateRenderPass(device, &renderPassInfo, nullptr, &pass.RenderPass));
+			VkTools::SetRenderPassName(pass.RenderPass, fmt::format("{}, {}", m_DebugName, pass.Name).c_str());
+		}
+	}
+
+	VkFramebuffer RenderGraph::GetFramebuffer(Pass& pass)
+	{
+		std::vector<VkImageView> attachments;
+		for (const Attachment& attachment : pass.ColorAttachments)
+			attachments.push_back(m_Images[attachment.Image].ImageView);
+		if (pass.HasDepthAttachment)
+			attachments.push_back(m_Images[pass.DepthAttachment.Image].ImageView);
+
+		for (const auto& [imageViews, framebuffer] : pass.Framebuffers)
+		{
+			if (imageViews == attachments)
+				return framebuffer;
+		}
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+
+		if (pass.Framebuffers.size() >= Utils::s_MaxCachedFramebuffers)
+		{
+			device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), framebuffer = pass.Framebuffers.front().second]()
+			{
+				vkDestroyFramebuffer(device, framebuffer, nullptr);
+			});
+
+			pass.Framebuffers.erase(pass.Framebuffers.begin());
+		}
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = pass.RenderPass;
+		framebufferInfo.attachmentCount = (uint32_t)attachments.size();
+		framebufferInfo.pAttachments = attachments.data();
+		framebufferInfo.width = pass.Extent.width;
+		framebufferInfo.height = pass.Extent.height;
+		framebufferInfo.layers = 1;
+
+		VkFramebuffer framebuffer;
+		VK_CHECK_RESULT(vkCreateFramebuffer(device->GetLogicalDevice(), &framebufferInfo, nullptr, &framebuffer));
+		VkTools::SetFramebufferName(framebuffer, fmt::format("{}, {}", m_DebugName, pass.Name).c_str());
+
+		pass.Framebuffers.emplace_back(std::move(attachments), framebuffer);
+		return framebuffer;
+	}
+
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer)
+	{
+		ASSERT(m_Compiled, "Render graph has to be compiled before it is executed");
+
+		m_Stats.BarrierCount = 0;
+
+		for (ImageResource& image : m_Images)
+		{
+			if (!image.Imported)
+				image.State = image.InitialState;
+			else if (image.Source)
+			{
+				// Image may have been recreated or transitioned outside the graph since the last execution
+				image.Image = image.Source->GetImage();
+				image.ImageView = image.Source->GetDescriptorImageInfo().imageView;
+				image.State = image.Source->GetState();
+			}
+		}
+
+		for (BufferResource& buffer : m_Buffers)
+		{
+			if (!buffer.Imported)
+				buffer.State = buffer.InitialState;
+		}
+
+		for (Pass& pass : m_Passes)
+		{
+			if (pass.Culled)
+				continue;
+
+			BarrierBatch barriers;
+			for (const ResourceUse& use : pass.Uses)
+				TransitionResource(barriers, use);
+
+			if (!barriers.IsEmpty())
+				m_Stats.BarrierCount++;
+			barriers.Flush(commandBuffer);
+
+			if (!pass.RenderPass)
+			{
+				pass.Execute(commandBuffer, *this);
+				continue;
+			}
+
+			std::vector<VkClearValue> clearValues;
+			for (const Attachment& attachment : pass.ColorAttachments)
+				clearValues.push_back(attachment.ClearValue);
+			if (pass.HasDepthAttachment)
+				clearValues.push_back(pass.DepthAttachment.ClearValue);
+
+			VkRenderPassBeginInfo renderPassInfo = {};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassInfo.renderPass = pass.RenderPass;
+			renderPassInfo.framebuffer = GetFramebuffer(pass);
+			renderPassInfo.renderArea.extent = pass.Extent;
+			renderPassInfo.clearValueCount = (uint32_t)clearValues.size();
+			renderPassInfo.pClearValues = clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+			VkViewport viewport = { 0.0f, 0.0f, (float)pass.Extent.width, (float)pass.Extent.height, 0.0f, 1.0f };
+			VkRect2D scissor = { { 0, 0 }, pass.Extent };
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+			pass.Execute(commandBuffer, *this);
+
+			vkCmdEndRenderPass(commandBuffer);
+		}
+
+		// Leave imported images in the state the outside world expects
+		BarrierBatch barriers;
+		for (ImageResource& image : m_Images)
+		{
+			if (!image.Imported || image.FinalAccess == RenderGraphAccess::None)
+				continue;
+
+			Utils::AccessInfo info = Utils::GetAccessInfo(image.FinalAccess);
+			barriers.TransitionImage(image.State, image.Image, { Utils::GetImageAspect(image.Format), 0, 1, 0, image.LayerCount }, info.Layout, info.Stages, info.Access);
+		}
+
+		if (!barriers.IsEmpty())
+			m_Stats.BarrierCount++;
+		barriers.Flush(commandBuffer);
+
+		for (ImageResource& image : m_Images)
+		{
+			if (image.Source)
+				image.Source->GetState() = image.State;
+		}
+	}
+
+	void RenderGraph::TransitionResource(BarrierBatch& barriers, const ResourceUse& use)
+	{
+		if (use.IsImage)
+		{
+			ImageResource& image = m_Images[use.Resource];
+			barriers.TransitionImage(image.State, image.Image, { Utils::GetImageAspect(image.Format), 0, 1, 0, image.LayerCount }, use.Layout, use.Stages, use.Access);
+		}
+		else
+		{
+			BufferResource& buffer = m_Buffers[use.Resource];
+			barriers.TransitionBuffer(buffer.State, buffer.Buffer, use.Stages, use.Access);
+		}
+	}
+
+	void RenderGraph::Reset()
+	{
+		ReleasePhysicalResources();
+
+		m_Passes.clear();
+		m_Images.clear();
+		m_Buffers.clear();
+
+		m_Stats = {};
+		m_Compiled = false;
+	}
+
+	void RenderGraph::ReleasePhysicalResources()
+	{
+		std::vector<VkImage> images;
+		std::vector<VkImageView> imageViews;
+		std::vector<VkBuffer> buffers;
+		std::vector<VmaAllocation> allocations;
+		std::vector<VkRenderPass> renderPasses;
+		std::vector<VkFramebuffer> framebuffers;
+
+		for (ImageResource& image : m_Images)
+		{
+			if (image.Imported || !image.Image)
+				continue;
+
+			images.push_back(image.Image);
+			imageViews.push_back(image.ImageView);
+			image.Image = VK_NULL_HANDLE;
+			image.ImageView = VK_NULL_HANDLE;
+			image.MemoryBlock = -1;
+		}
+
+		for (BufferResource& buffer : m_Buffers)
+		{
+			if (buffer.Imported || !buffer.Buffer)
+				continue;
+
+			buffers.push_back(buffer.Buffer);
+			buffer.Buffer = VK_NULL_HANDLE;
+			buffer.MemoryBlock = -1;
+		}
+
+		for (MemoryBlock& block : m_MemoryBlocks)
+			allocations.push_back(block.Allocation);
+		m_MemoryBlocks.clear();
+
+		for (Pass& pass : m_Passes)
+		{
+			if (pass.RenderPass)
+				renderPasses.push_back(pass.RenderPass);
+			for (const auto& [views, framebuffer] : pass.Framebuffers)
+				framebuffers.push_back(framebuffer);
+
+			pass.RenderPass = VK_NULL_HANDLE;
+			pass.Framebuffers.clear();
+		}
+
+		m_Compiled = false;
+
+		if (images.empty() && buffers.empty() && allocations.empty() && renderPasses.empty() && framebuffers.empty())
+			return;
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+
+		// Frames in flight may still execute the previous compilation
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), debugName = m_DebugName, images, imageViews, buffers, allocations, renderPasses, framebuffers]()
+		{
+			for (VkFramebuffer framebuffer : framebuffers)
+				vkDestroyFramebuffer(device, framebuffer, nullptr);
+			for (VkRenderPass renderPass : renderPasses)
+				vkDestroyRenderPass(device, renderPass, nullptr);
+			for (VkImageView imageView : imageViews)
+				vkDestroyImageView(device, imageView, nullptr);
+			for (VkImage image : images)
+				vkDestroyImage(device, image, nullptr);
+			for (VkBuffer buffer : buffers)
+				vkDestroyBuffer(device, buffer, nullptr);
+
+			VulkanAllocator allocator(debugName);
+			for (VmaAllocation allocation : allocations)
+				allocator.FreeMemory(allocation);
+		});
+	}
+
+	VkImage RenderGraph::GetImage(RenderGraphImage handle) const
+	{
+		return m_Images[handle.Index].Image;
+	}
+
+	VkImageView RenderGraph::GetImageView(RenderGraphImage handle) const
+	{
+		return m_Images[handle.Index].ImageView;
+	}
+
+	VkBuffer RenderGraph::GetBuffer(RenderGraphBuffer handle) const
+	{
+		return m_Buffers[handle.Index].Buffer;
+	}
+
+	VkImageLayout RenderGraph::GetImageLayout(RenderGraphAccess access)
+	{
+		return Utils::GetAccessInfo(access).Layout;
+	}
+
+	VkRenderPass RenderGraph::GetRenderPass(uint32_t passIndex) const
+	{
+		return m_Passes[passIndex].RenderPass;
+	}
+
+	VkExtent2D RenderGraph::GetRenderExtent(uint32_t passIndex) const
+	{
+		return m_Passes[passIndex].Extent;
+	}
+
+}
@@ -0,0 +1,268 @@
+#pragma once
+#include "Image.h"
+#include <functional>
+
+namespace VkLibrary {
+
+	// How a pass touches a resource, every access maps to a fixed stage, access mask and image layout
+	// Shader reads of images are sampled reads, storage reads and writes keep the image in general layout
+	enum class RenderGraphAccess
+	{
+		None = -1,
+		ColorAttachment, DepthStencilAttachment, DepthStencilRead,
+		VertexBuffer, IndexBuffer, IndirectBuffer,
+		VertexShaderRead, FragmentShaderRead, ComputeShaderRead, RayTracingShaderRead,
+		ComputeStorageRead, ComputeStorageWrite, RayTracingStorageRead, RayTracingStorageWrite,
+		TransferRead, TransferWrite,
+		Present
+	};
+
+	struct RenderGraphImage
+	{
+		uint32_t Index = UINT32_MAX;
+		inline bool IsValid() const { return Index != UINT32_MAX; }
+	};
+
+	struct RenderGraphBuffer
+	{
+		uint32_t Index = UINT32_MAX;
+		inline bool IsValid() const { return Index != UINT32_MAX; }
+	};
+
+	struct RenderGraphImageSpecification
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		ImageFormat Format = ImageFormat::NONE;
+	};
+
+	struct RenderGraphBufferSpecification
+	{
+		uint64_t Size = 0;
+	};
+
+	// State of an imported image outside the graph
+	// Initial is the state before the first execution, afterwards the image is left in Final after every execution
+	struct RenderGraphImportedImage
+	{
+		VkImage Image = VK_NULL_HANDLE;
+		VkImageView ImageView = VK_NULL_HANDLE;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t LayerCount = 1;
+
+		VkImageLayout InitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		RenderGraphAccess FinalAccess = RenderGraphAccess::None;
+	};
+
+	class RenderGraph;
+	using RenderGraphExecuteFn = std::function<void(VkCommandBuffer, const RenderGraph&)>;
+
+	class RenderGraphPassBuilder
+	{
+	public:
+		void Read(RenderGraphImage image, RenderGraphAccess access);
+		void Write(RenderGraphImage image, RenderGraphAccess access);
+		void Read(RenderGraphBuffer buffer, RenderGraphAccess access);
+		void Write(RenderGraphBuffer buffer, RenderGraphAccess access);
+
+		// Attachment is cleared when the pass begins instead of loaded
+		void Clear(RenderGraphImage image, const VkClearValue& clearValue);
+
+		// Pass is kept even if nothing reads its results, e.g. readbacks or writes to external buffers
+		void SetSideEffects();
+
+	private:
+		RenderGraphPassBuilder(RenderGraph& graph, uint32_t passIndex)
+			: m_Graph(graph), m_PassIndex(passIndex) {}
+
+	private:
+		RenderGraph& m_Graph;
+		uint32_t m_PassIndex;
+
+		friend class RenderGraph;
+	};
+
+	struct RenderGraphStats
+	{
+		uint32_t PassCount = 0;
+		uint32_t CulledPassCount = 0;
+		uint32_t BarrierCount = 0;
+
+		uint64_t TransientBytes = 0; // Sum of all transient resources as if each had its own memory
+		uint64_t AllocatedBytes = 0; // Memory actually allocated after aliasing
+		uint32_t MemoryBlockCount = 0;
+	};
+
+	// NOTE: Passes declare which images and buffers they read and write, the graph then
+	//  - culls passes whose results never reach an imported resource or a pass with side effects
+	//  - creates transient resources and aliases their memory when their lifetimes do not overlap
+	//  - records one batched pipeline barrier before each pass that needs one, derived from the declared accesses
+	//  - creates a render pass and framebuffer for every pass that writes attachments and begins it around the execute function
+	// Graph is built once and executed every frame, rebuild and compile again when transient sizes change
+	// Render passes of a pass stay compatible across rebuilds as long as the attachment formats stay the same
+
+	class RenderGraph
+	{
+	public:
+		RenderGraph(const std::string& debugName = "Render Graph");
+		~RenderGraph();
+
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+	public:
+		RenderGraphImage CreateImage(const std::string& name, const RenderGraphImageSpecification& specification);
+		RenderGraphBuffer CreateBuffer(const std::string& name, const RenderGraphBufferSpecification& specification);
+
+		RenderGraphImage ImportImage(const std::string& name, const RenderGraphImportedImage& image);
+		// Layout and last access are taken from the tracked image state and written back after every execution
+		RenderGraphImage ImportImage(const std::string& name, Ref<Image> image, RenderGraphAccess finalAccess = RenderGraphAccess::None);
+		RenderGraphBuffer ImportBuffer(const std::string& name, VkBuffer buffer, uint64_t size);
+
+		// Swaps the image behind an imported handle without recompiling, e.g. the current swapchain image
+		// waitStages have to finish before the first use, e.g. the stage the acquire semaphore is waited on
+		void SetImportedImage(RenderGraphImage handle, VkImage image, VkImageView imageView, VkImageLayout currentLayout, VkPipelineStageFlags2KHR waitStages = VK_PIPELINE_STAGE_2_NONE_KHR);
+
+		uint32_t AddPass(const std::string& name, const std::function<void(RenderGraphPassBuilder&)>& setup, RenderGraphExecuteFn&& execute);
+
+		void Compile();
+		void Execute(VkCommandBuffer commandBuffer);
+
+		// Removes all passes and resources, physical resources are released once frames in flight are done with them
+		void Reset();
+
+	public:
+		VkImage GetImage(RenderGraphImage handle) const;
+		VkImageView GetImageView(RenderGraphImage handle) const;
+		VkBuffer GetBuffer(RenderGraphBuffer handle) const;
+
+		// Layout an image is in while a pass accesses it, e.g. for descriptor writes
+		static VkImageLayout GetImageLayout(RenderGraphAccess access);
+
+		// Only valid after Compile and only for passes that write attachments and were not culled
+		VkRenderPass GetRenderPass(uint32_t passIndex) const;
+		VkExtent2D GetRenderExtent(uint32_t passIndex) const;
+
+		inline const RenderGraphStats& GetStats() const { return m_Stats; }
+
+	private:
+		// All accesses of a pass to the same resource are merged into one use
+		struct ResourceUse
+		{
+			uint32_t Resource = 0;
+			bool IsImage = true;
+			bool Write = false;
+
+			VkPipelineStageFlags2KHR Stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+			VkAccessFlags2KHR Access = VK_ACCESS_2_NONE_KHR;
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+
+		struct Attachment
+		{
+			uint32_t Image = 0;
+			bool Clear = false;
+			VkClearValue ClearValue = {};
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			RenderGraphExecuteFn Execute;
+
+			std::vector<ResourceUse> Uses;
+			std::vector<Attachment> ColorAttachments;
+			Attachment DepthAttachment;
+			bool HasDepthAttachment = false;
+			bool SideEffects = false;
+
+			bool Culled = false;
+			VkRenderPass RenderPass = VK_NULL_HANDLE;
+			VkExtent2D Extent = {};
+
+			// Imported attachments can change every frame, one framebuffer per combination of views
+			std::vector<std::pair<std::vector<VkImageView>, VkFramebuffer>> Framebuffers;
+		};
+
+		struct ImageResource
+		{
+			std::string Name;
+			bool Imported = false;
+
+			VkFormat Format = VK_FORMAT_UNDEFINED;
+			uint32_t Width = 0;
+			uint32_t Height = 0;
+			uint32_t LayerCount = 1;
+			VkImageUsageFlags Usage = 0;
+			RenderGraphAccess FinalAccess = RenderGraphAccess::None;
+
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView ImageView = VK_NULL_HANDLE;
+			Ref<VkLibrary::Image> Source;
+
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			int32_t MemoryBlock = -1;
+
+			ResourceState InitialState;
+			ResourceState State;
+		};
+
+		struct BufferResource
+		{
+			std::string Name;
+			bool Imported = false;
+
+			uint64_t Size = 0;
+			VkBufferUsageFlags Usage = 0;
+
+			VkBuffer Buffer = VK_NULL_HANDLE;
+
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			int32_t MemoryBlock = -1;
+
+			ResourceState InitialState;
+			ResourceState State;
+		};
+
+		struct MemoryBlock
+		{
+			VmaAllocation Allocation = VK_NULL_HANDLE;
+			VkMemoryRequirements Requirements = {};
+			bool ForImages = true;
+
+			// Lifetimes of the resources bound to the block, in pass order
+			std::vector<std::pair<uint32_t, uint32_t>> Lifetimes;
+			std::vector<uint32_t> Resources;
+		};
+
+	private:
+		void CullPasses();
+		void ComputeLifetimes();
+		void CreateTransientResources();
+		void CreateRenderPasses();
+		void ReleasePhysicalResources();
+
+		void AddUse(uint32_t passIndex, uint32_t resource, bool isImage, RenderGraphAccess access, bool write);
+		VkFramebuffer GetFramebuffer(Pass& pass);
+
+		void TransitionResource(BarrierBatch& barriers, const ResourceUse& use);
+
+	private:
+		std::string m_DebugName;
+		bool m_Compiled = false;
+
+		std::vector<Pass> m_Passes;
+		std::vector<ImageResource> m_Images;
+		std::vector<BufferResource> m_Buffers;
+		std::vector<MemoryBlock> m_MemoryBlocks;
+
+		RenderGraphStats m_Stats;
+
+		friend class RenderGraphPassBuilder;
+	};
+
+}
@@ -51,6 +51,7 @@ namespace VkLibrary {
 		ShaderDescriptorType Type = ShaderDescriptorType::NONE;
 		uint32_t Set = -1;
 		uint32_t Binding = -1;
+		uint32_t ArraySize = 1; // 0 for unsized arrays
 	};
 
 	struct ShaderBufferDescription
@@ -60,6 +61,7 @@ namespace VkLibrary {
 		uint32_t Set = -1;
 		uint32_t Binding = -1;
 		uint32_t Size = -1;
+		uint32_t ArraySize = 1; // 0 for unsized arrays
 
 		std::vector<ShaderDescriptor> Members;
 	};
@@ -71,57 +73,85 @@ namespace VkLibrary {
 		uint32_t Binding = -1;
 	};
 
-	// TODO: Provide support array items in shader reflection and layout generation
+	struct ShaderSpecializationConstant
+	{
+		std::string Name;
+		ShaderDescriptorType Type = ShaderDescriptorType::NONE;
+		uint32_t ConstantID = -1;
+		uint32_t Size = -1;
+	};
+
+	struct ShaderReflectionData
+	{
+		// Map of set->binding to resource descriptions
+		std::map<uint32_t, std::map<uint32_t, ShaderBufferDescription>> BufferDescriptions;
+		std::map<uint32_t, std::map<uint32_t, ShaderResourceDescription>> ResourceDescriptions;
+
+		std::map<uint32_t, ShaderAttributeDescription> AttributeDescriptions;
+		std::vector<PushConstantRangeDescription> PushConstantRanges;
+
+		// Map of name to specialization constant, unnamed constants are called SpecializationConstant<ID>
+		std::map<std::string, ShaderSpecializationConstant> SpecializationConstants;
+	};
+
 	// NOTE: Reflection for HLSL is not entirely accurate
+	// Unsized arrays are only supported in the bindless set, which always uses the BindlessDescriptorHeap layout
 
 	class VertexBufferLayout;
+	class ShaderPack;
 
 	class Shader
 	{
 	public:
 		Shader(const std::string_view path);
 		Shader(const std::string_view path, const std::string_view entryPoint, const std::vector<std::wstring>& defines = {});
+		Shader(const ShaderPack& pack, const std::string_view path, const std::string_view entryPoint = "main", const std::vector<std::wstring>& defines = {});
 		~Shader();
 
 	public:
 		inline const std::filesystem::path& GetPath() const { return m_Path; }
 		inline bool CompiledSuccessfully() const { return m_CompilationStatus; }
 
+		// Hash of the SPIR-V of every stage, identical code gives the same hash across runs
+		inline uint64_t GetHash() const { return m_Hash; }
+
 		const ShaderResourceDescription& FindResourceDescription(const std::string& name);
 		const ShaderBufferDescription& FindBufferDescription(const std::string& name);
 		const VkWriteDescriptorSet& FindWriteDescriptorSet(const std::string& name);
 
 		VkDescriptorSet AllocateDescriptorSet(VkDescriptorPool pool, uint32_t set);
+
+		// Template for updating a set from packed DescriptorUpdateData, see DescriptorSetLayoutCache::GetUpdateDataElement
+		VkDescriptorUpdateTemplate GetDescriptorUpdateTemplate(uint32_t set) const;
 		const std::map<uint32_t, std::map<uint32_t, VkWriteDescriptorSet>>& GetWriteDescriptorSets() const { return m_WriteDescriptorSets; }
 
 		inline const Ref<VertexBufferLayout>& GetVertexBufferLayout() const { return m_VertexBufferLayout; }
 		inline const std::vector<VkDescriptorSetLayout>& GetDescriptorSetLayouts() const { return m_DescriptorSetLayouts; }
 		inline const std::vector<VkPipelineShaderStageCreateInfo>& GetShaderCreateInfo() const { return m_ShaderStageCreateInfo; }
 
-		inline const std::map<uint32_t, std::map<uint32_t, ShaderBufferDescription>>& GetShaderBufferDescriptions() const { return m_ShaderBufferDescriptions; }
-		inline const std::map<uint32_t, std::map<uint32_t, ShaderResourceDescription>>& GetShaderResourceDescriptions() const { return m_ShaderResourceDescriptions; }
+		inline const std::map<uint32_t, std::map<uint32_t, ShaderBufferDescription>>& GetShaderBufferDescriptions() const { return m_ReflectionData.BufferDescriptions; }
+		inline const std::map<uint32_t, std::map<uint32_t, ShaderResourceDescription>>& GetShaderResourceDescriptions() const { return m_ReflectionData.ResourceDescriptions; }
 
-		inline const std::map<uint32_t, ShaderAttributeDescription>& GetShaderAttributeDescriptions() const { return m_ShaderAttributeDescriptions; }
-		inline const std::vector<PushConstantRangeDescription>& GetPushConstantRanges() const { return m_PushConstantBufferRanges; }
+		inline const std::map<uint32_t, ShaderAttributeDescription>& GetShaderAttributeDescriptions() const { return m_ReflectionData.AttributeDescriptions; }
+		inline const std::vector<PushConstantRangeDescription>& GetPushConstantRanges() const { return m_ReflectionData.PushConstantRanges; }
+		inline const std::map<std::string, ShaderSpecializationConstant>& GetSpecializationConstants() const { return m_ReflectionData.SpecializationConstants; }
+		inline const ShaderReflectionData& GetReflectionData() const { return m_ReflectionData; }
 
 		static uint32_t GetTypeSize(ShaderDescriptorType type);
 
 	private:
 		void Init();
+		void InitFromPack(const ShaderPack& pack);
 
-		bool CompileGLSLShaders(const std::unordered_map<ShaderStage, std::string>& shaderSrc);
-		bool CompileHLSLShaders(const std::unordered_map<ShaderStage, std::string>& shaderSrc);
-
-		void ReflectShader(const std::vector<uint32_t>& data, ShaderStage stage);
+		void CreateShaderModule(ShaderStage stage, const uint32_t* code, size_t size);
 		void GenerateDescriptorData();
 
-		std::unordered_map<ShaderStage, std::string> SplitShaders(const std::filesystem::path& path);
-
 	private:
 		std::filesystem::path m_Path;
 		std::unordered_map<ShaderStage, std::string> m_ShaderSrc;
 
 		bool m_CompilationStatus = false;
+		uint64_t m_Hash = 14695981039346656037ull;
 
 		std::vector<std::wstring> m_HLSLDefines;
 		const std::string m_HLSLEntryPoint;
@@ -131,12 +161,7 @@ namespace VkLibrary {
 		std::vector<VkPipelineShaderStageCreateInfo> m_ShaderStageCreateInfo;
 		std::map<uint32_t, std::map<uint32_t, VkWriteDescriptorSet>> m_WriteDescriptorSets;
 		
-		// Map of set->binding to resource descriptions
-		std::map<uint32_t, std::map<uint32_t, ShaderBufferDescription>> m_ShaderBufferDescriptions;
-		std::map<uint32_t, std::map<uint32_t, ShaderResourceDescription>> m_ShaderResourceDescriptions;
-
-		std::map<uint32_t, ShaderAttributeDescription> m_ShaderAttributeDescriptions;
-		std::vector<PushConstantRangeDescription> m_PushConstantBufferRanges;
+		ShaderReflectionData m_ReflectionData;
 
 		std::unordered_map<std::string, ShaderDescriptorMetadata> m_ShaderDescriptorMetadata;
 	};
@@ -0,0 +1,638 @@
+#include "pch.h"
+#include "ShaderCompiler.h"
+#include <shaderc/shaderc.hpp>
+#include <spirv_cross.hpp>
+#include <spirv_common.hpp>
+#include <unknwn.h>
+#include <dxc/dxcapi.h>
+#include <combaseapi.h>
+
+namespace VkLibrary {
+
+	namespace Utils {
+
+		static shaderc_shader_kind ShaderStageToShaderc(ShaderStage stage)
+		{
+			switch (stage)
+			{
+			case ShaderStage::VERTEX:	   return shaderc_vertex_shader;
+			case ShaderStage::FRAGMENT:    return shaderc_fragment_shader;
+			case ShaderStage::COMPUTE:     return shaderc_compute_shader;
+			case ShaderStage::RAYGEN:      return shaderc_raygen_shader;
+			case ShaderStage::MISS:        return shaderc_miss_shader;
+			case ShaderStage::CLOSEST_HIT: return shaderc_closesthit_shader;
+			}
+
+			ASSERT(false, "Unknown Type");
+			return (shaderc_shader_kind)0;
+		}
+
+		static VkShaderStageFlagBits ShaderStageToVulkan(ShaderStage stage)
+		{
+			switch (stage)
+			{
+			case ShaderStage::VERTEX:	   return VK_SHADER_STAGE_VERTEX_BIT;
+			case ShaderStage::FRAGMENT:    return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case ShaderStage::COMPUTE:     return VK_SHADER_STAGE_COMPUTE_BIT;
+			case ShaderStage::RAYGEN:      return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+			case ShaderStage::MISS:        return VK_SHADER_STAGE_MISS_BIT_KHR;
+			case ShaderStage::CLOSEST_HIT: return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+			}
+
+			ASSERT(false, "Unknown Type");
+			return (VkShaderStageFlagBits)0;
+		}
+
+		static const std::string ShaderStageToDXC(ShaderStage stage)
+		{
+			switch (stage)
+			{
+			case ShaderStage::VERTEX:	   return "vs_6_2";
+			case ShaderStage::FRAGMENT:    return "ps_6_2";
+			case ShaderStage::COMPUTE:     return "cs_6_2";
+			}
+
+			ASSERT(false, "Unsupported HLSL stage");
+			return "";
+		}
+
+		static ShaderDescriptorType GetType(spirv_cross::SPIRType type)
+		{
+			spirv_cross::SPIRType::BaseType baseType = type.basetype;
+
+			if (baseType == spirv_cross::SPIRType::Float)
+			{
+				if (type.columns == 1)
+				{
+					if (type.vecsize == 1)	    return ShaderDescriptorType::FLOAT;
+					else if (type.vecsize == 2) return ShaderDescriptorType::FLOAT2;
+					else if (type.vecsize == 3) return ShaderDescriptorType::FLOAT3;
+					else if (type.vecsize == 4) return ShaderDescriptorType::FLOAT4;
+				}
+				else
+				{
+					return ShaderDescriptorType::MAT4;
+				}
+			}
+			else if (baseType == spirv_cross::SPIRType::Image)
+			{
+				if (type.image.dim == 1)	     return ShaderDescriptorType::STORAGE_IMAGE_2D;
+				else if (type.image.dim == 3)    return ShaderDescriptorType::STORAGE_IMAGE_CUBE;
+			}
+			else if (baseType == spirv_cross::SPIRType::SampledImage)
+			{
+				if (type.image.dim == 1)		 return ShaderDescriptorType::TEXTURE_2D;
+				else if (type.image.dim == 3)    return ShaderDescriptorType::TEXTURE_CUBE;
+			}
+			else if (baseType == spirv_cross::SPIRType::AccelerationStructure)
+			{
+				return ShaderDescriptorType::ACCELERATION_STRUCTURE;
+			}
+			else if (baseType == spirv_cross::SPIRType::Int)
+			{
+				return ShaderDescriptorType::INT;
+			}
+			else if (baseType == spirv_cross::SPIRType::UInt)
+			{
+				return ShaderDescriptorType::UINT;
+			}
+			else if (baseType == spirv_cross::SPIRType::Boolean)
+			{
+				return ShaderDescriptorType::BOOL;
+			}
+
+			return (ShaderDescriptorType)0;
+		}
+
+		// Returns 0 for unsized arrays
+		static uint32_t GetArraySize(const spirv_cross::SPIRType& type)
+		{
+			if (type.array.empty())
+				return 1;
+
+			ASSERT(type.array.size() == 1, "Multidimensional descriptor arrays are not supported");
+			return type.array[0];
+		}
+
+		static IDxcCompiler3* s_HLSLCompiler;
+		static IDxcUtils* s_HLSLUtils;
+		static IDxcIncludeHandler* s_DefaultIncludeHandler;
+
+		class DXCIncludeHandler : public IDxcIncludeHandler
+		{
+		public:
+			DXCIncludeHandler()
+			{
+			}
+
+			HRESULT STDMETHODCALLTYPE LoadSource(_In_ LPCWSTR pFilename, _COM_Outptr_result_maybenull_ IDxcBlob** ppIncludeSource) override
+			{
+				IDxcBlobEncoding* pEncoding;
+
+				std::wstring wstring(pFilename);
+				int count = WideCharToMultiByte(CP_UTF8, 0, wstring.c_str(), (int)wstring.length(), NULL, 0, NULL, NULL);
+				std::string path(count, 0);
+				WideCharToMultiByte(CP_UTF8, 0, wstring.c_str(), -1, &path[0], count, NULL, NULL);
+
+				if (IncludedFiles.find(path) != IncludedFiles.end())
+				{
+					// Return empty string blob if this file has been included before
+					static const char nullStr[] = " ";
+					s_HLSLUtils->CreateBlob(nullStr, ARRAYSIZE(nullStr), CP_UTF8, &pEncoding);
+					*ppIncludeSource = pEncoding;
+					return S_OK;
+				}
+
+				HRESULT hr = s_HLSLUtils->LoadFile(pFilename, nullptr, &pEncoding);
+				if (SUCCEEDED(hr))
+				{
+					IncludedFiles.insert(path);
+					*ppIncludeSource = pEncoding;
+				}
+				else
+				{
+					*ppIncludeSource = nullptr;
+				}
+				return hr;
+			}
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, _COM_Outptr_ void __RPC_FAR* __RPC_FAR* ppvObject) override
+			{
+				return s_DefaultIncludeHandler->QueryInterface(riid, ppvObject);
+			}
+
+			ULONG STDMETHODCALLTYPE AddRef(void) override { return 0; }
+			ULONG STDMETHODCALLTYPE Release(void) override { return 0; }
+
+			std::unordered_set<std::string> IncludedFiles;
+		};
+
+		class ShadercIncludeInterface : public shaderc::CompileOptions::IncluderInterface
+		{
+			shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type, const char* requesting_source, size_t include_depth)
+			{
+				const std::string name = std::string(requested_source);
+
+				std::ifstream t(name);
+				std::stringstream buffer;
+				buffer << t.rdbuf();
+
+				const std::string contents = buffer.str();
+
+				auto container = new std::array<std::string, 2>;
+				(*container)[0] = name;
+				(*container)[1] = contents;
+
+				auto data = new shaderc_include_result;
+
+				data->user_data = container;
+
+				data->source_name = (*container)[0].data();
+				data->source_name_length = (*container)[0].size();
+
+				data->content = (*container)[1].data();
+				data->content_length = (*container)[1].size();
+
+				return data;
+			};
+
+			void ReleaseInclude(shaderc_include_result* data) override
+			{
+				delete static_cast<std::array<std::string, 2>*>(data->user_data);
+				delete data;
+			};
+		};
+	}
+
+	std::unordered_map<ShaderStage, std::string> ShaderCompiler::SplitShaders(const std::filesystem::path& path, std::vector<ShaderVariant>* outVariants)
+	{
+		std::unordered_map<ShaderStage, std::string> result;
+		ShaderStage stage = ShaderStage::NONE;
+
+		std::ifstream stream(path);
+		ASSERT(stream.good(), "File either does exist or is empty");
+
+		std::stringstream ss[2];
+		std::string line;
+
+		while (getline(stream, line))
+		{
+			if (line.find("#Shader") != std::string::npos)
+			{
+				if (line.find("Vertex") != std::string::npos)
+				{
+					stage = ShaderStage::VERTEX;
+				}
+				else if (line.find("Fragment") != std::string::npos)
+				{
+					stage = ShaderStage::FRAGMENT;
+				}
+				else if (line.find("Compute") != std::string::npos)
+				{
+					stage = ShaderStage::COMPUTE;
+				}
+				else if (line.find("RayGen") != std::string::npos)
+				{
+					stage = ShaderStage::RAYGEN;
+				}
+				else if (line.find("AnyHit") != std::string::npos)
+				{
+					stage = ShaderStage::ANY_HIT;
+				}
+				else if (line.find("ClosestHit") != std::string::npos)
+				{
+					stage = ShaderStage::CLOSEST_HIT;
+				}
+				else if (line.find("Miss") != std::string::npos)
+				{
+					stage = ShaderStage::MISS;
+				}
+			}
+			else if (line.find("#Variant") == 0)
+			{
+				// Parse entry point followed by defines
+				std::stringstream variantStream(line.substr(8));
+				ShaderVariant variant;
+				variantStream >> variant.EntryPoint;
+
+				std::string define;
+				while (variantStream >> define)
+					variant.Defines.push_back(std::wstring(define.begin(), define.end()));
+
+				if (outVariants && !variant.EntryPoint.empty())
+					outVariants->push_back(variant);
+			}
+			else
+			{
+				result[stage] += line + '\n';
+			}
+		}
+
+		return result;
+	}
+
+	bool ShaderCompiler::Compile(const std::filesystem::path& path, const std::unordered_map<ShaderStage, std::string>& shaderSrc, const ShaderCompileOptions& options, std::map<ShaderStage, std::vector<uint32_t>>& outSPIRV)
+	{
+		if (path.extension() == ".glsl")
+			return CompileGLSL(path, shaderSrc, options, outSPIRV);
+		else if (path.extension() == ".hlsl")
+			return CompileHLSL(path, shaderSrc, options, outSPIRV);
+
+		ASSERT(false, "File extension is not supported");
+		return false;
+	}
+
+	bool ShaderCompiler::CompileGLSL(const std::filesystem::path& path, const std::unordered_map<ShaderStage, std::string>& shaderSrc, const ShaderCompileOptions& options, std::map<ShaderStage, std::vector<uint32_t>>& outSPIRV)
+	{
+		// Setup compiler
+		shaderc::Compiler compiler;
+		shaderc::CompileOptions compileOptions;
+		compileOptions.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		compileOptions.SetIncluder(std::make_unique<Utils::ShadercIncludeInterface>());
+
+		if (options.Optimize)
+			compileOptions.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+		// Set defines
+		for (const std::wstring& define : options.Defines)
+		{
+			std::string defineString = std::string(define.begin(), define.end());
+			size_t separator = defineString.find('=');
+
+			if (separator != std::string::npos)
+				compileOptions.AddMacroDefinition(defineString.substr(0, separator), defineString.substr(separator + 1));
+			else
+				compileOptions.AddMacroDefinition(defineString);
+		}
+
+		for (auto&& [stage, src] : shaderSrc)
+		{
+			// Preprocess includes 
+			shaderc::PreprocessedSourceCompilationResult preprocessResult = compiler.PreprocessGlsl(src, Utils::ShaderStageToShaderc(stage), path.string().c_str(), compileOptions);
+			if (preprocessResult.GetCompilationStatus() != shaderc_compilation_status_success)
+			{
+				LOG_ERROR("Warnings ({0}), Errors ({1}) \n{2}", preprocessResult.GetNumWarnings(), preprocessResult.GetNumErrors(), preprocessResult.GetErrorMessage());
+				return false;
+			}
+
+			std::string preprocessSource(preprocessResult.begin());
+
+			// Compile shader source and check for errors
+			shaderc::SpvCompilationResult compilationResult = compiler.CompileGlslToSpv(preprocessSource, Utils::ShaderStageToShaderc(stage), path.string().c_str(), compileOptions);
+			if (compilationResult.GetCompilationStatus() != shaderc_compilation_status_success)
+			{
+				LOG_ERROR("Warnings ({0}), Errors ({1}) \n{2}", compilationResult.GetNumWarnings(), compilationResult.GetNumErrors(), compilationResult.GetErrorMessage());
+				return false;
+			}
+
+			outSPIRV[stage] = std::vector<uint32_t>(compilationResult.cbegin(), compilationResult.cend());
+		}
+
+		return true;
+	}
+
+	bool ShaderCompiler::CompileHLSL(const std::filesystem::path& path, const std::unordered_map<ShaderStage, std::string>& shaderSrc, const ShaderCompileOptions& options, std::map<ShaderStage, std::vector<uint32_t>>& outSPIRV)
+	{
+		if (!Utils::s_HLSLCompiler || !Utils::s_HLSLUtils)
+		{
+			DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&Utils::s_HLSLCompiler));
+			DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&Utils::s_HLSLUtils));
+		}
+
+		std::vector<const wchar_t*> arguments;
+
+		// Set target
+		arguments.push_back(L"-spirv");
+		arguments.push_back(L"-fspv-target-env=vulkan1.2");
+
+		// Strip reflection infomation
+		arguments.push_back(L"-Qstrip_debug");
+		arguments.push_back(L"-Qstrip_reflect");
+
+		// Set include directory
+		const std::string& includePath = (std::filesystem::current_path() / path.parent_path()).string();
+		std::wstring includePathW = std::wstring(includePath.begin(), includePath.end());
+		arguments.push_back(L"-I");
+		arguments.push_back(includePathW.c_str());
+
+		// Set entry point
+		std::wstring entryPointW = std::wstring(options.EntryPoint.begin(), options.EntryPoint.end());
+		arguments.push_back(L"-E");
+		arguments.push_back(entryPointW.c_str());
+		
+		// Set defines
+		for (const std::wstring& define : options.Defines)
+		{
+			arguments.push_back(L"-D");
+			arguments.push_back(define.c_str());
+		}
+
+		arguments.push_back(DXC_ARG_WARNINGS_ARE_ERRORS);
+		arguments.push_back(options.Optimize ? DXC_ARG_OPTIMIZATION_LEVEL3 : DXC_ARG_DEBUG);
+		arguments.push_back(DXC_ARG_PACK_MATRIX_COLUMN_MAJOR);
+
+		for (const auto& [stage, src] : shaderSrc)
+		{
+			// Set shader stage
+			const std::string DXCstage = Utils::ShaderStageToDXC(stage);
+			std::wstring DXCstageW = std::wstring(DXCstage.begin(), DXCstage.end());
+
+			arguments.push_back(L"-T");
+			arguments.push_back(DXCstageW.c_str());
+			
+			IDxcBlobEncoding* blobEncoding;
+			Utils::s_HLSLUtils->CreateBlob(src.c_str(), (uint32_t)src.size(), CP_UTF8, &blobEncoding);
+
+			DxcBuffer sourceBuffer;
+			sourceBuffer.Ptr = blobEncoding->GetBufferPointer();
+			sourceBuffer.Size = blobEncoding->GetBufferSize();
+			sourceBuffer.Encoding = 0;
+
+			Utils::DXCIncludeHandler includeHandler = Utils::DXCIncludeHandler();
+
+			IDxcResult* compileResult;
+			Utils::s_HLSLCompiler->Compile(&sourceBuffer, arguments.data(), (uint32_t)arguments.size(), &includeHandler, IID_PPV_ARGS(&compileResult));
+
+			IDxcBlobUtf8* errors;
+			compileResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), 0);
+			if (errors && errors->GetStringLength() > 0)
+			{
+				LOG_ERROR((char*)errors->GetBufferPointer());
+				return false;
+			}
+
+			arguments.pop_back();
+			arguments.pop_back();
+
+			IDxcBlob* pResult;
+			compileResult->GetResult(&pResult);
+
+			size_t size = pResult->GetBufferSize();
+			std::vector<uint32_t>& spirv = outSPIRV[stage];
+			spirv.resize(size / sizeof(uint32_t));
+			std::memcpy(spirv.data(), pResult->GetBufferPointer(), size);
+		}
+
+		return true;
+	}
+
+	void ShaderCompiler::Reflect(const std::vector<uint32_t>& spirv, ShaderStage stage, ShaderReflectionData& outReflectionData)
+	{
+		spirv_cross::Compiler compiler(spirv);
+		spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+		// Get all uniform buffers
+		for (const spirv_cross::Resource& resource : resources.uniform_buffers)
+		{
+			auto& bufferType = compiler.get_type(resource.base_type_id);
+			size_t memberCount = bufferType.member_types.size();
+			uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+			uint32_t size = compiler.get_declared_struct_size(bufferType);
+
+			if (outReflectionData.BufferDescriptions.find(set) != outReflectionData.BufferDescriptions.end() && outReflectionData.BufferDescriptions.at(set).find(binding) != outReflectionData.BufferDescriptions.at(set).end())
+			{
+				LOG_WARN("Binding {} already exists ({})", binding, outReflectionData.BufferDescriptions.at(set).at(binding).Name);
+			}
+
+			ShaderBufferDescription& buffer = outReflectionData.BufferDescriptions[set][binding];
+			buffer.Name = resource.name;
+			buffer.Size = size;
+			buffer.Binding = binding;
+			buffer.Set = set;
+			buffer.Type = ShaderDescriptorType::UNIFORM_BUFFER;
+			buffer.ArraySize = Utils::GetArraySize(compiler.get_type(resource.type_id));
+
+			// Get all members of the uniform buffer
+			for (int i = 0; i < memberCount; i++)
+			{
+				ShaderDescriptor member;
+				member.Name = compiler.get_member_name(bufferType.self, i);
+				member.Size = (uint32_t)compiler.get_declared_struct_member_size(bufferType, i);
+				member.Type = Utils::GetType(compiler.get_type(bufferType.member_types[i]));
+				member.Offset = compiler.type_struct_member_offset(bufferType, i);
+
+				buffer.Members.push_back(member);
+			}
+		}
+
+		// Get all storage buffers
+		for (const spirv_cross::Resource& resource : resources.storage_buffers)
+		{
+			auto& bufferType = compiler.get_type(resource.base_type_id);
+			size_t memberCount = bufferType.member_types.size();
+			uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+			uint32_t size = compiler.get_declared_struct_size(bufferType);
+
+			if (outReflectionData.BufferDescriptions.find(set) != outReflectionData.BufferDescriptions.end() && outReflectionData.BufferDescriptions.at(set).find(binding) != outReflectionData.BufferDescriptions.at(set).end())
+			{
+				LOG_WARN("Binding {} already exists ({})", binding, outReflectionData.BufferDescriptions.at(set).at(binding).Name);
+			}
+
+			ShaderBufferDescription& buffer = outReflectionData.BufferDescriptions[set][binding];
+			buffer.Name = resource.name;
+			buffer.Size = size;
+			buffer.Binding = binding;
+			buffer.Set = set;
+			buffer.Type = ShaderDescriptorType::STORAGE_BUFFER;
+			buffer.ArraySize = Utils::GetArraySize(compiler.get_type(resource.type_id));
+
+			// Get all members of the storage buffer
+			for (int i = 0; i < memberCount; i++)
+			{
+				ShaderDescriptor member;
+				member.Name = compiler.get_member_name(bufferType.self, i);
+				member.Size = (uint32_t)compiler.get_declared_struct_member_size(bufferType, i);
+				member.Type = Utils::GetType(compiler.get_type(bufferType.member_types[i]));
+				member.Offset = compiler.type_struct_member_offset(bufferType, i);
+
+				buffer.Members.push_back(member);
+			}
+		}
+
+		// Get all sampled images in the shader
+		for (auto& resource : resources.sampled_images)
+		{
+			auto& type = compiler.get_type(resource.base_type_id);
+			uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+
+			if (outReflectionData.ResourceDescriptions.find(set) != outReflectionData.ResourceDescriptions.end() && outReflectionData.ResourceDescriptions.at(set).find(binding) != outReflectionData.ResourceDescriptions.at(set).end())
+			{
+				LOG_WARN("Binding {} already exists ({})", binding, outReflectionData.ResourceDescriptions.at(set).at(binding).Name);
+			}
+
+			ShaderResourceDescription& shaderResource = outReflectionData.ResourceDescriptions[set][binding];
+			shaderResource.Name = resource.name;
+			shaderResource.Binding = binding;
+			shaderResource.Set = set;
+			shaderResource.Type = Utils::GetType(type);
+			shaderResource.ArraySize = Utils::GetArraySize(compiler.get_type(resource.type_id));
+		}
+
+		// Get all storage images
+		for (const spirv_cross::Resource& resource : resources.storage_images)
+		{
+			auto& type = compiler.get_type(resource.base_type_id);
+			uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+
+			if (outReflectionData.ResourceDescriptions.find(set) != outReflectionData.ResourceDescriptions.end() && outReflectionData.ResourceDescriptions.at(set).find(binding) != outReflectionData.ResourceDescriptions.at(set).end())
+			{
+				LOG_WARN("Binding {} already exists ({})", binding, outReflectionData.ResourceDescriptions.at(set).at(binding).Name);
+			}
+
+			ShaderResourceDescription& shaderResource = outReflectionData.ResourceDescriptions[set][binding];
+			shaderResource.Name = resource.name;
+			shaderResource.Binding = binding;
+			shaderResource.Set = set;
+			shaderResource.Type = Utils::GetType(type);
+			shaderResource.ArraySize = Utils::GetArraySize(compiler.get_type(resource.type_id));
+		}
+
+		// Get all acceleration structures
+		for (const spirv_cross::Resource& resource : resources.acceleration_structures)
+		{
+			auto& type = compiler.get_type(resource.base_type_id);
+			uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+
+			if (outReflectionData.ResourceDescriptions.find(set) != outReflectionData.ResourceDescriptions.end() && outReflectionData.ResourceDescriptions.at(set).find(binding) != outReflectionData.ResourceDescriptions.at(set).end())
+			{
+				LOG_WARN("Binding {} already exists ({})", binding, outReflectionData.ResourceDescriptions.at(set).at(binding).Name);
+			}
+
+			ShaderResourceDescription& shaderResource = outReflectionData.ResourceDescriptions[set][binding];
+			shaderResource.Name = resource.name;
+			shaderResource.Binding = binding;
+			shaderResource.Set =  set;
+			shaderResource.Type = Utils::GetType(type);
+			shaderResource.ArraySize = Utils::GetArraySize(compiler.get_type(resource.type_id));
+		}
+
+		// Get all vertex attributes
+		if (stage == ShaderStage::VERTEX)
+		{
+			uint32_t offset = 0;
+			for (const spirv_cross::Resource& resource : resources.stage_inputs)
+			{
+				auto& type = compiler.get_type(resource.base_type_id);
+				uint32_t location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+
+				ShaderAttributeDescription& attribute = outReflectionData.AttributeDescriptions[location];
+				attribute.Name = resource.name;
+				attribute.Location = location;
+				attribute.Type = Utils::GetType(type);
+				attribute.Size = Shader::GetTypeSize(attribute.Type);
+				attribute.Offset = offset;
+
+				offset += attribute.Size;
+			}
+		}
+
+		// Get all push constant ranges
+		for (const spirv_cross::Resource& resource : resources.push_constant_buffers)
+		{
+			auto& bufferType = compiler.get_type(resource.base_type_id);
+			size_t memberCount = bufferType.member_types.size();
+			uint32_t size = compiler.get_declared_struct_size(bufferType);
+			uint32_t offset = 0;
+
+			// Calculate range offest based on last buffers offset and size
+			if (outReflectionData.PushConstantRanges.size())
+				offset = outReflectionData.PushConstantRanges.back().Offset + outReflectionData.PushConstantRanges.back().Size;
+
+			PushConstantRangeDescription& pushConstantRange = outReflectionData.PushConstantRanges.emplace_back();
+			pushConstantRange.Name = resource.name;
+			pushConstantRange.ShaderStage = Utils::ShaderStageToVulkan(stage);
+			pushConstantRange.Size = size;
+			pushConstantRange.Offset = offset;
+
+			// Get all members of the push constant range
+			for (int i = 0; i < memberCount; i++)
+			{
+				ShaderDescriptor member;
+				member.Name = compiler.get_member_name(bufferType.self, i);
+				member.Size = (uint32_t)compiler.get_declared_struct_member_size(bufferType, i);
+				member.Type = Utils::GetType(compiler.get_type(bufferType.member_types[i]));
+				member.Offset = compiler.type_struct_member_offset(bufferType, i);
+
+				pushConstantRange.Members.push_back(member);
+			}
+		}
+
+		// Get specialization constants, constants shared between stages are only added once
+		spirv_cross::SpecializationConstant workGroupSize[3];
+		compiler.get_work_group_size_specialization_constants(workGroupSize[0], workGroupSize[1], workGroupSize[2]);
+
+		for (const spirv_cross::SpecializationConstant& constant : compiler.get_specialization_constants())
+		{
+			auto& type = compiler.get_type(compiler.get_constant(constant.id).constant_type);
+
+			ShaderSpecializationConstant specializationConstant;
+			specializationConstant.Name = compiler.get_name(constant.id);
+			specializationConstant.Type = Utils::GetType(type);
+			specializationConstant.ConstantID = constant.constant_id;
+			// Booleans are passed as VkBool32, everything else by the width it is declared with
+			specializationConstant.Size = type.basetype == spirv_cross::SPIRType::Boolean ? (uint32_t)sizeof(VkBool32) : type.width / 8;
+
+			// Work group size constants declared with local_size_x_id have no name
+			if (specializationConstant.Name.empty())
+			{
+				for (uint32_t i = 0; i < 3; i++)
+				{
+					if (workGroupSize[i].id == constant.id)
+						specializationConstant.Name = std::string("LocalSize") + "XYZ"[i];
+				}
+			}
+
+			if (specializationConstant.Name.empty())
+				specializationConstant.Name = "SpecializationConstant" + std::to_string(constant.constant_id);
+
+			outReflectionData.SpecializationConstants[specializationConstant.Name] = specializationConstant;
+		}
+
+	}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "pch.h"
+#include "Core/Core.h"
+#include "Shader.h"
+
+namespace VkLibrary {
+
+	// Variant declared in a shader file with "#Variant <EntryPoint> [DEFINE[=VALUE] ...]"
+	struct ShaderVariant
+	{
+		std::string EntryPoint = "main";
+		std::vector<std::wstring> Defines;
+	};
+
+	struct ShaderCompileOptions
+	{
+		std::string EntryPoint = "main";
+		std::vector<std::wstring> Defines;
+		bool Optimize = false;
+	};
+
+	// NOTE: ShaderCompiler never touches the Vulkan device so it can be used by offline tools
+
+	class ShaderCompiler
+	{
+	public:
+		static std::unordered_map<ShaderStage, std::string> SplitShaders(const std::filesystem::path& path, std::vector<ShaderVariant>* outVariants = nullptr);
+
+		static bool Compile(const std::filesystem::path& path, const std::unordered_map<ShaderStage, std::string>& shaderSrc, const ShaderCompileOptions& options, std::map<ShaderStage, std::vector<uint32_t>>& outSPIRV);
+		static void Reflect(const std::vector<uint32_t>& spirv, ShaderStage stage, ShaderReflectionData& outReflectionData);
+
+	private:
+		static bool CompileGLSL(const std::filesystem::path& path, const std::unordered_map<ShaderStage, std::string>& shaderSrc, const ShaderCompileOptions& options, std::map<ShaderStage, std::vector<uint32_t>>& outSPIRV);
+		static bool CompileHLSL(const std::filesystem::path& path, const std::unordered_map<ShaderStage, std::string>& shaderSrc, const ShaderCompileOptions& options, std::map<ShaderStage, std::vector<uint32_t>>& outSPIRV);
+	};
+
+}
@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "ShaderLibrary.h"
+#include <mutex>
+
+namespace VkLibrary {
+
+	struct ShaderLibraryData
+	{
+		std::mutex ShaderMutex;
+		std::unordered_map<std::string, Ref<Shader>> Shaders;
+		Scope<ShaderPack> Pack;
+	};
+
+	static ShaderLibraryData* s_Data = nullptr;
+
+	void ShaderLibrary::Init()
+	{
+		s_Data = new ShaderLibraryData();
+	}
+
+	void ShaderLibrary::Shutdown()
+	{
+		s_Data->Shaders.clear();
+		s_Data->Pack.reset();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void ShaderLibrary::LoadPack(const std::filesystem::path& path)
+	{
+		if (!std::filesystem::exists(path))
+		{
+			LOG_WARN("Shader pack {} does not exist, shaders will be compiled from source", path.string());
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(s_Data->ShaderMutex);
+
+		s_Data->Pack = CreateScope<ShaderPack>(path);
+		if (!s_Data->Pack->IsValid())
+			s_Data->Pack.reset();
+	}
+
+	Ref<Shader> ShaderLibrary::Get(const std::string_view path, const std::string_view entryPoint, const std::vector<std::wstring>& defines)
+	{
+		const std::string key = GetShaderKey(path, entryPoint, defines);
+
+		// Compilation happens under the lock so two threads requesting the same shader only compile it once
+		std::lock_guard<std::mutex> lock(s_Data->ShaderMutex);
+
+		auto it = s_Data->Shaders.find(key);
+		if (it != s_Data->Shaders.end())
+			return it->second;
+
+		Ref<Shader> shader;
+		if (s_Data->Pack && s_Data->Pack->Contains(key))
+			shader = CreateRef<Shader>(*s_Data->Pack, path, entryPoint, defines);
+		else
+			shader = CreateRef<Shader>(path, entryPoint, defines);
+
+		s_Data->Shaders[key] = shader;
+
+		return shader;
+	}
+
+	bool ShaderLibrary::Exists(const std::string_view path, const std::string_view entryPoint, const std::vector<std::wstring>& defines)
+	{
+		const std::string key = GetShaderKey(path, entryPoint, defines);
+
+		std::lock_guard<std::mutex> lock(s_Data->ShaderMutex);
+		return s_Data->Shaders.find(key) != s_Data->Shaders.end();
+	}
+
+	std::string ShaderLibrary::GetShaderKey(const std::string_view path, const std::string_view entryPoint, const std::vector<std::wstring>& defines)
+	{
+		std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+		key += "|";
+		key += entryPoint;
+
+		for (const std::wstring& define : defines)
+		{
+			key += "|";
+			key += std::string(define.begin(), define.end());
+		}
+
+		return key;
+	}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Core/Core.h"
+#include "Shader.h"
+#include "ShaderPack.h"
+
+namespace VkLibrary {
+
+	// NOTE: Shaders are keyed by path, entry point and defines, so the same file compiled with different defines is kept separately
+
+	class ShaderLibrary
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+
+		// Shaders found in the pack are created from precompiled SPIR-V, everything else is compiled from source
+		static void LoadPack(const std::filesystem::path& path);
+
+		static Ref<Shader> Get(const std::string_view path, const std::string_view entryPoint = "main", const std::vector<std::wstring>& defines = {});
+		static bool Exists(const std::string_view path, const std::string_view entryPoint = "main", const std::vector<std::wstring>& defines = {});
+
+		static std::string GetShaderKey(const std::string_view path, const std::string_view entryPoint, const std::vector<std::wstring>& defines);
+	};
+
+}
@@ -0,0 +1,376 @@
+#include "pch.h"
+#include "ShaderPack.h"
+#include "Memory/FileIO.h"
+#include "Memory/MemoryIO.h"
+
+namespace VkLibrary {
+
+	static const uint32_t s_ShaderPackVersion = 4;
+
+	struct ShaderPackHeader
+	{
+		const char HEADER[4] = { 'V', 'L', 'S', 'P' };
+		uint32_t Version = s_ShaderPackVersion;
+		uint32_t EntryCount = 0;
+		uint32_t StageCount = 0;
+	};
+
+	struct ShaderPackEntry
+	{
+		uint64_t KeyHash = 0;
+		uint64_t KeyOffset = 0;
+		uint64_t ReflectionOffset = 0;
+		uint32_t KeyLength = 0;
+		uint32_t ReflectionSize = 0;
+		uint32_t FirstStage = 0;
+		uint32_t StageCount = 0;
+	};
+
+	struct ShaderPackStageEntry
+	{
+		uint32_t Stage = 0;
+		uint32_t Padding = 0;
+		uint64_t CodeOffset = 0;
+		uint64_t CodeSize = 0;
+	};
+
+	namespace Utils {
+
+		// FNV-1a, stable between builds unlike std::hash
+		static uint64_t HashKey(const std::string& key)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for (char c : key)
+			{
+				hash ^= (uint8_t)c;
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		static void SerializeDescriptors(StreamWriter& writer, const std::vector<ShaderDescriptor>& descriptors)
+		{
+			writer.WriteRaw<uint64_t>(descriptors.size());
+			for (const ShaderDescriptor& descriptor : descriptors)
+			{
+				writer.WriteString(descriptor.Name);
+				writer.WriteRaw(descriptor.Type);
+				writer.WriteRaw(descriptor.Size);
+				writer.WriteRaw(descriptor.Offset);
+			}
+		}
+
+		static std::vector<ShaderDescriptor> DeserializeDescriptors(StreamReader& reader)
+		{
+			std::vector<ShaderDescriptor> descriptors(reader.ReadRaw<uint64_t>());
+			for (ShaderDescriptor& descriptor : descriptors)
+			{
+				descriptor.Name = reader.ReadString();
+				descriptor.Type = reader.ReadRaw<ShaderDescriptorType>();
+				descriptor.Size = reader.ReadRaw<uint32_t>();
+				descriptor.Offset = reader.ReadRaw<uint32_t>();
+			}
+
+			return descriptors;
+		}
+
+		static void SerializeReflectionData(StreamWriter& writer, const ShaderReflectionData& data)
+		{
+			// Buffers
+			uint64_t bufferCount = 0;
+			for (const auto& [set, buffers] : data.BufferDescriptions)
+				bufferCount += buffers.size();
+
+			writer.WriteRaw(bufferCount);
+			for (const auto& [set, buffers] : data.BufferDescriptions)
+			{
+				for (const auto& [binding, buffer] : buffers)
+				{
+					writer.WriteString(buffer.Name);
+					writer.WriteRaw(buffer.Type);
+					writer.WriteRaw(buffer.Set);
+					writer.WriteRaw(buffer.Binding);
+					writer.WriteRaw(buffer.Size);
+					writer.WriteRaw(buffer.ArraySize);
+					SerializeDescriptors(writer, buffer.Members);
+				}
+			}
+
+			// Resources
+			uint64_t resourceCount = 0;
+			for (const auto& [set, resources] : data.ResourceDescriptions)
+				resourceCount += resources.size();
+
+			writer.WriteRaw(resourceCount);
+			for (const auto& [set, resources] : data.ResourceDescriptions)
+			{
+				for (const auto& [binding, resource] : resources)
+				{
+					writer.WriteString(resource.Name);
+					writer.WriteRaw(resource.Type);
+					writer.WriteRaw(resource.Set);
+					writer.WriteRaw(resource.Binding);
+					writer.WriteRaw(resource.ArraySize);
+				}
+			}
+
+			// Vertex attributes
+			writer.WriteRaw<uint64_t>(data.AttributeDescriptions.size());
+			for (const auto& [location, attribute] : data.AttributeDescriptions)
+			{
+				writer.WriteString(attribute.Name);
+				writer.WriteRaw(attribute.Type);
+				writer.WriteRaw(attribute.Size);
+				writer.WriteRaw(attribute.Offset);
+				writer.WriteRaw(attribute.Location);
+			}
+
+			// Push constant ranges
+			writer.WriteRaw<uint64_t>(data.PushConstantRanges.size());
+			for (const PushConstantRangeDescription& range : data.PushConstantRanges)
+			{
+				writer.WriteRaw<uint32_t>(range.ShaderStage);
+				writer.WriteString(range.Name);
+				writer.WriteRaw(range.Size);
+				writer.WriteRaw(range.Offset);
+				SerializeDescriptors(writer, range.Members);
+			}
+
+			// Specialization constants
+			writer.WriteRaw<uint64_t>(data.SpecializationConstants.size());
+			for (auto& [name, constant] : data.SpecializationConstants)
+			{
+				writer.WriteString(constant.Name);
+				writer.WriteRaw(constant.Type);
+				writer.WriteRaw(constant.ConstantID);
+				writer.WriteRaw(constant.Size);
+			}
+		}
+
+		static ShaderReflectionData DeserializeReflectionData(StreamReader& reader)
+		{
+			ShaderReflectionData data;
+
+			// Buffers
+			uint64_t bufferCount = reader.ReadRaw<uint64_t>();
+			for (uint64_t i = 0; i < bufferCount; i++)
+			{
+				ShaderBufferDescription buffer;
+				buffer.Name = reader.ReadString();
+				buffer.Type = reader.ReadRaw<ShaderDescriptorType>();
+				buffer.Set = reader.ReadRaw<uint32_t>();
+				buffer.Binding = reader.ReadRaw<uint32_t>();
+				buffer.Size = reader.ReadRaw<uint32_t>();
+				buffer.ArraySize = reader.ReadRaw<uint32_t>();
+				buffer.Members = DeserializeDescriptors(reader);
+
+				data.BufferDescriptions[buffer.Set][buffer.Binding] = buffer;
+			}
+
+			// Resources
+			uint64_t resourceCount = reader.ReadRaw<uint64_t>();
+			for (uint64_t i = 0; i < resourceCount; i++)
+			{
+				ShaderResourceDescription resource;
+				resource.Name = reader.ReadString();
+				resource.Type = reader.ReadRaw<ShaderDescriptorType>();
+				resource.Set = reader.ReadRaw<uint32_t>();
+				resource.Binding = reader.ReadRaw<uint32_t>();
+				resource.ArraySize = reader.ReadRaw<uint32_t>();
+
+				data.ResourceDescriptions[resource.Set][resource.Binding] = resource;
+			}
+
+			// Vertex attributes
+			uint64_t attributeCount = reader.ReadRaw<uint64_t>();
+			for (uint64_t i = 0; i < attributeCount; i++)
+			{
+				ShaderAttributeDescription attribute;
+				attribute.Name = reader.ReadString();
+				attribute.Type = reader.ReadRaw<ShaderDescriptorType>();
+				attribute.Size = reader.ReadRaw<uint32_t>();
+				attribute.Offset = reader.ReadRaw<uint32_t>();
+				attribute.Location = reader.ReadRaw<uint32_t>();
+
+				data.AttributeDescriptions[attribute.Location] = attribute;
+			}
+
+			// Push constant ranges
+			uint64_t rangeCount = reader.ReadRaw<uint64_t>();
+			for (uint64_t i = 0; i < rangeCount; i++)
+			{
+				PushConstantRangeDescription& range = data.PushConstantRanges.emplace_back();
+				range.ShaderStage = (VkShaderStageFlagBits)reader.ReadRaw<uint32_t>();
+				range.Name = reader.ReadString();
+				range.Size = reader.ReadRaw<uint32_t>();
+				range.Offset = reader.ReadRaw<uint32_t>();
+				range.Members = DeserializeDescriptors(reader);
+			}
+
+			// Specialization constants
+			uint64_t constantCount = reader.ReadRaw<uint64_t>();
+			for (uint64_t i = 0; i < constantCount; i++)
+			{
+				ShaderSpecializationConstant constant;
+				constant.Name = reader.ReadString();
+				constant.Type = reader.ReadRaw<ShaderDescriptorType>();
+				constant.ConstantID = reader.ReadRaw<uint32_t>();
+				constant.Size = reader.ReadRaw<uint32_t>();
+
+				data.SpecializationConstants[constant.Name] = constant;
+			}
+
+			return data;
+		}
+
+		static void AlignTo(std::vector<uint8_t>& data, uint64_t alignment)
+		{
+			data.resize((data.size() + alignment - 1) & ~(alignment - 1));
+		}
+
+	}
+
+	ShaderPack::ShaderPack(const std::filesystem::path& path)
+		: m_Path(path)
+	{
+		m_File = CreateScope<MappedFile>(path);
+		if (!m_File->IsValid() || m_File->GetSize() < sizeof(ShaderPackHeader))
+		{
+			LOG_ERROR("Failed to open shader pack {}", path.string());
+			return;
+		}
+
+		const ShaderPackHeader* header = (const ShaderPackHeader*)m_File->GetData();
+		if (memcmp(header->HEADER, ShaderPackHeader().HEADER, 4) != 0 || header->Version != s_ShaderPackVersion)
+		{
+			LOG_ERROR("{} is not a compatible shader pack", path.string());
+			return;
+		}
+
+		m_Entries = (const ShaderPackEntry*)(m_File->GetData() + sizeof(ShaderPackHeader));
+		m_EntryCount = header->EntryCount;
+
+		LOG_INFO("Loaded shader pack {} ({} shaders)", path.string(), m_EntryCount);
+	}
+
+	bool ShaderPack::Contains(const std::string& key) const
+	{
+		return FindEntry(key) != nullptr;
+	}
+
+	std::vector<ShaderPackStage> ShaderPack::GetStages(const std::string& key) const
+	{
+		const ShaderPackEntry* entry = FindEntry(key);
+		ASSERT(entry, "Shader pack does not contain " + key);
+
+		const ShaderPackStageEntry* stageTable = (const ShaderPackStageEntry*)(m_Entries + m_EntryCount);
+
+		std::vector<ShaderPackStage> stages(entry->StageCount);
+		for (uint32_t i = 0; i < entry->StageCount; i++)
+		{
+			const ShaderPackStageEntry& stageEntry = stageTable[entry->FirstStage + i];
+			stages[i].Stage = (ShaderStage)stageEntry.Stage;
+			stages[i].Code = (const uint32_t*)(m_File->GetData() + stageEntry.CodeOffset);
+			stages[i].Size = stageEntry.CodeSize;
+		}
+
+		return stages;
+	}
+
+	ShaderReflectionData ShaderPack::GetReflectionData(const std::string& key) const
+	{
+		const ShaderPackEntry* entry = FindEntry(key);
+		ASSERT(entry, "Shader pack does not contain " + key);
+
+		MemoryReader reader(m_File->GetData() + entry->ReflectionOffset, entry->ReflectionSize);
+		return Utils::DeserializeReflectionData(reader);
+	}
+
+	const ShaderPackEntry* ShaderPack::FindEntry(const std::string& key) const
+	{
+		if (!m_Entries)
+			return nullptr;
+
+		// Entries are sorted by hash, walk all entries sharing the hash to handle collisions
+		uint64_t hash = Utils::HashKey(key);
+		const ShaderPackEntry* end = m_Entries + m_EntryCount;
+		const ShaderPackEntry* entry = std::lower_bound(m_Entries, end, hash, [](const ShaderPackEntry& e, uint64_t h) { return e.KeyHash < h; });
+
+		for (; entry != end && entry->KeyHash == hash; entry++)
+		{
+			std::string_view entryKey((const char*)(m_File->GetData() + entry->KeyOffset), entry->KeyLength);
+			if (entryKey == key)
+				return entry;
+		}
+
+		return nullptr;
+	}
+
+	void ShaderPack::Write(const std::filesystem::path& path, const std::vector<ShaderPackShader>& shaders)
+	{
+		// Sort shaders by key hash so the runtime can binary search the entry table
+		std::vector<const ShaderPackShader*> sortedShaders;
+		for (const ShaderPackShader& shader : shaders)
+			sortedShaders.push_back(&shader);
+
+		std::sort(sortedShaders.begin(), sortedShaders.end(), [](const ShaderPackShader* a, const ShaderPackShader* b)
+		{
+			uint64_t hashA = Utils::HashKey(a->Key);
+			uint64_t hashB = Utils::HashKey(b->Key);
+			return hashA != hashB ? hashA < hashB : a->Key < b->Key;
+		});
+
+		uint32_t stageCount = 0;
+		for (const ShaderPackShader* shader : sortedShaders)
+			stageCount += (uint32_t)shader->SPIRV.size();
+
+		ShaderPackHeader header;
+		header.EntryCount = (uint32_t)sortedShaders.size();
+		header.StageCount = stageCount;
+
+		std::vector<ShaderPackEntry> entries;
+		std::vector<ShaderPackStageEntry> stages;
+
+		// Data section starts after the header and tables, all offsets are from the start of the file
+		const uint64_t dataOffset = sizeof(ShaderPackHeader) + sizeof(ShaderPackEntry) * header.EntryCount + sizeof(ShaderPackStageEntry) * stageCount;
+		std::vector<uint8_t> data;
+
+		for (const ShaderPackShader* shader : sortedShaders)
+		{
+			ShaderPackEntry& entry = entries.emplace_back();
+			entry.KeyHash = Utils::HashKey(shader->Key);
+			entry.KeyOffset = dataOffset + data.size();
+			entry.KeyLength = (uint32_t)shader->Key.size();
+			data.insert(data.end(), shader->Key.begin(), shader->Key.end());
+
+			entry.ReflectionOffset = dataOffset + data.size();
+			MemoryWriter reflectionWriter(data);
+			Utils::SerializeReflectionData(reflectionWriter, shader->ReflectionData);
+			entry.ReflectionSize = (uint32_t)(dataOffset + data.size() - entry.ReflectionOffset);
+
+			entry.FirstStage = (uint32_t)stages.size();
+			entry.StageCount = (uint32_t)shader->SPIRV.size();
+
+			for (const auto& [stage, spirv] : shader->SPIRV)
+			{
+				Utils::AlignTo(data, sizeof(uint64_t));
+
+				ShaderPackStageEntry& stageEntry = stages.emplace_back();
+				stageEntry.Stage = (uint32_t)stage;
+				stageEntry.CodeOffset = dataOffset + data.size();
+				stageEntry.CodeSize = spirv.size() * sizeof(uint32_t);
+
+				const uint8_t* code = (const uint8_t*)spirv.data();
+				data.insert(data.end(), code, code + stageEntry.CodeSize);
+			}
+		}
+
+		FileWriter writer(path);
+		writer.WriteRaw(header);
+		writer.WriteData((const char*)entries.data(), entries.size() * sizeof(ShaderPackEntry));
+		writer.WriteData((const char*)stages.data(), stages.size() * sizeof(ShaderPackStageEntry));
+		writer.WriteData((const char*)data.data(), data.size());
+	}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "Core/Core.h"
+#include "Shader.h"
+#include "Memory/MappedFile.h"
+
+namespace VkLibrary {
+
+	struct ShaderPackStage
+	{
+		ShaderStage Stage = ShaderStage::NONE;
+		const uint32_t* Code = nullptr;
+		uint64_t Size = 0;
+	};
+
+	// Compiled shader used when writing a pack
+	struct ShaderPackShader
+	{
+		std::string Key;
+		std::map<ShaderStage, std::vector<uint32_t>> SPIRV;
+		ShaderReflectionData ReflectionData;
+	};
+
+	struct ShaderPackEntry;
+
+	// NOTE: Packs are memory mapped, SPIR-V is handed to vkCreateShaderModule without being copied
+	// Layout: header, entry table sorted by key hash, stage table, key strings, reflection blobs, SPIR-V
+
+	class ShaderPack
+	{
+	public:
+		ShaderPack(const std::filesystem::path& path);
+		~ShaderPack() = default;
+
+	public:
+		inline const std::filesystem::path& GetPath() const { return m_Path; }
+		inline bool IsValid() const { return m_Entries != nullptr; }
+
+		bool Contains(const std::string& key) const;
+
+		std::vector<ShaderPackStage> GetStages(const std::string& key) const;
+		ShaderReflectionData GetReflectionData(const std::string& key) const;
+
+		static void Write(const std::filesystem::path& path, const std::vector<ShaderPackShader>& shaders);
+
+	private:
+		const ShaderPackEntry* FindEntry(const std::string& key) const;
+
+	private:
+		std::filesystem::path m_Path;
+		Scope<MappedFile> m_File;
+
+		const ShaderPackEntry* m_Entries = nullptr;
+		uint32_t m_EntryCount = 0;
+	};
+
+}
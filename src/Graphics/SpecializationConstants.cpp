@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "SpecializationConstants.h"
+
+namespace VkLibrary {
+
+	const VkSpecializationInfo* SpecializationConstants::GetSpecializationInfo(const Shader& shader, SpecializationData& outData) const
+	{
+		outData.MapEntries.clear();
+		outData.Data.clear();
+
+		const auto& shaderConstants = shader.GetSpecializationConstants();
+
+		for (auto& [name, value] : m_Values)
+		{
+			auto it = shaderConstants.find(name);
+			// Constants the shader does not declare are skipped, the same values can be used for every stage of a pipeline
+			if (it == shaderConstants.end())
+				continue;
+
+			const ShaderSpecializationConstant& constant = it->second;
+			ASSERT(value.Size == constant.Size, "Specialization constant " + name + " is declared with a different size");
+
+			VkSpecializationMapEntry& entry = outData.MapEntries.emplace_back();
+			entry.constantID = constant.ConstantID;
+			entry.offset = (uint32_t)outData.Data.size();
+			entry.size = value.Size;
+
+			outData.Data.resize(outData.Data.size() + value.Size);
+			memcpy(outData.Data.data() + entry.offset, &value.Data, value.Size);
+		}
+
+		if (outData.MapEntries.empty())
+			return nullptr;
+
+		outData.Info.mapEntryCount = (uint32_t)outData.MapEntries.size();
+		outData.Info.pMapEntries = outData.MapEntries.data();
+		outData.Info.dataSize = outData.Data.size();
+		outData.Info.pData = outData.Data.data();
+
+		return &outData.Info;
+	}
+
+	uint64_t SpecializationConstants::GetHash() const
+	{
+		// FNV-1a over names and values
+		uint64_t hash = 14695981039346656037ull;
+		auto hashBytes = [&hash](const void* data, size_t size)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+		};
+
+		for (auto& [name, value] : m_Values)
+		{
+			hashBytes(name.data(), name.size());
+			hashBytes(&value.Data, value.Size);
+		}
+
+		return hash;
+	}
+
+}
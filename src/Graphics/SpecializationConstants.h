@@ -0,0 +1,53 @@
+#pragma once
+#include "Shader.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	// Data referenced by VkSpecializationInfo, has to stay alive until the pipeline is created
+	struct SpecializationData
+	{
+		std::vector<VkSpecializationMapEntry> MapEntries;
+		std::vector<uint8_t> Data;
+		VkSpecializationInfo Info{};
+	};
+
+	// NOTE: Values are set by the name the shader declares them with, entries are sized from the reflected constant
+	// 32-bit and 64-bit scalars are supported, bool is stored as VkBool32. A value has to match the size the shader declares
+
+	class SpecializationConstants
+	{
+	public:
+		template<typename T>
+		void Set(const std::string& name, T value)
+		{
+			static_assert(sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t), "Specialization constants have to be 32-bit or 64-bit");
+
+			SpecializationValue& entry = m_Values[name];
+			entry.Data = 0;
+			entry.Size = (uint32_t)sizeof(T);
+			memcpy(&entry.Data, &value, sizeof(T));
+		}
+
+		void Set(const std::string& name, bool value) { Set<VkBool32>(name, value ? VK_TRUE : VK_FALSE); }
+
+		inline bool Empty() const { return m_Values.empty(); }
+
+		// Fills out specialization info for the constants declared by the given shader, returns nullptr if there are none
+		const VkSpecializationInfo* GetSpecializationInfo(const Shader& shader, SpecializationData& outData) const;
+
+		// Hash of every value, pipelines that differ only by their constants get different hashes
+		uint64_t GetHash() const;
+
+	private:
+		struct SpecializationValue
+		{
+			// Value in the lowest Size bytes
+			uint64_t Data = 0;
+			uint32_t Size = 0;
+		};
+
+		std::map<std::string, SpecializationValue> m_Values;
+	};
+
+}
@@ -3,24 +3,64 @@
 #include "VulkanDevice.h"
 #include "VulkanTools.h"
 #include "VulkanExtensions.h"
+#include "FrameUniformAllocator.h"
+#include "UploadContext.h"
+#include "TextureStreamer.h"
+#include "CommandPoolRegistry.h"
+#include "VulkanAllocator.h"
 #include "Core/Application.h"
 
+#include <thread>
+
 namespace VkLibrary {
 
-	static const int MAX_FRAMES_IN_FLIGHT = 1;
+	namespace Utils {
+
+		// Upper bound for blocking present waits, presentation can stall e.g. while the window is hidden
+		static const uint64_t s_PresentWaitTimeout = 100'000'000;
+
+		static const char* PresentModeToString(VkPresentModeKHR presentMode)
+		{
+			switch (presentMode)
+			{
+			case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "Immediate";
+			case VK_PRESENT_MODE_MAILBOX_KHR:      return "Mailbox";
+			case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+			case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO relaxed";
+			}
+
+			return "Unknown";
+		}
+
+	}
 
-	Swapchain::Swapchain()
+	Swapchain::Swapchain(const SwapchainSpecification& specification)
+		: m_Specification(specification)
 	{
+		ASSERT(m_Specification.FramesInFlight > 0, "At least one frame has to be in flight");
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		m_PresentWaitEnabled = device->IsPresentWaitSupported() && (m_Specification.MeasureLatency || m_Specification.MaxQueuedFrames > 0);
+		if (m_Specification.MaxQueuedFrames > 0 && !device->IsPresentWaitSupported())
+			LOG_WARN("MaxQueuedFrames needs VK_KHR_present_wait, queued frames are only limited by frames in flight");
+
+		CreateFrameResources();
+
 		glm::ivec2 windowSizePixels = Application::GetWindow()->GetFramebufferSize();
 		Init(windowSizePixels.x, windowSizePixels.y);
 	}
 
 	Swapchain::~Swapchain()
 	{
-		Destroy();
+		RetireImageObjects();
+		DestroyFrameResources();
 
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
-		vkDestroySwapchainKHR(device->GetLogicalDevice(), m_Swapchain, nullptr);
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), swapchain = m_Swapchain, renderPass = m_RenderPass]()
+		{
+			vkDestroyRenderPass(device, renderPass, nullptr);
+			vkDestroySwapchainKHR(device, swapchain, nullptr);
+		});
 	}
 
 	void Swapchain::Init(uint32_t width, uint32_t height)
@@ -29,8 +69,10 @@ namespace VkLibrary {
 		VkSurfaceKHR surface = Application::GetWindow()->GetVulkanSurface();
 		SwapChainSupportDetails supportDetails = device->GetSwapChainSupportDetails();
 
+		VkFormat previousFormat = m_ImageFormat.format;
 		PickDetails(width, height);
 
+		// Presentation engine can reuse resources of the old swapchain, it is retired once frames still presenting from it are done
 		VkSwapchainKHR oldSwapchain = m_Swapchain;
 
 		// Create swapchain
@@ -54,8 +96,30 @@ namespace VkLibrary {
 
 		VK_CHECK_RESULT(vkCreateSwapchainKHR(device->GetLogicalDevice(), &createInfo, nullptr, &m_Swapchain));
 
+		// Present ids are per swapchain, presents of the old one can no longer be waited on
+		m_PendingPresents.clear();
+
 		if (oldSwapchain)
-			vkDestroySwapchainKHR(device->GetLogicalDevice(), oldSwapchain, nullptr);
+		{
+			device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), oldSwapchain]()
+			{
+				vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
+			});
+		}
+
+		// Render pass only depends on the format, pipelines built against it stay valid across resizes
+		if (!m_RenderPass || m_ImageFormat.format != previousFormat)
+		{
+			if (m_RenderPass)
+			{
+				device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), renderPass = m_RenderPass]()
+				{
+					vkDestroyRenderPass(device, renderPass, nullptr);
+				});
+			}
+
+			CreateRenderPass();
+		}
 
 		// Get swapchain image handles
 		VK_CHECK_RESULT(vkGetSwapchainImagesKHR(device->GetLogicalDevice(), m_Swapchain, &m_ImageCount, nullptr));
@@ -71,72 +135,172 @@ namespace VkLibrary {
 
 		CreateImageViews();
 		CreateFramebuffers();
-		CreateCommandBuffers();
 		CreateSynchronizationObjects();
 	}
 
-	void Swapchain::Destroy()
+	void Swapchain::RetireImageObjects()
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		for (auto framebuffer : m_Framebuffers)
+		// Frames in flight and pending presents may still use them, destroyed once those frames are done
+		device->GetDeletionQueue().Push([device = device->GetLogicalDevice(), framebuffers = m_Framebuffers, images = m_Images, semaphores = m_RenderCompleteSemaphores]()
 		{
-			vkDestroyFramebuffer(device->GetLogicalDevice(), framebuffer, nullptr);
-		}
+			for (VkFramebuffer framebuffer : framebuffers)
+				vkDestroyFramebuffer(device, framebuffer, nullptr);
 
-		vkDestroyRenderPass(device->GetLogicalDevice(), m_RenderPass, nullptr);
+			for (const SwapchainImage& image : images)
+				vkDestroyImageView(device, image.ImageView, nullptr);
 
-		for (auto image : m_Images)
-		{
-			vkDestroyImageView(device->GetLogicalDevice(), image.ImageView, nullptr);
-		}
+			for (VkSemaphore semaphore : semaphores)
+				vkDestroySemaphore(device, semaphore, nullptr);
+		});
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-		{
-			vkDestroySemaphore(device->GetLogicalDevice(), m_RenderCompleteSemaphores[i], nullptr);
-			vkDestroyFence(device->GetLogicalDevice(), m_WaitFences[i], nullptr);
-		}
+		m_Framebuffers.clear();
+		m_Images.clear();
+		m_RenderCompleteSemaphores.clear();
+	}
+
+	void Swapchain::Recreate()
+	{
+		RetireImageObjects();
+		Init(m_Width, m_Height);
+
+		m_RecreateRequested = false;
+	}
 
-		for (int i = 0; i < m_ImageCount; i++)
+	void Swapchain::WaitForNextFrame()
+	{
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		FrameResources& frame = m_Frames[m_CurrentBufferIndex];
+
+		// Only blocks if the CPU got FramesInFlight frames ahead, the GPU has to be done with this set before it is reused
+		Clock::time_point waitStart = Clock::now();
+		VK_CHECK_RESULT(vkWaitForFences(device->GetLogicalDevice(), 1, &frame.Fence, VK_TRUE, UINT64_MAX));
+
+		// Keep at most MaxQueuedFrames presents in the queue, a deeper queue only adds latency
+		uint32_t maxQueuedFrames = m_Specification.MaxQueuedFrames;
+		bool presentPending = !m_PendingPresents.empty() && m_PendingPresents.front().first + maxQueuedFrames <= m_PresentId;
+		if (m_PresentWaitEnabled && maxQueuedFrames > 0 && presentPending)
+			vkWaitForPresentKHR(device->GetLogicalDevice(), m_Swapchain, m_PresentId - maxQueuedFrames, Utils::s_PresentWaitTimeout);
+
+		m_LatencyStats.FenceWaitTime = std::chrono::duration<float, std::milli>(Clock::now() - waitStart).count();
+
+		if (m_Specification.MaxFrameRate > 0.0f)
 		{
-			vkDestroySemaphore(device->GetLogicalDevice(), m_PresentCompleteSemaphores[i], nullptr);
+			Clock::duration frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_Specification.MaxFrameRate));
+
+			Clock::time_point now = Clock::now();
+			if (now < m_NextFrameTime)
+				std::this_thread::sleep_until(m_NextFrameTime);
+
+			// Do not build up debt after long frames, otherwise the following frames run unlimited to catch up
+			m_NextFrameTime = std::max(m_NextFrameTime, now) + frameTime;
 		}
 
-		vkDestroyCommandPool(device->GetLogicalDevice(), m_CommandPool, nullptr);
+		if (m_PresentWaitEnabled)
+			UpdatePresentLatency();
+
+		m_FrameStartTime = Clock::now();
+		m_FrameWaited = true;
 	}
 
 	void Swapchain::BeginFrame()
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
-		VK_CHECK_RESULT(vkAcquireNextImageKHR(device->GetLogicalDevice(), m_Swapchain, UINT64_MAX, m_PresentCompleteSemaphores[m_ImageSemaphoreIndex], VK_NULL_HANDLE, &m_CurrentImageIndex));
+		FrameResources& frame = m_Frames[m_CurrentBufferIndex];
+
+		if (!m_FrameWaited)
+			WaitForNextFrame();
+		m_FrameWaited = false;
+
+		// Resize events of one frame are collapsed into a single recreation
+		if (m_RecreateRequested)
+			Recreate();
+
+		Clock::time_point acquireStart = Clock::now();
+		VkResult result = vkAcquireNextImageKHR(device->GetLogicalDevice(), m_Swapchain, UINT64_MAX, frame.ImageAcquiredSemaphore, VK_NULL_HANDLE, &m_CurrentImageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			// Semaphore is left unsignaled on failure, it can be used again right away
+			Recreate();
+			result = vkAcquireNextImageKHR(device->GetLogicalDevice(), m_Swapchain, UINT64_MAX, frame.ImageAcquiredSemaphore, VK_NULL_HANDLE, &m_CurrentImageIndex);
+		}
+
+		// Suboptimal images can still be presented, recreate once this frame is out
+		if (result == VK_SUBOPTIMAL_KHR)
+			m_RecreateRequested = true;
+		else
+			VK_CHECK_RESULT(result);
+
+		m_LatencyStats.AcquireTime = std::chrono::duration<float, std::milli>(Clock::now() - acquireStart).count();
+
+		frame.TransientDescriptorAllocator->Reset();
+
+		if (FrameUniformAllocator::IsInitialized())
+			FrameUniformAllocator::BeginFrame(m_CurrentBufferIndex);
+
+		if (CommandPoolRegistry::IsInitialized())
+			CommandPoolRegistry::BeginFrame(m_CurrentBufferIndex);
+
+		device->GetDeletionQueue().BeginFrame(m_Specification.FramesInFlight);
+
+		if (UploadContext::IsInitialized())
+			UploadContext::Update();
+
+		if (TextureStreamer::IsInitialized())
+			TextureStreamer::Update();
+
+		device->GetImmediateContext().Update();
+
+		VulkanAllocator::BeginFrame();
 	}
 
 	void Swapchain::Present()
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		FrameResources& frame = m_Frames[m_CurrentBufferIndex];
+
+		if (FrameUniformAllocator::IsInitialized())
+			FrameUniformAllocator::Flush();
 
-		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		// Immediate work recorded this frame goes out first, the frame waits on it on the GPU instead of the CPU
+		ImmediateContext& immediateContext = device->GetImmediateContext();
+		uint64_t immediateTicket = immediateContext.Submit();
+
+		std::array<VkSemaphore, 2> waitSemaphores = { frame.ImageAcquiredSemaphore, immediateContext.GetSemaphore() };
+		std::array<VkPipelineStageFlags, 2> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+		std::array<uint64_t, 2> waitValues = { 0, immediateTicket };
+
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.waitSemaphoreValueCount = (uint32_t)waitValues.size();
+		timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
 
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = &m_PresentCompleteSemaphores[m_ImageSemaphoreIndex];
-		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_CommandBuffers[m_CurrentBufferIndex];
+		submitInfo.pCommandBuffers = &frame.CommandBuffer;
 		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &m_RenderCompleteSemaphores[m_CurrentBufferIndex];
+		submitInfo.pSignalSemaphores = &m_RenderCompleteSemaphores[m_CurrentImageIndex];
 
-		VK_CHECK_RESULT(vkResetFences(device->GetLogicalDevice(), 1, &m_WaitFences[m_CurrentBufferIndex]));
-		VK_CHECK_RESULT(vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, m_WaitFences[m_CurrentBufferIndex]));
+		VK_CHECK_RESULT(vkResetFences(device->GetLogicalDevice(), 1, &frame.Fence));
+		{
+			std::lock_guard<std::mutex> queueLock(device->GetQueueMutex());
+			VK_CHECK_RESULT(vkQueueSubmit(device->GetGraphicsQueue(), 1, &submitInfo, frame.Fence));
+		}
 
-		VkResult result = QueuePresent(device->GetGraphicsQueue(), m_CurrentImageIndex, m_RenderCompleteSemaphores[m_CurrentBufferIndex]);
+		VkResult result = QueuePresent(device->GetGraphicsQueue(), m_CurrentImageIndex, m_RenderCompleteSemaphores[m_CurrentImageIndex]);
+		m_LatencyStats.InputToPresentCall = std::chrono::duration<float, std::milli>(Clock::now() - m_FrameStartTime).count();
 
 		if (result != VK_SUCCESS)
 		{
 			if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 			{
-				Resize(m_Width, m_Height);
+				m_RecreateRequested = true;
 			}
 			else
 			{
@@ -144,9 +308,8 @@ namespace VkLibrary {
 			}
 		}
 
-		m_CurrentBufferIndex = (m_CurrentBufferIndex + 1) % MAX_FRAMES_IN_FLIGHT;
-		m_ImageSemaphoreIndex = (m_ImageSemaphoreIndex + 1) % m_ImageCount;
-		VK_CHECK_RESULT(vkWaitForFences(device->GetLogicalDevice(), 1, &m_WaitFences[m_CurrentBufferIndex], VK_TRUE, UINT64_MAX));
+		// Fence of the next frame is waited on in BeginFrame, recording can overlap with the GPU until then
+		m_CurrentBufferIndex = (m_CurrentBufferIndex + 1) % m_Specification.FramesInFlight;
 	}
 
 	void Swapchain::PickDetails(uint32_t width, uint32_t height)
@@ -165,14 +328,15 @@ namespace VkLibrary {
 			}
 		}
 
-		// Select present mode
+		// Select present mode, first preferred one the surface supports
 		std::vector<VkPresentModeKHR> presentModes = supportDetails.PresentModes;
 		VkPresentModeKHR selectedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
-		for (const auto& availablePresentMode : presentModes)
+		for (VkPresentModeKHR preferredPresentMode : m_Specification.PresentModes)
 		{
-			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+			if (std::find(presentModes.begin(), presentModes.end(), preferredPresentMode) != presentModes.end())
 			{
-				selectedPresentMode = availablePresentMode;
+				selectedPresentMode = preferredPresentMode;
+				break;
 			}
 		}
 
@@ -196,12 +360,16 @@ namespace VkLibrary {
 		m_Height = selectedExtent.height;
 
 		// Select image count
-		uint32_t imageCount = capabilities.minImageCount + 1;
+		uint32_t imageCount = m_Specification.ImageCount ? m_Specification.ImageCount : capabilities.minImageCount + 1;
+		imageCount = std::max(imageCount, capabilities.minImageCount);
 		if (capabilities.maxImageCount > 0 && imageCount > capabilities.maxImageCount)
 		{
 			imageCount = capabilities.maxImageCount;
 		}
 
+		if (selectedPresentMode != m_PresentMode || imageCount != m_DesiredImageCount)
+			LOG_INFO("Swapchain present mode {}, {} images", Utils::PresentModeToString(selectedPresentMode), imageCount);
+
 		m_ImageFormat = selectedFormat;
 		m_PresentMode = selectedPresentMode;
 		m_Extent = selectedExtent;
@@ -236,7 +404,7 @@ namespace VkLibrary {
 		}
 	}
 
-	void Swapchain::CreateFramebuffers()
+	void Swapchain::CreateRenderPass()
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
@@ -282,6 +450,11 @@ namespace VkLibrary {
 		renderPassInfo.pDependencies = &dependency;
 
 		VK_CHECK_RESULT(vkCreateRenderPass(device->GetLogicalDevice(), &renderPassInfo, nullptr, &m_RenderPass));
+	}
+
+	void Swapchain::CreateFramebuffers()
+	{
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
 		// Create framebuffer for each image in the swap chain
 		m_Framebuffers.resize(m_Images.size());
@@ -300,7 +473,7 @@ namespace VkLibrary {
 		}
 	}
 
-	void Swapchain::CreateCommandBuffers()
+	void Swapchain::CreateFrameResources()
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 		QueueFamilyIndices queueIndices = device->GetQueueFamilyIndices();
@@ -313,56 +486,68 @@ namespace VkLibrary {
 
 		VK_CHECK_RESULT(vkCreateCommandPool(device->GetLogicalDevice(), &poolInfo, nullptr, &m_CommandPool));
 
-		m_CommandBuffers.resize(m_Framebuffers.size());
-
-		// Create command buffers
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = m_CommandPool;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)m_CommandBuffers.size();
-
-		VK_CHECK_RESULT(vkAllocateCommandBuffers(device->GetLogicalDevice(), &allocInfo, m_CommandBuffers.data()));
-	}
+		allocInfo.commandBufferCount = 1;
 
-	void Swapchain::CreateSynchronizationObjects()
-	{
-		Ref<VulkanDevice> device = Application::GetVulkanDevice();
-
-		m_PresentCompleteSemaphores.resize(m_ImageCount);
-		m_RenderCompleteSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_WaitFences.resize(MAX_FRAMES_IN_FLIGHT);
-
-		// Semaphore info
 		VkSemaphoreCreateInfo semaphoreInfo{};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		// Fence info
+		// Signaled so the first wait on every frame returns immediately
 		VkFenceCreateInfo fenceInfo{};
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		// Create synchronization objects
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		DescriptorAllocatorSpecification transientSpec;
+		transientSpec.FreeIndividualSets = false;
+		transientSpec.LayoutCache = &device->GetDescriptorSetLayoutCache();
+
+		m_Frames.resize(m_Specification.FramesInFlight);
+		for (FrameResources& frame : m_Frames)
 		{
-			VK_CHECK_RESULT(vkCreateSemaphore(device->GetLogicalDevice(), &semaphoreInfo, nullptr, &m_RenderCompleteSemaphores[i]));
-			VK_CHECK_RESULT(vkCreateFence(device->GetLogicalDevice(), &fenceInfo, nullptr, &m_WaitFences[i]));
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device->GetLogicalDevice(), &allocInfo, &frame.CommandBuffer));
+			VK_CHECK_RESULT(vkCreateFence(device->GetLogicalDevice(), &fenceInfo, nullptr, &frame.Fence));
+			VK_CHECK_RESULT(vkCreateSemaphore(device->GetLogicalDevice(), &semaphoreInfo, nullptr, &frame.ImageAcquiredSemaphore));
+			frame.TransientDescriptorAllocator = CreateScope<DescriptorAllocator>(device->GetLogicalDevice(), transientSpec);
 		}
+	}
 
-		for (size_t i = 0; i < m_ImageCount; i++)
+	void Swapchain::DestroyFrameResources()
+	{
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+
+		for (FrameResources& frame : m_Frames)
 		{
-			VK_CHECK_RESULT(vkCreateSemaphore(device->GetLogicalDevice(), &semaphoreInfo, nullptr, &m_PresentCompleteSemaphores[i]));
+			vkDestroyFence(device->GetLogicalDevice(), frame.Fence, nullptr);
+			vkDestroySemaphore(device->GetLogicalDevice(), frame.ImageAcquiredSemaphore, nullptr);
 		}
+
+		m_Frames.clear();
+		vkDestroyCommandPool(device->GetLogicalDevice(), m_CommandPool, nullptr);
 	}
 
-	void Swapchain::Resize(uint32_t width, uint32_t height)
+	void Swapchain::CreateSynchronizationObjects()
 	{
 		Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
-		vkDeviceWaitIdle(device->GetLogicalDevice());
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		Destroy();
-		Init(width, height);
+		m_RenderCompleteSemaphores.resize(m_ImageCount);
+		for (VkSemaphore& semaphore : m_RenderCompleteSemaphores)
+		{
+			VK_CHECK_RESULT(vkCreateSemaphore(device->GetLogicalDevice(), &semaphoreInfo, nullptr, &semaphore));
+		}
+	}
+
+	void Swapchain::Resize(uint32_t width, uint32_t height)
+	{
+		// Window can send many resize events while dragging, the swapchain is recreated once at the start of the next frame
+		m_Width = width;
+		m_Height = height;
+		m_RecreateRequested = true;
 	}
 
 	VkResult Swapchain::QueuePresent(VkQueue queue, uint32_t imageIndex, VkSemaphore waitSemaphore)
@@ -378,12 +563,39 @@ namespace VkLibrary {
 		presentInfo.pImageIndices = &imageIndex;
 		presentInfo.pResults = nullptr;
 
+		VkPresentIdKHR presentId{};
+		if (m_PresentWaitEnabled)
+		{
+			m_PresentId++;
+			m_PendingPresents.emplace_back(m_PresentId, m_FrameStartTime);
+
+			presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+			presentId.swapchainCount = 1;
+			presentId.pPresentIds = &m_PresentId;
+			presentInfo.pNext = &presentId;
+		}
+
+		std::lock_guard<std::mutex> queueLock(device->GetQueueMutex());
 		return vkQueuePresentKHR(queue, &presentInfo);
 	}
 
-	uint32_t Swapchain::GetFramesInFlight()
+	void Swapchain::UpdatePresentLatency()
 	{
-		return MAX_FRAMES_IN_FLIGHT;
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+
+		// Presents complete in order, polled once per frame so the result is late by at most one frame
+		while (!m_PendingPresents.empty())
+		{
+			auto [presentId, frameStartTime] = m_PendingPresents.front();
+			VkResult result = vkWaitForPresentKHR(device->GetLogicalDevice(), m_Swapchain, presentId, 0);
+			if (result == VK_TIMEOUT)
+				break;
+
+			if (result == VK_SUCCESS)
+				m_LatencyStats.InputToPhoton = std::chrono::duration<float, std::milli>(Clock::now() - frameStartTime).count();
+
+			m_PendingPresents.pop_front();
+		}
 	}
 
 }
\ No newline at end of file
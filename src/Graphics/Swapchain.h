@@ -1,5 +1,9 @@
 #pragma once
+#include "Core/Core.h"
+#include "DescriptorAllocator.h"
 #include <vulkan/vulkan.h>
+#include <chrono>
+#include <deque>
 
 namespace VkLibrary {
 
@@ -9,13 +13,47 @@ namespace VkLibrary {
 		VkImageView ImageView;
 	};
 
+	struct SwapchainSpecification
+	{
+		// Frames the CPU may record ahead of the GPU, every per frame resource exists this many times
+		uint32_t FramesInFlight = 2;
+
+		// Present modes in order of preference, FIFO is always supported and used if none of them is
+		std::vector<VkPresentModeKHR> PresentModes = { VK_PRESENT_MODE_MAILBOX_KHR };
+
+		// Clamped to what the surface supports, 0 uses one more than the minimum
+		uint32_t ImageCount = 0;
+
+		// Frame rate cap, the limiter sleeps before input is read so the wait does not add latency. 0 disables it
+		float MaxFrameRate = 0.0f;
+
+		// Frames that may be queued for presentation before the next one starts, 0 leaves it to the present mode
+		// Needs VK_KHR_present_wait, without it only FramesInFlight limits how far the CPU runs ahead
+		uint32_t MaxQueuedFrames = 0;
+
+		bool MeasureLatency = true;
+	};
+
+	// Times in milliseconds, measured from the start of the frame where input is read
+	struct SwapchainLatencyStats
+	{
+		float FenceWaitTime = 0.0f;       // Blocked until the GPU released the frame's resources
+		float AcquireTime = 0.0f;         // Blocked in vkAcquireNextImageKHR
+		float InputToPresentCall = 0.0f;  // Until the frame was handed to vkQueuePresentKHR
+		float InputToPhoton = 0.0f;       // Until presentation completed, only with VK_KHR_present_wait, accurate to one frame
+	};
+
 	class Swapchain
 	{
 	public:
-		Swapchain();
+		Swapchain(const SwapchainSpecification& specification = {});
 		~Swapchain();
 
 	public:
+		// Blocks until the next frame may start, call before input is polled so it is as recent as possible
+		// BeginFrame calls it if it was not called for the frame
+		void WaitForNextFrame();
+
 		void BeginFrame();
 		void Present();
 
@@ -26,53 +64,85 @@ namespace VkLibrary {
 		inline VkFramebuffer GetCurrentFramebuffer() const { return m_Framebuffers[m_CurrentImageIndex]; }
 		inline uint32_t GetCurrentBufferIndex() const { return m_CurrentBufferIndex; }
 
-		inline const std::vector<VkCommandBuffer>& GetCommandBuffers() const { return m_CommandBuffers; }
-		inline VkCommandBuffer GetCurrentCommandBuffer() const { return m_CommandBuffers[m_CurrentBufferIndex]; }
+		inline VkCommandBuffer GetCurrentCommandBuffer() const { return m_Frames[m_CurrentBufferIndex].CommandBuffer; }
 		inline uint32_t GetCurrentFrameIndex() { return m_CurrentImageIndex; }
 
 		inline VkCommandPool GetCommandPool() const { return m_CommandPool; }
+
+		// Sets allocated here are only valid for the current frame, the allocator is reset when the frame comes around again
+		inline DescriptorAllocator& GetTransientDescriptorAllocator() const { return *m_Frames[m_CurrentBufferIndex].TransientDescriptorAllocator; }
 		inline uint32_t GetImageCount() const { return m_DesiredImageCount; }
 		inline VkExtent2D GetExtent() const { return m_Extent; }
 
-		uint32_t GetFramesInFlight();
+		inline uint32_t GetFramesInFlight() const { return m_Specification.FramesInFlight; }
+
+		inline VkPresentModeKHR GetPresentMode() const { return m_PresentMode; }
+		inline const SwapchainLatencyStats& GetLatencyStats() const { return m_LatencyStats; }
+
 		void Resize(uint32_t width, uint32_t height);
 
 	private:
 		void Init(uint32_t width, uint32_t height);
-		void Destroy();
+		void Recreate();
+		void RetireImageObjects();
 
 		void PickDetails(uint32_t width, uint32_t height);
 		void CreateImageViews();
+		void CreateRenderPass();
 		void CreateFramebuffers();
-		void CreateCommandBuffers();
+		void CreateFrameResources();
+		void DestroyFrameResources();
 		void CreateSynchronizationObjects();
 
 		VkResult QueuePresent(VkQueue queue, uint32_t imageIndex, VkSemaphore waitSemaphore);
+		void UpdatePresentLatency();
 
 	private:
+		// Everything a frame touches until its fence signals, reused once the frame comes around again
+		struct FrameResources
+		{
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkFence Fence = VK_NULL_HANDLE;
+			VkSemaphore ImageAcquiredSemaphore = VK_NULL_HANDLE;
+			Scope<DescriptorAllocator> TransientDescriptorAllocator;
+		};
+
+	private:
+		SwapchainSpecification m_Specification;
+
 		VkSwapchainKHR m_Swapchain = VK_NULL_HANDLE;
 		VkRenderPass m_RenderPass = VK_NULL_HANDLE;
 
 		uint32_t m_Width = 0, m_Height = 0;
 
 		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
-		std::vector<VkCommandBuffer> m_CommandBuffers;
+		std::vector<FrameResources> m_Frames;
 
 		std::vector<SwapchainImage> m_Images;
 		std::vector<VkFramebuffer> m_Framebuffers;
 
 		uint32_t m_CurrentImageIndex = 0;
 		uint32_t m_CurrentBufferIndex = 0;
-		uint32_t m_ImageSemaphoreIndex = 0;
+		bool m_RecreateRequested = false;
 
-		std::vector<VkSemaphore> m_PresentCompleteSemaphores;
+		// Presentation may still wait on a semaphore after the frame's fence signaled, so these exist per image
 		std::vector<VkSemaphore> m_RenderCompleteSemaphores;
-		std::vector<VkFence> m_WaitFences;
 
-		VkSurfaceFormatKHR m_ImageFormat;
-		VkPresentModeKHR m_PresentMode;
+		// Frame pacing and latency measurement
+		using Clock = std::chrono::steady_clock;
+		bool m_FrameWaited = false;
+		Clock::time_point m_FrameStartTime;
+		Clock::time_point m_NextFrameTime;
+		SwapchainLatencyStats m_LatencyStats;
+
+		bool m_PresentWaitEnabled = false;
+		uint64_t m_PresentId = 0;
+		std::deque<std::pair<uint64_t, Clock::time_point>> m_PendingPresents;
+
+		VkSurfaceFormatKHR m_ImageFormat = {};
+		VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_MAX_ENUM_KHR;
 		VkExtent2D m_Extent;
-		uint32_t m_DesiredImageCount;
+		uint32_t m_DesiredImageCount = 0;
 
 		uint32_t m_ImageCount;
 	};
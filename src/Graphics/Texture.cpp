@@ -1,10 +1,17 @@
 #include "pch.h"
 #include "Texture.h"
 #include "ComputePipeline.h"
+#include "ShaderLibrary.h"
+#include "PipelineLibrary.h"
+#include "BindlessDescriptorHeap.h"
+#include "TextureImporter.h"
+#include "TextureStreamer.h"
+#include "BlockCompression.h"
 #include "Core/Application.h"
 #include <stb/stb_image.h>
 #include <nvtt/nvtt.h>
 #include <nvtt/nvtt_wrapper.h>
+#include <mutex>
 
 namespace VkLibrary {
 
@@ -30,176 +37,366 @@ namespace VkLibrary {
 		uint8_t* m_BufferPtr = nullptr;
 	};
 
-	Texture2D::Texture2D(Texture2DSpecification specification)
-		: m_Specification(specification)
-	{
-		m_Path = m_Specification.path;
+	// Textures are loaded on worker threads as well
+	static std::mutex s_MemoryStatsMutex;
+	static TextureMemoryStats s_MemoryStats;
 
-		LOG_INFO("Loading Texture2D {}", m_Path.string());
+	namespace Utils {
 
-		// Load image from disk
-		int width, height, bpp;
-		stbi_set_flip_vertically_on_load(false);
+		static void RecordTextureMemory(uint32_t width, uint32_t height, ImageFormat format)
+		{
+			uint32_t mipLevels = Image::GetMipLevelCount(width, height);
+			uint64_t sizeMips = Image::GetImageSize(ImageFormat::RGBA8, width, height, mipLevels);
+
+			std::lock_guard<std::mutex> lock(s_MemoryStatsMutex);
+			s_MemoryStats.TextureCount++;
+			s_MemoryStats.BaseBytes += Image::GetImageSize(ImageFormat::RGBA8, width, height);
+			s_MemoryStats.MipBytes += sizeMips;
+			s_MemoryStats.LoadedBytes += Image::IsCompressedFormat(format) ? Image::GetImageSize(format, width, height, mipLevels) : sizeMips;
+		}
 
-		static uint64_t totalSizeUncompressed, totalSizeCompressed = 0;
+		static bool IsChannelConstant(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t channel, uint8_t value)
+		{
+			for (uint64_t i = 0; i < (uint64_t)width * height; i++)
+			{
+				if (rgba[i * 4 + channel] != value)
+					return false;
+			}
 
-		Buffer buffer;
+			return true;
+		}
 
-		if (m_Specification.compress)
+		// Formats a texture of the role can be compressed to, used to validate cached textures
+		static bool IsCompressedFormatOfRole(const Texture2DSpecification& specification, ImageFormat format)
 		{
-			std::filesystem::path compressedPath = m_Specification.path.string() + ".bc7";
+			switch (specification.Role)
+			{
+			case TextureRole::Color:
+				if (specification.sRGB)
+					return format == ImageFormat::BC1_SRGB || format == ImageFormat::BC7_SRGB;
+				return format == ImageFormat::BC1_UNORM || format == ImageFormat::BC7_UNORM;
+			case TextureRole::MetallicRoughness:
+				return format == ImageFormat::BC4_UNORM || format == ImageFormat::BC5_UNORM;
+			case TextureRole::Normal:
+				return format == ImageFormat::BC7_UNORM;
+			case TextureRole::NormalXY:
+				return format == ImageFormat::BC5_UNORM;
+			}
 
-			uint64_t imageSize = 0;
+			return false;
+		}
 
-			// Read cached texture if available
-			if (std::filesystem::exists(compressedPath))
+		// Role and color space decide which formats the source is compressed to, each combination gets its own cache
+		static std::string GetCacheKey(const Texture2DSpecification& specification)
+		{
+			const char* role = "color";
+			switch (specification.Role)
 			{
-				LOG_INFO("Cached texture available");
-				const uint64_t headerSize = sizeof(int) * 2;
-
-				std::ifstream stream(compressedPath, std::ios::binary | std::ios::ate);
-				imageSize = (uint64_t)stream.tellg() - headerSize;
-				stream.seekg(std::ios::beg);
-				buffer.Allocate(imageSize);
-				stream.read((char*)&width, sizeof(int));
-				stream.read((char*)&height, sizeof(int));
-				stream.read((char*)buffer.Data, imageSize);
-				stream.close();
-
-				LOG_INFO("Read cached texture {}", compressedPath.string());
+			case TextureRole::Color:             role = "color"; break;
+			case TextureRole::MetallicRoughness: role = "metallicroughness"; break;
+			case TextureRole::Normal:            role = "normal"; break;
+			case TextureRole::NormalXY:          role = "normalxy"; break;
 			}
-			else
+
+			return fmt::format("{}_{}", role, specification.sRGB ? "srgb" : "linear");
+		}
+
+		// Encodes every level with the built-in block encoders, each level is filtered from the one before
+		static Buffer CompressLevels(const uint8_t* rgba, uint32_t width, uint32_t height, ImageFormat format,
+			uint32_t channelX, uint32_t channelY, DownsampleMode downsampleMode)
+		{
+			uint32_t mipLevels = Image::GetMipLevelCount(width, height);
+
+			Buffer buffer;
+			buffer.Allocate(Image::GetImageSize(format, width, height, mipLevels));
+
+			std::vector<uint8_t> level, nextLevel;
+			const uint8_t* source = rgba;
+			uint64_t offset = 0;
+
+			for (uint32_t mip = 0; mip < mipLevels; mip++)
 			{
-				LOG_WARN("Cached texture unavailable");
-				std::string inputPathString = m_Specification.path.string();
-				uint8_t* data = stbi_load(inputPathString.c_str(), &width, &height, &bpp, 4);
-				ASSERT(data, "Failed to load image");
+				uint32_t levelWidth = std::max(width >> mip, 1u);
+				uint32_t levelHeight = std::max(height >> mip, 1u);
+				uint8_t* output = (uint8_t*)buffer.Data + offset;
+
+				switch (format)
+				{
+				case ImageFormat::BC1_SRGB:
+				case ImageFormat::BC1_UNORM: BlockCompression::CompressBC1(source, levelWidth, levelHeight, output); break;
+				case ImageFormat::BC4_UNORM: BlockCompression::CompressBC4(source, levelWidth, levelHeight, channelX, output); break;
+				case ImageFormat::BC5_UNORM: BlockCompression::CompressBC5(source, levelWidth, levelHeight, channelX, channelY, output); break;
+				default: ASSERT(false, "Format has no built-in encoder"); break;
+				}
 
-				nvtt::Surface image;
-				image.setImage(nvtt::InputFormat_BGRA_8UB, width, height, 1, data);
-				image.swizzle(2, 1, 0, 3);
+				offset += Image::GetImageSize(format, levelWidth, levelHeight);
 
-				nvtt::Context context(true);
+				if (mip == mipLevels - 1)
+					break;
 
-				nvtt::CompressionOptions compressionOptions;
-				compressionOptions.setFormat(nvtt::Format_BC7);
-				compressionOptions.setQuality(nvtt::Quality_Normal);
+				nextLevel.resize((uint64_t)std::max(levelWidth / 2, 1u) * std::max(levelHeight / 2, 1u) * 4);
+				BlockCompression::Downsample(source, levelWidth, levelHeight, downsampleMode, nextLevel.data());
+				level.swap(nextLevel);
+				source = level.data();
+			}
 
-				int mipmapCount = nvtt::countMipmaps(width, height, 1);
-				int estimatedSize = context.estimateSize(image, mipmapCount, compressionOptions);
-#if FILE
-				estimatedSize += 148; // DDS header size
-#endif
-				buffer.Allocate(estimatedSize);
+			return buffer;
+		}
 
-				nvtt::OutputOptions outputOptions;
+		// Color with alpha keeps BC7, the other formats are encoded without NVTT
+		static Buffer CompressLevelsBC7(const uint8_t* rgba, uint32_t width, uint32_t height, bool sRGB, uint32_t& outMipLevels)
+		{
+			nvtt::Surface image;
+			image.setImage(nvtt::InputFormat_BGRA_8UB, width, height, 1, rgba);
+			image.swizzle(2, 1, 0, 3);
 
-				// Output to file
-#if FILE
-				std::filesystem::path outputPathBinary = m_Specification.path.replace_extension("bc7");
-				std::filesystem::path outputPathNvidia = m_Specification.path.replace_extension("nbc7");
-				std::string outputPathNvidiaStr = outputPathNvidia.string();
+			nvtt::Context context(true);
 
-				outputOptions.setFileName(outputPathNvidiaStr.c_str());
+			nvtt::CompressionOptions compressionOptions;
+			compressionOptions.setFormat(nvtt::Format_BC7);
+			compressionOptions.setQuality(nvtt::Quality_Normal);
 
-				if (!context.outputHeader(image, 1, compressionOptions, outputOptions))
-				{
-					__debugbreak();
-				}
+			int mipmapCount = image.countMipmaps();
+			int estimatedSize = context.estimateSize(image, mipmapCount, compressionOptions);
+
+			Buffer buffer;
+			buffer.Allocate(estimatedSize);
+
+			nvtt::OutputOptions outputOptions;
+			MyOutputHandler outputHandler((uint8_t*)buffer.Data);
+			outputOptions.setOutputHandler(&outputHandler);
 
-				if (!context.compress(image, 0, 0, compressionOptions, outputOptions))
+			for (int mip = 0; mip < mipmapCount; mip++)
+			{
+				if (!context.compress(image, 0, mip, compressionOptions, outputOptions))
 				{
 					__debugbreak();
 				}
-#endif
 
-				MyOutputHandler outputHandler((uint8_t*)buffer.Data);
-				outputOptions.setOutputHandler(&outputHandler);
+				if (mip == mipmapCount - 1)
+					break;
+
+				// Filter in linear space with straight alpha, averaging sRGB values darkens the smaller levels
+				if (sRGB)
+					image.toLinearFromSrgb();
+				image.premultiplyAlpha();
+				image.buildNextMipmap(nvtt::MipmapFilter_Box);
+				image.demultiplyAlpha();
+				if (sRGB)
+					image.toSrgb();
+			}
+
+			outMipLevels = mipmapCount;
+			return Buffer(buffer.Data, outputHandler.GetWrittenSize());
+		}
 
-#if FILE
-				if (!context.outputHeader(image, 1, compressionOptions, outputOptions))
+		// Picks the smallest format that keeps what the role needs, linear data uses UNORM formats
+		// One and two channel formats are swizzled back into the channels the shaders read
+		static TextureData CompressTexture(const Texture2DSpecification& specification, const uint8_t* rgba, uint32_t width, uint32_t height)
+		{
+			TextureData result;
+			result.Width = width;
+			result.Height = height;
+			result.MipLevels = Image::GetMipLevelCount(width, height);
+
+			switch (specification.Role)
+			{
+			case TextureRole::Color:
+			{
+				if (IsChannelConstant(rgba, width, height, 3, 255))
 				{
-					__debugbreak();
+					result.Format = specification.sRGB ? ImageFormat::BC1_SRGB : ImageFormat::BC1_UNORM;
+					result.Data = CompressLevels(rgba, width, height, result.Format, 0, 0, specification.sRGB ? DownsampleMode::SRGB : DownsampleMode::Linear);
 				}
-#endif
-
-				if (!context.compress(image, 0, 0, compressionOptions, outputOptions))
+				else
 				{
-					__debugbreak();
+					result.Format = specification.sRGB ? ImageFormat::BC7_SRGB : ImageFormat::BC7_UNORM;
+					result.Data = CompressLevelsBC7(rgba, width, height, specification.sRGB, result.MipLevels);
+				}
+				break;
+			}
+			case TextureRole::MetallicRoughness:
+			{
+				// Roughness in green and metalness in blue, red is unused
+				bool dielectric = IsChannelConstant(rgba, width, height, 2, 0);
+				if (dielectric || IsChannelConstant(rgba, width, height, 2, 255))
+				{
+					result.Format = ImageFormat::BC4_UNORM;
+					result.Swizzle = { VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_R, dielectric ? VK_COMPONENT_SWIZZLE_ZERO : VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE };
+					result.Data = CompressLevels(rgba, width, height, result.Format, 1, 0, DownsampleMode::Linear);
 				}
+				else
+				{
+					result.Format = ImageFormat::BC5_UNORM;
+					result.Swizzle = { VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_ONE };
+					result.Data = CompressLevels(rgba, width, height, result.Format, 1, 2, DownsampleMode::Linear);
+				}
+				break;
+			}
+			case TextureRole::Normal:
+			{
+				// Normals are sampled as tex * 2 - 1 with z read from the texture, shaders that reconstruct z can use NormalXY (BC5)
+				result.Format = ImageFormat::BC7_UNORM;
+				result.Data = CompressLevelsBC7(rgba, width, height, false, result.MipLevels);
+				break;
+			}
+			case TextureRole::NormalXY:
+			{
+				// Mips are averaged as unit vectors before x and y are kept, blue reads one so it is not mistaken for z
+				result.Format = ImageFormat::BC5_UNORM;
+				result.Swizzle = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE };
+				result.Data = CompressLevels(rgba, width, height, result.Format, 0, 1, DownsampleMode::Normal);
+				break;
+			}
+			}
 
-				imageSize = outputHandler.GetWrittenSize();
+			return result;
+		}
 
-				// Cache compressed texture
-				std::ofstream stream(compressedPath, std::ios::binary);
-				stream.write((const char*)&width, sizeof(int));
-				stream.write((const char*)&height, sizeof(int));
-				stream.write((const char*)buffer.Data, imageSize);
-				stream.close();
-
-				LOG_INFO("Cached compressed texture {}", compressedPath.string());
-
-#if FILE
-				std::ofstream outputFileStream(outputPathBinary, std::ios::binary);
-				std::cout << "Total written = " << outputHandler.GetWrittenSize() << " bytes\n";
-				outputFileStream.write((char*)m_Buffer, outputHandler.GetWrittenSize());
-				outputFileStream.close();
-#endif
-
-				std::cout << "Compressed " << (width * height * 4) << " bytes -> " << imageSize << " bytes\n";
-				totalSizeUncompressed += (width * height * 4);
-				totalSizeCompressed += imageSize;
-				std::cout << "TOTAL " << (totalSizeUncompressed / 1024 / 1024) << " MB -> " << (totalSizeCompressed / 1024 / 1024) << " MB\n";
+	}
 
-				stbi_image_free(data);
+	Texture2D::Texture2D(Texture2DSpecification specification)
+		: m_Specification(specification)
+	{
+		m_Path = m_Specification.path;
+
+		if (m_Specification.Async && TextureStreamer::IsInitialized())
+		{
+			// Placeholder is sampled until the streamer swaps in the loaded image
+			m_Image = TextureStreamer::GetPlaceholder(m_Specification.PlaceholderColor);
+			m_Resident = false;
+		}
+		else
+		{
+			TextureData data = LoadTextureData(m_Specification);
+			m_Image = CreateImage(m_Specification, data);
+
+			// Free CPU memory, the image was copied into a staging buffer
+			data.Data.Release();
+		}
+
+		if (BindlessDescriptorHeap::IsInitialized())
+			m_BindlessIndex = BindlessDescriptorHeap::RegisterTexture(GetDescriptorImageInfo());
+
+		if (!m_Resident)
+			TextureStreamer::Load(this);
+	}
+
+	TextureData Texture2D::LoadTextureData(const Texture2DSpecification& specification)
+	{
+		LOG_INFO("Loading Texture2D {}", specification.path.string());
+
+		// Vertical flip is off by default, it is not set here since workers would race on the global flag
+		TextureData result;
+		int width, height, bpp;
+
+		if (specification.compress)
+		{
+			std::filesystem::path cachePath = TextureImporter::GetCachePath(specification.path, Utils::GetCacheKey(specification));
+
+			// Cached texture holds the full mip chain, it is rebuilt when missing, invalid or older than the source
+			bool cached = TextureImporter::Read(cachePath, result, specification.path) && Utils::IsCompressedFormatOfRole(specification, result.Format) &&
+				result.MipLevels == Image::GetMipLevelCount(result.Width, result.Height);
+
+			if (cached)
+			{
+				LOG_INFO("Read cached texture {}", cachePath.string());
 			}
+			else
+			{
+				result.Data.Release();
 
-			// Create image
-			ImageSpecification imageSpecification = {};
-			imageSpecification.Width = width;
-			imageSpecification.Height = height;
-			imageSpecification.Format = ImageFormat::BC7_SRGB;
-			imageSpecification.Usage = ImageUsage::TEXTURE_2D;
-			imageSpecification.DebugName = (m_Specification.DebugName + ", Image").c_str();
+				LOG_WARN("Cached texture unavailable");
+				std::string inputPathString = specification.path.string();
+				uint8_t* data = stbi_load(inputPathString.c_str(), &width, &height, &bpp, 4);
+				ASSERT(data, "Failed to load image");
+
+				result = Utils::CompressTexture(specification, data, width, height);
 
-			m_Image = CreateRef<Image>(imageSpecification, buffer);
+				// Cache compressed texture
+				TextureImporter::Write(cachePath, result, specification.path);
+				LOG_INFO("Cached compressed texture {}", cachePath.string());
+
+				stbi_image_free(data);
+			}
 
-			buffer.Release();
+			Utils::RecordTextureMemory(result.Width, result.Height, result.Format);
 		}
 		else
 		{
-			std::string str = m_Specification.path.string();
+			std::string str = specification.path.string();
 			uint8_t* data = stbi_load(str.c_str(), &width, &height, &bpp, 4);
 
-			if (!std::filesystem::exists(m_Specification.path))
+			if (!std::filesystem::exists(specification.path))
 			{
-				LOG_CRITICAL("{0} Does not exist", m_Specification.path);
+				LOG_CRITICAL("{0} Does not exist", specification.path);
 			}
 
 			ASSERT(data, "Failed to load image");
 
-			// Create image
-			ImageSpecification imageSpecification = {};
-			imageSpecification.Width = width;
-			imageSpecification.Height = height;
-			imageSpecification.Format = specification.sRGB ? ImageFormat::SRGBA8 : ImageFormat::RGBA8;
-			imageSpecification.Usage = ImageUsage::TEXTURE_2D;
-			imageSpecification.DebugName = (m_Specification.DebugName + ", Image").c_str();
+			// Only the first level is uploaded, the rest is generated on the GPU
+			// stb_image allocates with malloc, so the data is released like any other buffer
+			result.Width = width;
+			result.Height = height;
+			result.Format = specification.sRGB ? ImageFormat::SRGBA8 : ImageFormat::RGBA8;
+			result.MipLevels = 1;
+			result.Data = Buffer(data, Image::GetImageSize(result.Format, width, height));
 
-			m_Image = CreateRef<Image>(imageSpecification, buffer);
+			Utils::RecordTextureMemory(width, height, result.Format);
+		}
+
+		return result;
+	}
 
-			// Free CPU memory
-			stbi_image_free(data);
+	TextureMemoryStats Texture2D::GetMemoryStats()
+	{
+		std::lock_guard<std::mutex> lock(s_MemoryStatsMutex);
+		return s_MemoryStats;
+	}
+
+	Ref<Image> Texture2D::CreateImage(const Texture2DSpecification& specification, const TextureData& data)
+	{
+		ImageSpecification imageSpecification = {};
+		imageSpecification.Width = data.Width;
+		imageSpecification.Height = data.Height;
+		imageSpecification.Format = data.Format;
+		imageSpecification.Usage = ImageUsage::TEXTURE_2D;
+		imageSpecification.Swizzle = data.Swizzle;
+		imageSpecification.DebugName = specification.DebugName + ", Image";
+
+		// Compressed data holds every level, uncompressed levels are generated from the first one
+		imageSpecification.MipLevels = Image::IsCompressedFormat(data.Format) ? data.MipLevels : 0;
+
+		return CreateRef<Image>(imageSpecification, data.Data);
+	}
+
+	void Texture2D::SetImage(Ref<Image> image)
+	{
+		m_Image = image;
+		m_Resident = true;
+
+		// Frames in flight may still sample the old slot, rewriting it is not allowed while they are pending
+		// The new image gets its own slot and the old one is released, which only reuses it once those frames have finished
+		if (m_BindlessIndex != BindlessDescriptorHeap::InvalidIndex)
+		{
+			BindlessDescriptorHeap::ReleaseTexture(m_BindlessIndex);
+			m_BindlessIndex = BindlessDescriptorHeap::RegisterTexture(GetDescriptorImageInfo());
 		}
 	}
 
 	Texture2D::Texture2D(Ref<Image> image)
 		: m_Image(image)
 	{
+		if (BindlessDescriptorHeap::IsInitialized())
+			m_BindlessIndex = BindlessDescriptorHeap::RegisterTexture(GetDescriptorImageInfo());
 	}
 
 	Texture2D::~Texture2D()
 	{
+		if (!m_Resident)
+			TextureStreamer::Cancel(this);
+
+		BindlessDescriptorHeap::ReleaseTexture(m_BindlessIndex);
 	}
 
 	TextureCube::TextureCube(TextureCubeSpecification specification)
@@ -207,8 +404,6 @@ namespace VkLibrary {
 	{
 		m_Path = m_Specification.path;
 
-		m_DescriptorPool = VkTools::CreateDescriptorPool();
-
 		ImageSpecification imageSpec;
 		imageSpec.Width = 2048;
 		imageSpec.Height = 2048;
@@ -222,10 +417,13 @@ namespace VkLibrary {
 		Ref<Texture2D> equirectangularInput = CreateRef<Texture2D>(textureSpec);
 
 		ComputePipelineSpecification computeSpec;
-		computeSpec.Shader = CreateRef<Shader>("assets/shaders/EquirectangularToCubeMap.glsl");
-		Ref<ComputePipeline> equiToCubeMapPipeline = CreateRef<ComputePipeline>(computeSpec);
+		computeSpec.Shader = ShaderLibrary::Get("assets/shaders/EquirectangularToCubeMap.glsl");
+		Ref<ComputePipeline> equiToCubeMapPipeline = PipelineLibrary::GetComputePipeline(computeSpec);
 		
-		VkDescriptorSet computeDescriptorSet = computeSpec.Shader->AllocateDescriptorSet(m_DescriptorPool, 0);
+		Ref<VulkanDevice> device = Application::GetApp().GetVulkanDevice();
+		DescriptorAllocator& descriptorAllocator = device->GetDescriptorAllocator();
+
+		VkDescriptorSet computeDescriptorSet = descriptorAllocator.Allocate(computeSpec.Shader->GetDescriptorSetLayouts()[0]);
 
 		std::array<VkWriteDescriptorSet, 2> writeDescriptors;
 
@@ -236,19 +434,31 @@ namespace VkLibrary {
 		writeDescriptors[1] = computeSpec.Shader->FindWriteDescriptorSet("u_EquirectangularTex");
 		writeDescriptors[1].dstSet = computeDescriptorSet;
 		writeDescriptors[1].pImageInfo = &equirectangularInput->GetDescriptorImageInfo();
-		
-		Ref<VulkanDevice> device = Application::GetApp().GetVulkanDevice();
 
 		vkUpdateDescriptorSets(device->GetLogicalDevice(), writeDescriptors.size(), writeDescriptors.data(), 0, nullptr);
 		
-		VkCommandBuffer commandBuffer = device->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+		VkCommandBuffer commandBuffer = device->GetImmediateContext().GetCommandBuffer();
+
+		BarrierBatch barriers;
+		barriers.TransitionImage(*m_Image, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR);
+		barriers.Flush(commandBuffer);
 		
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, equiToCubeMapPipeline->GetPipeline());
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, equiToCubeMapPipeline->GetPipelineLayout(), 0, 1, &computeDescriptorSet, 0, nullptr);
 		
 		vkCmdDispatch(commandBuffer, m_Image->GetSpecification().Width / 32, m_Image->GetSpecification().Height / 32, 6);
+
+		// Cube map is read as environment by raster, compute and ray tracing shaders
+		barriers.TransitionImage(*m_Image, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+			VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR);
+		barriers.Flush(commandBuffer);
 		
-		device->FlushCommandBuffer(commandBuffer, true);
+		// Input texture is released through the deletion queue and the pipeline stays in the library, the set has to outlive the dispatch as well
+		device->GetDeletionQueue().Push([&descriptorAllocator, computeDescriptorSet]()
+		{
+			descriptorAllocator.Free(computeDescriptorSet);
+		});
 	}
 
 	TextureCube::~TextureCube()
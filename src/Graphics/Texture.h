@@ -5,15 +5,48 @@
 
 namespace VkLibrary {
 
+	// What the texture holds, compressed textures pick their format from it
+	// NormalXY only keeps x and y of the normal (BC5), the shader sampling it has to reconstruct z
+	enum class TextureRole
+	{
+		Color, MetallicRoughness, Normal, NormalXY
+	};
+
 	struct Texture2DSpecification
 	{
 		std::filesystem::path path;
 		bool sRGB = false;
 		bool compress = false;
+		TextureRole Role = TextureRole::Color;
+
+		// Loaded on worker threads, PlaceholderColor (RGBA8, red in the lowest byte) is sampled until the texture is resident
+		bool Async = false;
+		uint32_t PlaceholderColor = 0xffffffff;
 
 		std::string DebugName = "Texture2D";
 	};
 
+	// Texture contents on the CPU, Data holds MipLevels levels one after another and is owned by the caller
+	struct TextureData
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		ImageFormat Format = ImageFormat::NONE;
+		uint32_t MipLevels = 1;
+		VkComponentMapping Swizzle = {};
+		Buffer Data;
+	};
+
+	// Totals over all loaded textures, sampling a minified texture reads from the level closest to its footprint,
+	// so the bandwidth saved by mips and compression scales with these sizes as well
+	struct TextureMemoryStats
+	{
+		uint32_t TextureCount = 0;
+		uint64_t BaseBytes = 0;   // RGBA8 without mips
+		uint64_t MipBytes = 0;    // RGBA8 with mips
+		uint64_t LoadedBytes = 0; // Format the texture was loaded in, with mips
+	};
+
 	// TODO: Add support for multiple texture formats
 	// TODO: loading HDR images properly causes fire flys
 
@@ -29,11 +62,32 @@ namespace VkLibrary {
 		inline const VkDescriptorImageInfo& GetDescriptorImageInfo() const { return m_Image->GetDescriptorImageInfo(); }
 		inline const Texture2DSpecification& GetSpecification() const { return m_Specification; }
 
+		// Index into the bindless texture array, changes when the placeholder is replaced so it has to be read again once IsResident
+		inline uint32_t GetBindlessIndex() const { return m_BindlessIndex; }
+
+		// False while an async texture still shows its placeholder
+		inline bool IsResident() const { return m_Resident; }
+
+	public:
+		// Decodes or compresses on the CPU, safe to call from any thread
+		static TextureData LoadTextureData(const Texture2DSpecification& specification);
+		static Ref<Image> CreateImage(const Texture2DSpecification& specification, const TextureData& data);
+
+		static TextureMemoryStats GetMemoryStats();
+
+	private:
+		// Descriptors written with the previous image keep pointing at it, the image is registered in a new bindless slot
+		void SetImage(Ref<Image> image);
+
 	private:
 		std::filesystem::path m_Path;
 		Ref<Image> m_Image;
+		uint32_t m_BindlessIndex = UINT32_MAX;
+		bool m_Resident = true;
 
 		Texture2DSpecification m_Specification;
+
+		friend class TextureStreamer;
 	};
 
 	struct TextureCubeSpecification
@@ -57,8 +111,6 @@ namespace VkLibrary {
 		std::filesystem::path m_Path;
 		Ref<Image> m_Image;
 
-		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
-
 		TextureCubeSpecification m_Specification;
 	};
 
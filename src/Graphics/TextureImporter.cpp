@@ -1,40 +1,288 @@
 #include "pch.h"
 #include "TextureImporter.h"
 #include "Memory/FileIO.h"
+#include "Memory/MappedFile.h"
+#include <atomic>
 
 namespace VkLibrary
 {
+	static const uint32_t s_TextureFileVersion = 3;
+
+	static std::filesystem::path s_CacheDirectory = "cache/textures";
+	static std::atomic<uint32_t> s_NextTemporaryFile{ 0 };
+
+	namespace Utils {
+
+		// FNV-1a, stable between builds unlike std::hash
+		static uint64_t HashBytes(const void* data, uint64_t size, uint64_t hash = 14695981039346656037ull)
+		{
+			const uint8_t* bytes = (const uint8_t*)data;
+			for (uint64_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+
+		static uint64_t HashFile(const std::filesystem::path& path)
+		{
+			MappedFile file(path);
+			return file.IsValid() ? HashBytes(file.GetData(), file.GetSize()) : 0;
+		}
+
+		static int64_t GetWriteTime(const std::filesystem::path& path)
+		{
+			std::error_code error;
+			std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+			return error ? 0 : (int64_t)time.time_since_epoch().count();
+		}
+
+		// Patches the header in place, the rest of the file stays untouched
+		static void WriteSourceWriteTime(const std::filesystem::path& path, int64_t writeTime)
+		{
+			std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+			if (!stream)
+				return;
+
+			stream.seekp(offsetof(TextureFileHeader, SourceWriteTime));
+			stream.write((const char*)&writeTime, sizeof(writeTime));
+		}
+
+		static uint32_t PackSwizzle(const VkComponentMapping& swizzle)
+		{
+			return (uint32_t)swizzle.r | ((uint32_t)swizzle.g << 8) | ((uint32_t)swizzle.b << 16) | ((uint32_t)swizzle.a << 24);
+		}
+
+		static VkComponentMapping UnpackSwizzle(uint32_t swizzle)
+		{
+			VkComponentMapping result;
+			result.r = (VkComponentSwizzle)(swizzle & 0xff);
+			result.g = (VkComponentSwizzle)((swizzle >> 8) & 0xff);
+			result.b = (VkComponentSwizzle)((swizzle >> 16) & 0xff);
+			result.a = (VkComponentSwizzle)((swizzle >> 24) & 0xff);
+			return result;
+		}
+
+		static bool IsTextureFormat(ImageFormat format)
+		{
+			switch (format)
+			{
+			case ImageFormat::RGBA8:
+			case ImageFormat::SRGBA8:
+			case ImageFormat::BC7_SRGB:
+			case ImageFormat::RGBA32F:
+			case ImageFormat::BC7_UNORM:
+			case ImageFormat::BC1_SRGB:
+			case ImageFormat::BC1_UNORM:
+			case ImageFormat::BC4_UNORM:
+			case ImageFormat::BC5_UNORM:
+				return true;
+			}
+
+			return false;
+		}
+
+	}
+
 	TextureImporter::TextureImporter(const std::filesystem::path& path)
 		: m_Path(path)
 	{
 	}
 
 	Ref<Texture2D> TextureImporter::ImportTexture2D()
-	{	
-		FileReader reader(m_Path);
-		TextureFileHeader header = reader.ReadRaw<TextureFileHeader>();
-		Buffer buffer = reader.ReadBuffer();
+	{
+		TextureData data;
+		if (!Read(m_Path, data))
+			return nullptr;
 
 		ImageSpecification spec;
-		spec.Width = header.Width;
-		spec.Height = header.Height;
-		spec.Format = (ImageFormat)header.Format;
+		spec.Width = data.Width;
+		spec.Height = data.Height;
+		spec.Format = data.Format;
+		spec.Usage = ImageUsage::TEXTURE_2D;
+		spec.MipLevels = Image::IsCompressedFormat(data.Format) ? data.MipLevels : 0;
+		spec.Swizzle = data.Swizzle;
+		spec.DebugName = m_Path.filename().string();
 
-		Ref<Image> image = CreateRef<Image>(spec, buffer);
+		Ref<Image> image = CreateRef<Image>(spec, data.Data);
 		Ref<Texture2D> texture = CreateRef<Texture2D>(image);
 
+		// Data was copied into a staging buffer
+		data.Data.Release();
+
 		return texture;
 	}
 
 	void TextureImporter::SerializeTexture2D(Ref<Texture2D> texture)
 	{
-		FileWriter writer(m_Path);
+		Ref<Image> image = texture->GetImage();
+
+		// Generated levels only exist on the GPU
+		TextureData data;
+		data.Width = image->GetWidth();
+		data.Height = image->GetHeight();
+		data.Format = image->GetSpecification().Format;
+		data.MipLevels = Image::IsCompressedFormat(data.Format) ? image->GetMipLevels() : 1;
+		data.Swizzle = image->GetSpecification().Swizzle;
+		data.Data = image->GetBuffer();
+
+		Write(m_Path, data);
+	}
+
+	bool TextureImporter::Read(const std::filesystem::path& path, TextureData& outData, const std::filesystem::path& sourcePath)
+	{
+		if (!std::filesystem::exists(path))
+			return false;
+
+		uint64_t fileSize = std::filesystem::file_size(path);
+		if (fileSize < sizeof(TextureFileHeader))
+		{
+			LOG_WARN("{} is not a texture file", path.string());
+			return false;
+		}
+
+		FileReader reader(path);
+		TextureFileHeader header = reader.ReadRaw<TextureFileHeader>();
+
+		if (memcmp(header.HEADER, TextureFileHeader().HEADER, 4) != 0 || header.Version != s_TextureFileVersion)
+		{
+			LOG_WARN("{} is not a compatible texture file", path.string());
+			return false;
+		}
+
+		ImageFormat format = (ImageFormat)header.Format;
+		if (!Utils::IsTextureFormat(format) || header.Width == 0 || header.Height == 0 ||
+			header.MipLevels == 0 || header.MipLevels > Image::GetMipLevelCount(header.Width, header.Height))
+		{
+			LOG_WARN("{} has an invalid header", path.string());
+			return false;
+		}
+
+		if (fileSize < sizeof(TextureFileHeader) + header.MipLevels * sizeof(TextureFileLevel))
+		{
+			LOG_WARN("{} is truncated", path.string());
+			return false;
+		}
+
+		// Levels have to be packed in order and match the size of their format
+		uint64_t dataSize = 0;
+		for (uint32_t level = 0; level < header.MipLevels; level++)
+		{
+			TextureFileLevel levelEntry = reader.ReadRaw<TextureFileLevel>();
+			uint64_t expectedSize = Image::GetImageSize(format, std::max(header.Width >> level, 1u), std::max(header.Height >> level, 1u));
+
+			if (levelEntry.Offset != dataSize || levelEntry.Size != expectedSize)
+			{
+				LOG_WARN("{} has an invalid level table", path.string());
+				return false;
+			}
+
+			dataSize += levelEntry.Size;
+		}
+
+		if (fileSize != sizeof(TextureFileHeader) + header.MipLevels * sizeof(TextureFileLevel) + dataSize)
+		{
+			LOG_WARN("{} does not match its level table", path.string());
+			return false;
+		}
+
+		bool sourceTouched = false;
+		int64_t sourceWriteTime = 0;
+		if (!sourcePath.empty() && std::filesystem::exists(sourcePath))
+		{
+			sourceWriteTime = Utils::GetWriteTime(sourcePath);
+			if (sourceWriteTime != header.SourceWriteTime)
+			{
+				if (Utils::HashFile(sourcePath) != header.SourceHash)
+				{
+					LOG_INFO("{} is outdated, {} changed", path.string(), sourcePath.string());
+					return false;
+				}
+
+				sourceTouched = true;
+			}
+		}
+
+		outData.Width = header.Width;
+		outData.Height = header.Height;
+		outData.Format = format;
+		outData.MipLevels = header.MipLevels;
+		outData.Swizzle = Utils::UnpackSwizzle(header.Swizzle);
+		outData.Data.Allocate(dataSize);
+		reader.ReadData((char*)outData.Data.Data, dataSize);
+
+		// Touched without changes, store the new write time so later loads do not hash the source again
+		if (sourceTouched)
+			Utils::WriteSourceWriteTime(path, sourceWriteTime);
+
+		return true;
+	}
+
+	void TextureImporter::Write(const std::filesystem::path& path, const TextureData& data, const std::filesystem::path& sourcePath)
+	{
 		TextureFileHeader header;
-		header.Width = texture->GetImage()->GetWidth();
-		header.Height = texture->GetImage()->GetHeight();
-		header.Format = (uint32_t)texture->GetImage()->GetSpecification().Format;
-		writer.WriteRaw(header);
+		header.Version = s_TextureFileVersion;
+		header.Width = data.Width;
+		header.Height = data.Height;
+		header.Format = (uint32_t)data.Format;
+		header.MipLevels = data.MipLevels;
+		header.Swizzle = Utils::PackSwizzle(data.Swizzle);
+
+		if (!sourcePath.empty())
+		{
+			header.SourceHash = Utils::HashFile(sourcePath);
+			header.SourceWriteTime = Utils::GetWriteTime(sourcePath);
+		}
 
-		writer.WriteBuffer(texture->GetImage()->GetBuffer());
+		std::vector<TextureFileLevel> levels(data.MipLevels);
+		uint64_t dataSize = 0;
+		for (uint32_t level = 0; level < data.MipLevels; level++)
+		{
+			levels[level].Offset = dataSize;
+			levels[level].Size = Image::GetImageSize(data.Format, std::max(data.Width >> level, 1u), std::max(data.Height >> level, 1u));
+			dataSize += levels[level].Size;
+		}
+
+		ASSERT(dataSize <= data.Data.Size, "Texture data is smaller than its levels");
+
+		if (path.has_parent_path())
+			std::filesystem::create_directories(path.parent_path());
+
+		// Written next to the destination and renamed, an interrupted write never leaves a partial file behind
+		// Every writer gets its own temporary file, two threads caching the same texture must not write into one file
+		std::filesystem::path temporaryPath = fmt::format("{}.{}.tmp", path.string(), s_NextTemporaryFile++);
+		{
+			FileWriter writer(temporaryPath);
+			writer.WriteRaw(header);
+			writer.WriteData((const char*)levels.data(), levels.size() * sizeof(TextureFileLevel));
+			writer.WriteData((const char*)data.Data.Data, dataSize);
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			LOG_ERROR("Failed to write texture file {}: {}", path.string(), error.message());
+			std::filesystem::remove(temporaryPath, error);
+		}
+	}
+
+	void TextureImporter::SetCacheDirectory(const std::filesystem::path& directory)
+	{
+		s_CacheDirectory = directory;
+	}
+
+	const std::filesystem::path& TextureImporter::GetCacheDirectory()
+	{
+		return s_CacheDirectory;
+	}
+
+	std::filesystem::path TextureImporter::GetCachePath(const std::filesystem::path& sourcePath, const std::string& key)
+	{
+		// Sources with the same name in different folders get different caches
+		std::string source = sourcePath.lexically_normal().generic_string();
+		return s_CacheDirectory / fmt::format("{}_{}_{:016x}.vltx", sourcePath.filename().string(), key, Utils::HashBytes(source.data(), source.size()));
 	}
-}
\ No newline at end of file
+}
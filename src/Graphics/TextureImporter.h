@@ -8,21 +8,53 @@ namespace VkLibrary
 	struct TextureFileHeader
 	{
 		const char HEADER[4] = {'V', 'L', 'T', 'X'};
+		uint32_t Version = 0;
 		uint32_t Width = 0;
 		uint32_t Height = 0;
 		uint32_t Format = 0;
+		uint32_t MipLevels = 0;
+		uint32_t Swizzle = 0; // One byte per VkComponentSwizzle, red in the lowest byte
+		uint32_t Padding = 0;
+
+		// Source the file was created from, 0 if it was not created from a source file
+		uint64_t SourceHash = 0;
+		int64_t SourceWriteTime = 0;
 	};
 
+	// Offsets are relative to the first level, levels are stored one after another from the largest
+	struct TextureFileLevel
+	{
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+	};
+
+	// NOTE: Layout: header, one TextureFileLevel per mip level, level data
+	// Files are rejected if the header, version, format or level table do not match what the file contains
+	// Caches of a source image are stale once the source changed, the write time is compared first and the
+	// source is only hashed when it differs, so touching a file without changing it does not invalidate its cache
+	// The new write time is then written back into the header, the source is hashed once per touch and not on every load
+
 	class TextureImporter
 	{
 	public:
 		TextureImporter(const std::filesystem::path& path);
 		~TextureImporter() = default;
-		
+
 		Ref<Texture2D> ImportTexture2D();
 		void SerializeTexture2D(Ref<Texture2D> texture);
 
+	public:
+		// Returns false if the file is missing, invalid or, when sourcePath is given, older than the source
+		static bool Read(const std::filesystem::path& path, TextureData& outData, const std::filesystem::path& sourcePath = {});
+		static void Write(const std::filesystem::path& path, const TextureData& data, const std::filesystem::path& sourcePath = {});
+
+		// Processed textures are cached here instead of next to their source, defaults to cache/textures
+		static void SetCacheDirectory(const std::filesystem::path& directory);
+		static const std::filesystem::path& GetCacheDirectory();
+		// Key tells apart caches of the same source processed differently, e.g. by role or color space
+		static std::filesystem::path GetCachePath(const std::filesystem::path& sourcePath, const std::string& key);
+
 	private:
 		std::filesystem::path m_Path;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,238 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "Core/Application.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace VkLibrary {
+
+	struct TextureJob
+	{
+		// Cleared when the texture is destroyed before its job finished
+		Texture2D* Target = nullptr;
+		Texture2DSpecification Specification;
+		TextureData Data;
+	};
+
+	struct TextureStreamerData
+	{
+		std::mutex Mutex;
+		std::condition_variable Condition;
+
+		std::deque<Ref<TextureJob>> Pending;
+		std::vector<Ref<TextureJob>> InFlight;
+		std::deque<Ref<TextureJob>> Completed;
+
+		uint32_t MaxJobsInFlight = 1;
+		uint32_t MaxCompleted = 1;
+		bool ShuttingDown = false;
+
+		std::unordered_map<uint32_t, Ref<Image>> Placeholders;
+	};
+
+	static TextureStreamerData* s_Data = nullptr;
+
+	namespace Utils {
+
+		// Bytes uploaded per frame, the first finished texture is always uploaded so large textures are not starved
+		static const uint64_t s_UploadBudgetPerFrame = 64ull * 1024 * 1024;
+
+		static void RunJob(Ref<TextureJob> job);
+
+		// Called with the mutex held
+		static void DispatchJobs()
+		{
+			while (!s_Data->ShuttingDown && !s_Data->Pending.empty() &&
+				s_Data->InFlight.size() < s_Data->MaxJobsInFlight &&
+				s_Data->InFlight.size() + s_Data->Completed.size() < s_Data->MaxJobsInFlight + s_Data->MaxCompleted)
+			{
+				Ref<TextureJob> job = s_Data->Pending.front();
+				s_Data->Pending.pop_front();
+
+				if (!job->Target)
+					continue;
+
+				s_Data->InFlight.push_back(job);
+				Application::GetThreadPool().Submit([job]() { RunJob(job); });
+			}
+		}
+
+		static void RunJob(Ref<TextureJob> job)
+		{
+			job->Data = Texture2D::LoadTextureData(job->Specification);
+
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			s_Data->InFlight.erase(std::find(s_Data->InFlight.begin(), s_Data->InFlight.end(), job));
+
+			if (job->Target && !s_Data->ShuttingDown)
+				s_Data->Completed.push_back(job);
+			else
+				job->Data.Data.Release();
+
+			// Keeps the workers busy between frames, as long as the upload queue has room
+			DispatchJobs();
+
+			// Notified under the lock, Shutdown deletes the streamer as soon as the last job is done
+			s_Data->Condition.notify_all();
+		}
+
+		static void UploadJob(TextureJob& job)
+		{
+			if (job.Target)
+				job.Target->SetImage(Texture2D::CreateImage(job.Specification, job.Data));
+
+			job.Data.Data.Release();
+		}
+
+	}
+
+	void TextureStreamer::Init()
+	{
+		s_Data = new TextureStreamerData();
+
+		// One job per worker but one, the pool is shared with command recording, and as many finished ones again before workers stop picking up new ones
+		uint32_t threadCount = Application::GetThreadPool().GetThreadCount();
+		s_Data->MaxJobsInFlight = threadCount > 1 ? threadCount - 1 : 1;
+		s_Data->MaxCompleted = s_Data->MaxJobsInFlight;
+	}
+
+	void TextureStreamer::Shutdown()
+	{
+		{
+			std::unique_lock<std::mutex> lock(s_Data->Mutex);
+			s_Data->ShuttingDown = true;
+			s_Data->Pending.clear();
+
+			// Jobs reference the streamer, they have to finish before it goes away
+			s_Data->Condition.wait(lock, []() { return s_Data->InFlight.empty(); });
+
+			for (Ref<TextureJob>& job : s_Data->Completed)
+				job->Data.Data.Release();
+			s_Data->Completed.clear();
+		}
+
+		s_Data->Placeholders.clear();
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	void TextureStreamer::Load(Texture2D* texture)
+	{
+		Ref<TextureJob> job = CreateRef<TextureJob>();
+		job->Target = texture;
+		job->Specification = texture->GetSpecification();
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		s_Data->Pending.push_back(job);
+		Utils::DispatchJobs();
+	}
+
+	void TextureStreamer::Cancel(Texture2D* texture)
+	{
+		if (!s_Data)
+			return;
+
+		// Finished jobs of the texture are dropped by the worker or by Update
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		for (auto* jobs : { &s_Data->Pending, &s_Data->Completed })
+		{
+			for (Ref<TextureJob>& job : *jobs)
+			{
+				if (job->Target == texture)
+					job->Target = nullptr;
+			}
+		}
+
+		for (Ref<TextureJob>& job : s_Data->InFlight)
+		{
+			if (job->Target == texture)
+				job->Target = nullptr;
+		}
+	}
+
+	void TextureStreamer::Update()
+	{
+		std::vector<Ref<TextureJob>> uploads;
+
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+			uint64_t uploadedBytes = 0;
+			while (!s_Data->Completed.empty() && (uploads.empty() || uploadedBytes + s_Data->Completed.front()->Data.Data.Size <= Utils::s_UploadBudgetPerFrame))
+			{
+				uploadedBytes += s_Data->Completed.front()->Data.Data.Size;
+				uploads.push_back(s_Data->Completed.front());
+				s_Data->Completed.pop_front();
+			}
+
+			Utils::DispatchJobs();
+		}
+
+		// Images are created outside the lock so workers can hand in results meanwhile
+		for (Ref<TextureJob>& job : uploads)
+			Utils::UploadJob(*job);
+	}
+
+	void TextureStreamer::WaitIdle()
+	{
+		while (true)
+		{
+			std::vector<Ref<TextureJob>> uploads;
+
+			{
+				std::unique_lock<std::mutex> lock(s_Data->Mutex);
+				s_Data->Condition.wait(lock, []()
+				{
+					return !s_Data->Completed.empty() || (s_Data->Pending.empty() && s_Data->InFlight.empty());
+				});
+
+				if (s_Data->Completed.empty())
+					return;
+
+				uploads.assign(s_Data->Completed.begin(), s_Data->Completed.end());
+				s_Data->Completed.clear();
+				Utils::DispatchJobs();
+			}
+
+			for (Ref<TextureJob>& job : uploads)
+				Utils::UploadJob(*job);
+		}
+	}
+
+	Ref<Image> TextureStreamer::GetPlaceholder(uint32_t color)
+	{
+		auto it = s_Data->Placeholders.find(color);
+		if (it != s_Data->Placeholders.end())
+			return it->second;
+
+		ImageSpecification specification;
+		specification.Width = 1;
+		specification.Height = 1;
+		specification.Format = ImageFormat::RGBA8;
+		specification.Usage = ImageUsage::TEXTURE_2D;
+		specification.DebugName = fmt::format("Placeholder Texture {:08x}", color);
+
+		Ref<Image> placeholder = CreateRef<Image>(specification, Buffer(&color, sizeof(uint32_t)));
+		s_Data->Placeholders[color] = placeholder;
+		return placeholder;
+	}
+
+	TextureStreamerStats TextureStreamer::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		TextureStreamerStats stats;
+		stats.PendingCount = (uint32_t)s_Data->Pending.size();
+		stats.InFlightCount = (uint32_t)s_Data->InFlight.size();
+		stats.CompletedCount = (uint32_t)s_Data->Completed.size();
+		return stats;
+	}
+
+	bool TextureStreamer::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "Core/Core.h"
+#include "Texture.h"
+
+namespace VkLibrary {
+
+	struct TextureStreamerStats
+	{
+		uint32_t PendingCount = 0;   // Waiting for a worker
+		uint32_t InFlightCount = 0;  // Being decoded or compressed
+		uint32_t CompletedCount = 0; // Waiting for upload
+	};
+
+	// NOTE: Async textures are built in three stages, decode and compress on the application's thread pool and upload on the main thread
+	// One job per texture runs decode and compress back to back, jobs of different textures run on all workers but one at once
+	// Both queues are bounded: at most one job per worker but one is in flight and finished jobs only start new ones while few enough
+	// are waiting for upload, so a large scene never holds more than a handful of decoded images in memory
+	// The spare worker keeps ParallelCommandRecorder, which shares the pool, from waiting behind texture jobs
+	// Update uploads finished textures within a per frame budget, swaps them in for their placeholders and starts more jobs
+	// Textures have to be created and destroyed on the main thread
+
+	class TextureStreamer
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+
+		static void Load(Texture2D* texture);
+		static void Cancel(Texture2D* texture);
+
+		// Called once per frame
+		static void Update();
+
+		// Blocks until every requested texture is resident
+		static void WaitIdle();
+
+		// Shared 1x1 texture of the color, RGBA8 with red in the lowest byte
+		static Ref<Image> GetPlaceholder(uint32_t color);
+
+		static TextureStreamerStats GetStats();
+		static bool IsInitialized();
+	};
+
+}
@@ -0,0 +1,399 @@
+#include "pch.h"
+#include "UploadContext.h"
+#include "VulkanTools.h"
+#include "Core/Application.h"
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace VkLibrary {
+
+	struct PendingUpload
+	{
+		uint64_t Upload = 0;
+		VkFence Fence = VK_NULL_HANDLE;
+		VkSemaphore Semaphore = VK_NULL_HANDLE;
+		std::thread::id Thread;
+		VkCommandBuffer TransferCommandBuffer = VK_NULL_HANDLE;
+		VkCommandBuffer GraphicsCommandBuffer = VK_NULL_HANDLE;
+		std::vector<Ref<StagingBuffer>> StagingBuffers;
+	};
+
+	struct TransferCommandPool
+	{
+		VkCommandPool Pool = VK_NULL_HANDLE;
+
+		// Finished command buffers are freed by the owning thread, the pool is not touched from anywhere else
+		std::vector<VkCommandBuffer> FinishedCommandBuffers;
+	};
+
+	struct UploadContextData
+	{
+		VkDevice Device = VK_NULL_HANDLE;
+
+		VkQueue TransferQueue = VK_NULL_HANDLE;
+		VkQueue GraphicsQueue = VK_NULL_HANDLE;
+		uint32_t TransferFamily = 0;
+		uint32_t GraphicsFamily = 0;
+		bool OwnershipTransfer = false;
+
+		// Graphics pool is only used with the mutex held, transfer pools belong to the thread that begins batches
+		VkCommandPool GraphicsCommandPool = VK_NULL_HANDLE;
+		std::unordered_map<std::thread::id, Scope<TransferCommandPool>> TransferCommandPools;
+
+		// Shared with every other submitter of the device, the transfer queue can be the graphics queue
+		std::mutex* QueueMutex = nullptr;
+
+		std::mutex Mutex;
+		std::vector<VkFence> FreeFences;
+		std::vector<VkSemaphore> FreeSemaphores;
+
+		// Uploads finish in submission order, the front is always the oldest
+		std::deque<PendingUpload> Pending;
+		uint64_t NextUpload = 1;
+	};
+
+	static UploadContextData* s_Data = nullptr;
+
+	namespace Utils {
+
+		static VkCommandPool CreateCommandPool(VkDevice device, uint32_t queueFamily)
+		{
+			VkCommandPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = queueFamily;
+
+			VkCommandPool commandPool;
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool));
+			return commandPool;
+		}
+
+		static VkCommandBuffer BeginCommandBuffer(VkDevice device, VkCommandPool commandPool)
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer));
+
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+			return commandBuffer;
+		}
+
+		static VkFence GetFence()
+		{
+			if (!s_Data->FreeFences.empty())
+			{
+				VkFence fence = s_Data->FreeFences.back();
+				s_Data->FreeFences.pop_back();
+				VK_CHECK_RESULT(vkResetFences(s_Data->Device, 1, &fence));
+				return fence;
+			}
+
+			VkFenceCreateInfo fenceCreateInfo{};
+			fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			VkFence fence;
+			VK_CHECK_RESULT(vkCreateFence(s_Data->Device, &fenceCreateInfo, nullptr, &fence));
+			return fence;
+		}
+
+		static VkSemaphore GetSemaphore()
+		{
+			if (!s_Data->FreeSemaphores.empty())
+			{
+				VkSemaphore semaphore = s_Data->FreeSemaphores.back();
+				s_Data->FreeSemaphores.pop_back();
+				return semaphore;
+			}
+
+			VkSemaphoreCreateInfo semaphoreCreateInfo{};
+			semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			VkSemaphore semaphore;
+			VK_CHECK_RESULT(vkCreateSemaphore(s_Data->Device, &semaphoreCreateInfo, nullptr, &semaphore));
+			return semaphore;
+		}
+
+		// Expects the mutex to be held
+		static TransferCommandPool& GetTransferCommandPool()
+		{
+			Scope<TransferCommandPool>& pool = s_Data->TransferCommandPools[std::this_thread::get_id()];
+			if (!pool)
+			{
+				pool = CreateScope<TransferCommandPool>();
+				pool->Pool = CreateCommandPool(s_Data->Device, s_Data->TransferFamily);
+			}
+
+			return *pool;
+		}
+
+		static void RecycleUpload(PendingUpload& upload)
+		{
+			s_Data->TransferCommandPools.at(upload.Thread)->FinishedCommandBuffers.push_back(upload.TransferCommandBuffer);
+			if (upload.GraphicsCommandBuffer)
+				vkFreeCommandBuffers(s_Data->Device, s_Data->GraphicsCommandPool, 1, &upload.GraphicsCommandBuffer);
+
+			s_Data->FreeFences.push_back(upload.Fence);
+			if (upload.Semaphore)
+				s_Data->FreeSemaphores.push_back(upload.Semaphore);
+		}
+
+		// Expects the mutex to be held
+		static void RetireUploads(bool wait, uint64_t upload = UINT64_MAX)
+		{
+			while (!s_Data->Pending.empty())
+			{
+				PendingUpload& front = s_Data->Pending.front();
+
+				if (wait && front.Upload <= upload)
+					VK_CHECK_RESULT(vkWaitForFences(s_Data->Device, 1, &front.Fence, VK_TRUE, UINT64_MAX));
+				else if (vkGetFenceStatus(s_Data->Device, front.Fence) != VK_SUCCESS)
+					break;
+
+				RecycleUpload(front);
+				s_Data->Pending.pop_front();
+			}
+		}
+
+	}
+
+	void UploadContext::Init()
+	{
+		s_Data = new UploadContextData();
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		QueueFamilyIndices queueFamilyIndices = device->GetQueueFamilyIndices();
+
+		s_Data->Device = device->GetLogicalDevice();
+		s_Data->TransferQueue = device->GetTransferQueue();
+		s_Data->GraphicsQueue = device->GetGraphicsQueue();
+		s_Data->TransferFamily = queueFamilyIndices.Transfer;
+		s_Data->GraphicsFamily = queueFamilyIndices.Graphics;
+		s_Data->OwnershipTransfer = device->HasDedicatedTransferQueue();
+		s_Data->QueueMutex = &device->GetQueueMutex();
+
+		if (s_Data->OwnershipTransfer)
+			s_Data->GraphicsCommandPool = Utils::CreateCommandPool(s_Data->Device, s_Data->GraphicsFamily);
+
+		LOG_INFO("Uploads use {}", s_Data->OwnershipTransfer ? "a dedicated transfer queue" : "the graphics queue");
+	}
+
+	void UploadContext::Shutdown()
+	{
+		WaitIdle();
+
+		for (VkFence fence : s_Data->FreeFences)
+			vkDestroyFence(s_Data->Device, fence, nullptr);
+
+		for (VkSemaphore semaphore : s_Data->FreeSemaphores)
+			vkDestroySemaphore(s_Data->Device, semaphore, nullptr);
+
+		for (auto& [thread, pool] : s_Data->TransferCommandPools)
+			vkDestroyCommandPool(s_Data->Device, pool->Pool, nullptr);
+
+		if (s_Data->GraphicsCommandPool)
+			vkDestroyCommandPool(s_Data->Device, s_Data->GraphicsCommandPool, nullptr);
+
+		delete s_Data;
+		s_Data = nullptr;
+	}
+
+	UploadBatch UploadContext::Begin()
+	{
+		TransferCommandPool* pool = nullptr;
+		std::vector<VkCommandBuffer> finishedCommandBuffers;
+		{
+			std::lock_guard<std::mutex> lock(s_Data->Mutex);
+			pool = &Utils::GetTransferCommandPool();
+			finishedCommandBuffers.swap(pool->FinishedCommandBuffers);
+		}
+
+		// Only this thread records into or frees from its pool
+		if (!finishedCommandBuffers.empty())
+			vkFreeCommandBuffers(s_Data->Device, pool->Pool, (uint32_t)finishedCommandBuffers.size(), finishedCommandBuffers.data());
+
+		UploadBatch batch;
+		batch.CommandPool = pool->Pool;
+		batch.CommandBuffer = Utils::BeginCommandBuffer(s_Data->Device, pool->Pool);
+		return batch;
+	}
+
+	VkBuffer UploadContext::Stage(UploadBatch& batch, const void* data, uint32_t size, const std::string& debugName)
+	{
+		Ref<StagingBuffer> stagingBuffer = CreateRef<StagingBuffer>((void*)data, size, debugName);
+		batch.StagingBuffers.push_back(stagingBuffer);
+
+		return stagingBuffer->GetBuffer();
+	}
+
+	void UploadContext::ReleaseBuffer(UploadBatch& batch, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask)
+	{
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		if (!s_Data->OwnershipTransfer)
+		{
+			vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+			return;
+		}
+
+		barrier.srcQueueFamilyIndex = s_Data->TransferFamily;
+		barrier.dstQueueFamilyIndex = s_Data->GraphicsFamily;
+
+		// Release, the destination access is part of the acquire
+		VkBufferMemoryBarrier releaseBarrier = barrier;
+		releaseBarrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &releaseBarrier, 0, nullptr);
+
+		// Acquire, the source access is part of the release
+		barrier.srcAccessMask = 0;
+		batch.BufferAcquireBarriers.push_back(barrier);
+		batch.DstStageMask |= dstStageMask;
+	}
+
+	void UploadContext::ReleaseImage(UploadBatch& batch, VkImage image, const VkImageSubresourceRange& range, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask)
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = range;
+
+		if (!s_Data->OwnershipTransfer)
+		{
+			vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+			return;
+		}
+
+		barrier.srcQueueFamilyIndex = s_Data->TransferFamily;
+		barrier.dstQueueFamilyIndex = s_Data->GraphicsFamily;
+
+		// Both halves carry the same layout transition, it is only executed once
+		VkImageMemoryBarrier releaseBarrier = barrier;
+		releaseBarrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(batch.CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &releaseBarrier);
+
+		barrier.srcAccessMask = 0;
+		batch.ImageAcquireBarriers.push_back(barrier);
+		batch.DstStageMask |= dstStageMask;
+	}
+
+	uint64_t UploadContext::Submit(UploadBatch& batch)
+	{
+		ASSERT(batch.CommandBuffer != VK_NULL_HANDLE, "Upload batch was not started or was already submitted");
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		ASSERT(batch.CommandPool == Utils::GetTransferCommandPool().Pool, "Upload batch must be submitted on the thread that began it");
+
+		VK_CHECK_RESULT(vkEndCommandBuffer(batch.CommandBuffer));
+
+		PendingUpload pending;
+		pending.Upload = s_Data->NextUpload++;
+		pending.Fence = Utils::GetFence();
+		pending.Thread = std::this_thread::get_id();
+		pending.TransferCommandBuffer = batch.CommandBuffer;
+		pending.StagingBuffers = std::move(batch.StagingBuffers);
+
+		VkSubmitInfo transferSubmitInfo{};
+		transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmitInfo.commandBufferCount = 1;
+		transferSubmitInfo.pCommandBuffers = &pending.TransferCommandBuffer;
+
+		if (!s_Data->OwnershipTransfer)
+		{
+			std::lock_guard<std::mutex> queueLock(*s_Data->QueueMutex);
+			VK_CHECK_RESULT(vkQueueSubmit(s_Data->TransferQueue, 1, &transferSubmitInfo, pending.Fence));
+		}
+		else
+		{
+			pending.Semaphore = Utils::GetSemaphore();
+
+			transferSubmitInfo.signalSemaphoreCount = 1;
+			transferSubmitInfo.pSignalSemaphores = &pending.Semaphore;
+			{
+				std::lock_guard<std::mutex> queueLock(*s_Data->QueueMutex);
+				VK_CHECK_RESULT(vkQueueSubmit(s_Data->TransferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE));
+			}
+
+			// Acquire on the graphics queue, the barrier chains with the semaphore wait so later submissions see the data
+			VkPipelineStageFlags dstStageMask = batch.DstStageMask ? batch.DstStageMask : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			pending.GraphicsCommandBuffer = Utils::BeginCommandBuffer(s_Data->Device, s_Data->GraphicsCommandPool);
+			vkCmdPipelineBarrier(pending.GraphicsCommandBuffer, dstStageMask, dstStageMask, 0,
+				0, nullptr,
+				(uint32_t)batch.BufferAcquireBarriers.size(), batch.BufferAcquireBarriers.data(),
+				(uint32_t)batch.ImageAcquireBarriers.size(), batch.ImageAcquireBarriers.data());
+			VK_CHECK_RESULT(vkEndCommandBuffer(pending.GraphicsCommandBuffer));
+
+			VkSubmitInfo graphicsSubmitInfo{};
+			graphicsSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			graphicsSubmitInfo.waitSemaphoreCount = 1;
+			graphicsSubmitInfo.pWaitSemaphores = &pending.Semaphore;
+			graphicsSubmitInfo.pWaitDstStageMask = &dstStageMask;
+			graphicsSubmitInfo.commandBufferCount = 1;
+			graphicsSubmitInfo.pCommandBuffers = &pending.GraphicsCommandBuffer;
+
+			std::lock_guard<std::mutex> queueLock(*s_Data->QueueMutex);
+			VK_CHECK_RESULT(vkQueueSubmit(s_Data->GraphicsQueue, 1, &graphicsSubmitInfo, pending.Fence));
+		}
+
+		uint64_t upload = pending.Upload;
+		s_Data->Pending.push_back(std::move(pending));
+
+		batch = UploadBatch();
+		return upload;
+	}
+
+	bool UploadContext::IsComplete(uint64_t upload)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::RetireUploads(false);
+
+		return s_Data->Pending.empty() || upload < s_Data->Pending.front().Upload;
+	}
+
+	void UploadContext::Wait(uint64_t upload)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::RetireUploads(true, upload);
+	}
+
+	void UploadContext::WaitIdle()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::RetireUploads(true);
+	}
+
+	void UploadContext::Update()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		Utils::RetireUploads(false);
+	}
+
+	bool UploadContext::IsInitialized()
+	{
+		return s_Data != nullptr;
+	}
+
+}
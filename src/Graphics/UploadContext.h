@@ -0,0 +1,57 @@
+#pragma once
+#include "Core/Core.h"
+#include "VulkanBuffers.h"
+#include <vulkan/vulkan.h>
+
+namespace VkLibrary {
+
+	struct UploadBatch
+	{
+		// Recorded on the transfer queue family, only transfer commands are allowed
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+
+		// Acquire side of the ownership transfers, recorded on the graphics queue at submit
+		std::vector<VkBufferMemoryBarrier> BufferAcquireBarriers;
+		std::vector<VkImageMemoryBarrier> ImageAcquireBarriers;
+		VkPipelineStageFlags DstStageMask = 0;
+
+		// Kept alive until the copies have finished
+		std::vector<Ref<StagingBuffer>> StagingBuffers;
+	};
+
+	// NOTE: Copies are recorded and submitted on the transfer queue so streaming does not compete with rendering on the graphics queue
+	// When the device has a dedicated transfer family, resources are released on the transfer queue and acquired on the graphics queue,
+	// the acquire waits on a semaphore signaled by the copies. Graphics work submitted afterwards sees the uploaded data.
+	// Without a dedicated family everything runs on the graphics queue and a plain barrier is recorded instead
+	// Every thread records into its own transfer command pool, a batch must be recorded and submitted on the thread that began it
+
+	class UploadContext
+	{
+	public:
+		static void Init();
+		static void Shutdown();
+
+		static UploadBatch Begin();
+
+		// Creates a staging buffer owned by the batch and returns it as the copy source
+		static VkBuffer Stage(UploadBatch& batch, const void* data, uint32_t size, const std::string& debugName = "Upload Staging");
+
+		// Hands a written resource over to the graphics queue, dstStageMask and dstAccessMask describe its first use there
+		static void ReleaseBuffer(UploadBatch& batch, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask);
+		static void ReleaseImage(UploadBatch& batch, VkImage image, const VkImageSubresourceRange& range, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask);
+
+		// Submits without waiting, the returned value identifies the upload for IsComplete and Wait
+		static uint64_t Submit(UploadBatch& batch);
+
+		static bool IsComplete(uint64_t upload);
+		static void Wait(uint64_t upload);
+		static void WaitIdle();
+
+		// Recycles finished uploads, called once per frame
+		static void Update();
+
+		static bool IsInitialized();
+	};
+
+}
@@ -5,16 +5,74 @@
 #include "VulkanAllocator.h"
 #include "VulkanTools.h"
 #include "Core/Application.h"
+#include <mutex>
+#include <array>
 
 namespace VkLibrary {
 
+	struct AllocationRecord
+	{
+		std::string Tag;
+		AllocationCategory Category = AllocationCategory::General;
+		uint64_t Size = 0;
+	};
+
 	struct VulkanAllocatorData
 	{
 		VmaAllocator Allocator;
+		uint32_t FrameIndex = 0;
+
+		std::mutex Mutex;
+		std::unordered_map<VmaAllocation, AllocationRecord> Allocations;
+		std::unordered_map<std::string, AllocationStats> TagStats;
+		std::array<AllocationStats, (size_t)AllocationCategory::Count> CategoryStats;
+
+		// Heaps that already warned, cleared once usage drops back below the threshold
+		std::array<bool, VK_MAX_MEMORY_HEAPS> BudgetWarned{};
 	};
 
 	static VulkanAllocatorData* s_Data = nullptr;
 
+	namespace Utils {
+
+		static const float s_BudgetWarningThreshold = 0.9f;
+
+		static AllocationCategory GetBufferCategory(const VkBufferCreateInfo& bufferCreateInfo, VmaMemoryUsage usage)
+		{
+			VkBufferUsageFlags flags = bufferCreateInfo.usage;
+
+			if (flags & (VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR))
+				return AllocationCategory::AccelerationStructure;
+			if (flags & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+				return AllocationCategory::Geometry;
+			if (usage == VMA_MEMORY_USAGE_CPU_ONLY || flags == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+				return AllocationCategory::Staging;
+			if (flags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+				return AllocationCategory::Uniform;
+
+			return AllocationCategory::General;
+		}
+
+		static std::string EscapeJSON(const std::string& string)
+		{
+			std::string result;
+			result.reserve(string.size());
+			for (char c : string)
+			{
+				if (c == '"' || c == '\\')
+					result += '\\';
+
+				if ((unsigned char)c < 0x20)
+					result += ' ';
+				else
+					result += c;
+			}
+
+			return result;
+		}
+
+	}
+
 	VulkanAllocator::VulkanAllocator(const std::string& tag)
 		: m_Tag(tag)
 	{
@@ -24,18 +82,16 @@ namespace VkLibrary {
 	{
 	}
 
-	VmaAllocation VulkanAllocator::AllocateBuffer(const VkBufferCreateInfo& bufferCreateInfo, VmaMemoryUsage usage, VkBuffer& outBuffer)
+	VmaAllocation VulkanAllocator::AllocateBuffer(const VkBufferCreateInfo& bufferCreateInfo, VmaMemoryUsage usage, VkBuffer& outBuffer, VmaAllocationCreateFlags flags)
 	{
 		VmaAllocationCreateInfo allocCreateInfo = {};
 		allocCreateInfo.usage = usage;
+		allocCreateInfo.flags = flags;
 
 		VmaAllocation allocation;
 		VK_CHECK_RESULT(vmaCreateBuffer(s_Data->Allocator, &bufferCreateInfo, &allocCreateInfo, &outBuffer, &allocation, nullptr));
 
-		VmaAllocationInfo allocInfo;
-		vmaGetAllocationInfo(s_Data->Allocator, allocation, &allocInfo);
-	//	LOG_INFO("[{0}] - allocating image; size = {1}", m_Tag, allocInfo.size);
-
+		TrackAllocation(allocation, Utils::GetBufferCategory(bufferCreateInfo, usage));
 		return allocation;
 	}
 
@@ -47,28 +103,77 @@ namespace VkLibrary {
 		VmaAllocation allocation;
 		VK_CHECK_RESULT(vmaCreateImage(s_Data->Allocator, &imageCreateInfo, &allocCreateInfo, &outImage, &allocation, nullptr));
 
-		VmaAllocationInfo allocInfo;
-		vmaGetAllocationInfo(s_Data->Allocator, allocation, &allocInfo);
-	//	LOG_INFO("[{0}] - allocating image; size = {1}", m_Tag, allocInfo.size);
+		TrackAllocation(allocation, AllocationCategory::Texture);
+		return allocation;
+	}
+
+	VmaAllocation VulkanAllocator::AllocateMemory(const VkMemoryRequirements& requirements, VmaMemoryUsage usage, AllocationCategory category)
+	{
+		VmaAllocationCreateInfo allocCreateInfo = {};
+		allocCreateInfo.usage = usage;
 
+		VmaAllocation allocation;
+		VK_CHECK_RESULT(vmaAllocateMemory(s_Data->Allocator, &requirements, &allocCreateInfo, &allocation, nullptr));
+
+		TrackAllocation(allocation, category);
 		return allocation;
 	}
 
+	void VulkanAllocator::BindBufferMemory(VmaAllocation allocation, VkBuffer buffer)
+	{
+		VK_CHECK_RESULT(vmaBindBufferMemory(s_Data->Allocator, allocation, buffer));
+	}
+
+	void VulkanAllocator::BindImageMemory(VmaAllocation allocation, VkImage image)
+	{
+		VK_CHECK_RESULT(vmaBindImageMemory(s_Data->Allocator, allocation, image));
+	}
+
 	void VulkanAllocator::DestroyBuffer(VkBuffer buffer, VmaAllocation allocation)
 	{
+		UntrackAllocation(allocation);
 		vmaDestroyBuffer(s_Data->Allocator, buffer, allocation);
 	}
 
 	void VulkanAllocator::DestroyImage(VkImage image, VmaAllocation allocation)
 	{
+		UntrackAllocation(allocation);
 		vmaDestroyImage(s_Data->Allocator, image, allocation);
 	}
 
+	void VulkanAllocator::FreeMemory(VmaAllocation allocation)
+	{
+		UntrackAllocation(allocation);
+		vmaFreeMemory(s_Data->Allocator, allocation);
+	}
+
 	void VulkanAllocator::UnmapMemory(VmaAllocation allocation)
 	{
 		vmaUnmapMemory(s_Data->Allocator, allocation);
 	}
 
+	void* VulkanAllocator::GetMappedData(VmaAllocation allocation)
+	{
+		VmaAllocationInfo allocInfo;
+		vmaGetAllocationInfo(s_Data->Allocator, allocation, &allocInfo);
+		return allocInfo.pMappedData;
+	}
+
+	bool VulkanAllocator::IsHostCoherent(VmaAllocation allocation)
+	{
+		VmaAllocationInfo allocInfo;
+		vmaGetAllocationInfo(s_Data->Allocator, allocation, &allocInfo);
+
+		VkMemoryPropertyFlags memoryFlags;
+		vmaGetMemoryTypeProperties(s_Data->Allocator, allocInfo.memoryType, &memoryFlags);
+		return memoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	void VulkanAllocator::FlushAllocation(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		VK_CHECK_RESULT(vmaFlushAllocation(s_Data->Allocator, allocation, offset, size));
+	}
+
 	void VulkanAllocator::Init(Ref<VulkanDevice> device)
 	{
 		s_Data = new VulkanAllocatorData();
@@ -79,12 +184,21 @@ namespace VkLibrary {
 		allocatorInfo.device = device->GetLogicalDevice();
 		allocatorInfo.instance = Application::GetVulkanInstance()->GetInstanceHandle();
 		allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+		if (device->IsMemoryBudgetSupported())
+			allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 
 		vmaCreateAllocator(&allocatorInfo, &s_Data->Allocator);
 	}
 
 	void VulkanAllocator::Shutdown()
 	{
+		if (!s_Data->Allocations.empty())
+		{
+			LOG_WARN("{} allocations were not freed before shutdown", s_Data->Allocations.size());
+			for (const auto& [allocation, record] : s_Data->Allocations)
+				LOG_WARN("    [{}] {} bytes ({})", record.Tag, record.Size, AllocationCategoryToString(record.Category));
+		}
+
 		vmaDestroyAllocator(s_Data->Allocator);
 
 		delete s_Data;
@@ -104,4 +218,179 @@ namespace VkLibrary {
 		buffer_device_address_info.buffer = handle;
 		return vkGetBufferDeviceAddressKHR(device, &buffer_device_address_info);
 	}
+
+	void VulkanAllocator::TrackAllocation(VmaAllocation allocation, AllocationCategory category)
+	{
+		VmaAllocationInfo allocInfo;
+		vmaGetAllocationInfo(s_Data->Allocator, allocation, &allocInfo);
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		AllocationRecord& record = s_Data->Allocations[allocation];
+		record.Tag = m_Tag;
+		record.Category = category;
+		record.Size = allocInfo.size;
+
+		AllocationStats& tagStats = s_Data->TagStats[m_Tag];
+		tagStats.Bytes += record.Size;
+		tagStats.Count++;
+
+		AllocationStats& categoryStats = s_Data->CategoryStats[(size_t)category];
+		categoryStats.Bytes += record.Size;
+		categoryStats.Count++;
+	}
+
+	void VulkanAllocator::UntrackAllocation(VmaAllocation allocation)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		// Records are found by allocation, the tag of the destroying allocator does not have to match
+		auto it = s_Data->Allocations.find(allocation);
+		if (it == s_Data->Allocations.end())
+			return;
+
+		const AllocationRecord& record = it->second;
+
+		auto tagIt = s_Data->TagStats.find(record.Tag);
+		tagIt->second.Bytes -= record.Size;
+		tagIt->second.Count--;
+		if (tagIt->second.Count == 0)
+			s_Data->TagStats.erase(tagIt);
+
+		AllocationStats& categoryStats = s_Data->CategoryStats[(size_t)record.Category];
+		categoryStats.Bytes -= record.Size;
+		categoryStats.Count--;
+
+		s_Data->Allocations.erase(it);
+	}
+
+	void VulkanAllocator::BeginFrame()
+	{
+		vmaSetCurrentFrameIndex(s_Data->Allocator, ++s_Data->FrameIndex);
+
+		for (const HeapBudget& heap : GetHeapBudgets())
+		{
+			if (heap.Budget == 0)
+				continue;
+
+			bool overThreshold = heap.Usage > (uint64_t)(heap.Budget * Utils::s_BudgetWarningThreshold);
+			if (overThreshold && !s_Data->BudgetWarned[heap.HeapIndex])
+			{
+				LOG_WARN("Memory heap {} ({}) is at {} / {} MB of its budget", heap.HeapIndex, heap.DeviceLocal ? "device local" : "host",
+					heap.Usage >> 20, heap.Budget >> 20);
+			}
+
+			s_Data->BudgetWarned[heap.HeapIndex] = overThreshold;
+		}
+	}
+
+	std::unordered_map<std::string, AllocationStats> VulkanAllocator::GetTagStats()
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		return s_Data->TagStats;
+	}
+
+	AllocationStats VulkanAllocator::GetCategoryStats(AllocationCategory category)
+	{
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+		return s_Data->CategoryStats[(size_t)category];
+	}
+
+	std::vector<HeapBudget> VulkanAllocator::GetHeapBudgets()
+	{
+		const VkPhysicalDeviceMemoryProperties* memoryProperties;
+		vmaGetMemoryProperties(s_Data->Allocator, &memoryProperties);
+
+		std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets;
+		vmaGetBudget(s_Data->Allocator, budgets.data());
+
+		std::vector<HeapBudget> heapBudgets(memoryProperties->memoryHeapCount);
+		for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+		{
+			HeapBudget& heap = heapBudgets[i];
+			heap.HeapIndex = i;
+			heap.DeviceLocal = memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+			heap.Size = memoryProperties->memoryHeaps[i].size;
+			heap.Budget = budgets[i].budget;
+			heap.Usage = budgets[i].usage;
+			heap.AllocationBytes = budgets[i].allocationBytes;
+			heap.BlockBytes = budgets[i].blockBytes;
+		}
+
+		return heapBudgets;
+	}
+
+	std::string VulkanAllocator::GenerateReport()
+	{
+		std::stringstream ss;
+		ss << "{\n";
+
+		ss << "\t\"heaps\": [\n";
+		std::vector<HeapBudget> heaps = GetHeapBudgets();
+		for (size_t i = 0; i < heaps.size(); i++)
+		{
+			const HeapBudget& heap = heaps[i];
+			ss << "\t\t{ \"index\": " << heap.HeapIndex << ", \"deviceLocal\": " << (heap.DeviceLocal ? "true" : "false")
+				<< ", \"size\": " << heap.Size << ", \"budget\": " << heap.Budget << ", \"usage\": " << heap.Usage
+				<< ", \"allocationBytes\": " << heap.AllocationBytes << ", \"blockBytes\": " << heap.BlockBytes << " }"
+				<< (i + 1 < heaps.size() ? "," : "") << "\n";
+		}
+		ss << "\t],\n";
+
+		std::lock_guard<std::mutex> lock(s_Data->Mutex);
+
+		ss << "\t\"categories\": {\n";
+		for (size_t i = 0; i < (size_t)AllocationCategory::Count; i++)
+		{
+			const AllocationStats& stats = s_Data->CategoryStats[i];
+			ss << "\t\t\"" << AllocationCategoryToString((AllocationCategory)i) << "\": { \"bytes\": " << stats.Bytes << ", \"count\": " << stats.Count << " }"
+				<< (i + 1 < (size_t)AllocationCategory::Count ? "," : "") << "\n";
+		}
+		ss << "\t},\n";
+
+		// Largest consumers first
+		std::vector<std::pair<std::string, AllocationStats>> tags(s_Data->TagStats.begin(), s_Data->TagStats.end());
+		std::sort(tags.begin(), tags.end(), [](const auto& a, const auto& b) { return a.second.Bytes > b.second.Bytes; });
+
+		ss << "\t\"tags\": [\n";
+		for (size_t i = 0; i < tags.size(); i++)
+		{
+			ss << "\t\t{ \"tag\": \"" << Utils::EscapeJSON(tags[i].first) << "\", \"bytes\": " << tags[i].second.Bytes << ", \"count\": " << tags[i].second.Count << " }"
+				<< (i + 1 < tags.size() ? "," : "") << "\n";
+		}
+		ss << "\t]\n";
+
+		ss << "}\n";
+		return ss.str();
+	}
+
+	bool VulkanAllocator::WriteReport(const std::filesystem::path& path)
+	{
+		std::ofstream stream(path);
+		if (!stream)
+		{
+			LOG_ERROR("Could not write memory report to {}", path.string());
+			return false;
+		}
+
+		stream << GenerateReport();
+		LOG_INFO("Memory report written to {}", path.string());
+		return true;
+	}
+
+	const char* VulkanAllocator::AllocationCategoryToString(AllocationCategory category)
+	{
+		switch (category)
+		{
+		case AllocationCategory::General:               return "General";
+		case AllocationCategory::Texture:               return "Texture";
+		case AllocationCategory::Geometry:              return "Geometry";
+		case AllocationCategory::AccelerationStructure: return "AccelerationStructure";
+		case AllocationCategory::Staging:               return "Staging";
+		case AllocationCategory::Uniform:               return "Uniform";
+		case AllocationCategory::Transient:             return "Transient";
+		}
+
+		return "Unknown";
+	}
 }
\ No newline at end of file
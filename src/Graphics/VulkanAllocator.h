@@ -5,6 +5,31 @@
 
 namespace VkLibrary {
 
+	// Derived from buffer usage flags, images always count as textures
+	// Transient is memory shared by render graph resources with non overlapping lifetimes
+	enum class AllocationCategory
+	{
+		General = 0, Texture, Geometry, AccelerationStructure, Staging, Uniform, Transient, Count
+	};
+
+	struct AllocationStats
+	{
+		uint64_t Bytes = 0;
+		uint32_t Count = 0;
+	};
+
+	struct HeapBudget
+	{
+		uint32_t HeapIndex = 0;
+		bool DeviceLocal = false;
+
+		uint64_t Size = 0;
+		uint64_t Budget = 0; // Estimated memory available to the application
+		uint64_t Usage = 0;  // Estimated memory used by the application, including memory not allocated through VMA
+		uint64_t AllocationBytes = 0;
+		uint64_t BlockBytes = 0;
+	};
+
 	class VulkanAllocator
 	{
 	public:
@@ -12,11 +37,17 @@ namespace VkLibrary {
 		~VulkanAllocator();
 
 	public:
-		VmaAllocation AllocateBuffer(const VkBufferCreateInfo& bufferCreateInfo, VmaMemoryUsage usage, VkBuffer& outBuffer);
+		VmaAllocation AllocateBuffer(const VkBufferCreateInfo& bufferCreateInfo, VmaMemoryUsage usage, VkBuffer& outBuffer, VmaAllocationCreateFlags flags = 0);
 		VmaAllocation AllocateImage(const VkImageCreateInfo& imageCreateInfo, VmaMemoryUsage usage, VkImage& outImage);
+
+		// Raw memory that resources are bound to afterwards, multiple resources may be bound to the same allocation
+		VmaAllocation AllocateMemory(const VkMemoryRequirements& requirements, VmaMemoryUsage usage, AllocationCategory category);
+		void BindBufferMemory(VmaAllocation allocation, VkBuffer buffer);
+		void BindImageMemory(VmaAllocation allocation, VkImage image);
 		
 		void DestroyBuffer(VkBuffer buffer, VmaAllocation allocation);
 		void DestroyImage(VkImage image, VmaAllocation allocation);
+		void FreeMemory(VmaAllocation allocation);
 
 		template<typename T>
 		T* MapMemory(VmaAllocation allocation)
@@ -28,6 +59,11 @@ namespace VkLibrary {
 
 		void UnmapMemory(VmaAllocation allocation);
 
+		// Only valid for allocations created with VMA_ALLOCATION_CREATE_MAPPED_BIT
+		void* GetMappedData(VmaAllocation allocation);
+		bool IsHostCoherent(VmaAllocation allocation);
+		void FlushAllocation(VmaAllocation allocation, VkDeviceSize offset, VkDeviceSize size);
+
 	public:
 		static void Init(Ref<VulkanDevice> device);
 		static void Shutdown();
@@ -35,6 +71,23 @@ namespace VkLibrary {
 		static VmaAllocator& GetVMAAllocator();
 
 		static uint64_t GetBufferDeviceAddress(VkBuffer handle);
+
+		// Refreshes budgets and warns once usage of a heap crosses the warning threshold
+		static void BeginFrame();
+
+		static std::unordered_map<std::string, AllocationStats> GetTagStats();
+		static AllocationStats GetCategoryStats(AllocationCategory category);
+		static std::vector<HeapBudget> GetHeapBudgets();
+
+		static std::string GenerateReport();
+		static bool WriteReport(const std::filesystem::path& path);
+
+		static const char* AllocationCategoryToString(AllocationCategory category);
+
+	private:
+		void TrackAllocation(VmaAllocation allocation, AllocationCategory category);
+		void UntrackAllocation(VmaAllocation allocation);
+
 	private:
 		std::string m_Tag;
 	};
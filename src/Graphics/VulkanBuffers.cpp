@@ -1,9 +1,52 @@
 #include "pch.h"
 #include "VulkanBuffers.h"
 #include "VulkanTools.h"
+#include "BindlessDescriptorHeap.h"
+#include "Core/Application.h"
 
 namespace VkLibrary {
 
+    namespace Utils {
+
+        static void CreateMappedBuffer(const VkBufferCreateInfo& bufferCreateInfo, VmaMemoryUsage usage, const std::string& debugName, BufferInfo& outBufferInfo)
+        {
+            VulkanAllocator allocator(debugName);
+            outBufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, usage, outBufferInfo.Buffer, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+            outBufferInfo.MappedData = allocator.GetMappedData(outBufferInfo.Allocation);
+            outBufferInfo.HostCoherent = allocator.IsHostCoherent(outBufferInfo.Allocation);
+
+            VkTools::SetBufferName(outBufferInfo.Buffer, debugName.c_str());
+        }
+
+        static void FlushBuffer(const BufferInfo& bufferInfo, uint32_t offset, uint32_t size)
+        {
+            if (bufferInfo.HostCoherent || size == 0)
+                return;
+
+            VulkanAllocator allocator("Buffer");
+            allocator.FlushAllocation(bufferInfo.Allocation, offset, size);
+        }
+
+        static void WriteBuffer(const BufferInfo& bufferInfo, uint32_t bufferSize, const void* data, uint32_t offset, uint32_t size)
+        {
+            ASSERT(offset + size <= bufferSize, "Buffer write out of range");
+
+            memcpy((uint8_t*)bufferInfo.MappedData + offset, data, size);
+            FlushBuffer(bufferInfo, offset, size);
+        }
+
+        // Buffers bound in frames still in flight are destroyed once those frames have finished
+        static void DestroyBufferDeferred(const BufferInfo& bufferInfo, const std::string& debugName)
+        {
+            Application::GetVulkanDevice()->GetDeletionQueue().Push([bufferInfo, debugName]()
+            {
+                VulkanAllocator allocator(debugName);
+                allocator.DestroyBuffer(bufferInfo.Buffer, bufferInfo.Allocation);
+            });
+        }
+
+    }
+
     VertexBuffer::VertexBuffer(void* data, uint32_t size, const std::string& debugName)
         : m_Size(size), m_DebugName(debugName)
     {
@@ -13,31 +56,30 @@ namespace VkLibrary {
         bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VulkanAllocator allocator(m_DebugName);
-        m_BufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_BufferInfo.Buffer);
-
-        VkTools::SetBufferName(m_BufferInfo.Buffer, m_DebugName.c_str());
+        Utils::CreateMappedBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_DebugName, m_BufferInfo);
 
         if (data)
-        {
-            void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-            memcpy(dstBuffer, data, m_Size);
-            allocator.UnmapMemory(m_BufferInfo.Allocation);
-        }
+            Utils::WriteBuffer(m_BufferInfo, m_Size, data, 0, m_Size);
     }
 
     VertexBuffer::~VertexBuffer()
     {
-        VulkanAllocator allocator(m_DebugName);
-        allocator.DestroyBuffer(m_BufferInfo.Buffer, m_BufferInfo.Allocation);
+        Utils::DestroyBufferDeferred(m_BufferInfo, m_DebugName);
     }
 
     void VertexBuffer::SetData(void* data)
     {
-        VulkanAllocator allocator("VertexBuffer");
-        void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-        memcpy(dstBuffer, data, m_Size);
-        allocator.UnmapMemory(m_BufferInfo.Allocation);
+        SetData(data, 0, m_Size);
+    }
+
+    void VertexBuffer::SetData(const void* data, uint32_t offset, uint32_t size)
+    {
+        Utils::WriteBuffer(m_BufferInfo, m_Size, data, offset, size);
+    }
+
+    void VertexBuffer::Flush(uint32_t offset, uint32_t size)
+    {
+        Utils::FlushBuffer(m_BufferInfo, offset, size);
     }
 
     IndexBuffer::IndexBuffer(void* data, uint32_t size, uint32_t count, const std::string& debugName)
@@ -49,31 +91,30 @@ namespace VkLibrary {
         bufferCreateInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VulkanAllocator allocator(m_DebugName);
-        m_BufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_BufferInfo.Buffer);
-
-        VkTools::SetBufferName(m_BufferInfo.Buffer, m_DebugName.c_str());
+        Utils::CreateMappedBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_DebugName, m_BufferInfo);
 
         if (data)
-        {
-            void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-            memcpy(dstBuffer, data, size);
-            allocator.UnmapMemory(m_BufferInfo.Allocation);
-        }
+            Utils::WriteBuffer(m_BufferInfo, m_Size, data, 0, m_Size);
     }
 
     IndexBuffer::~IndexBuffer()
     {
-        VulkanAllocator allocator(m_DebugName);
-        allocator.DestroyBuffer(m_BufferInfo.Buffer, m_BufferInfo.Allocation);
+        Utils::DestroyBufferDeferred(m_BufferInfo, m_DebugName);
     }
 
     void IndexBuffer::SetData(void* data)
     {
-        VulkanAllocator allocator("IndexBuffer");
-        void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-        memcpy(dstBuffer, data, m_Size);
-        allocator.UnmapMemory(m_BufferInfo.Allocation);
+        SetData(data, 0, m_Size);
+    }
+
+    void IndexBuffer::SetData(const void* data, uint32_t offset, uint32_t size)
+    {
+        Utils::WriteBuffer(m_BufferInfo, m_Size, data, offset, size);
+    }
+
+    void IndexBuffer::Flush(uint32_t offset, uint32_t size)
+    {
+        Utils::FlushBuffer(m_BufferInfo, offset, size);
     }
 
     StagingBuffer::StagingBuffer(void* data, uint32_t size, const std::string& debugName)
@@ -85,31 +126,32 @@ namespace VkLibrary {
         bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VulkanAllocator allocator(m_DebugName);
-        m_BufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_ONLY, m_BufferInfo.Buffer);
-
-        VkTools::SetBufferName(m_BufferInfo.Buffer, m_DebugName.c_str());
+        Utils::CreateMappedBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_ONLY, m_DebugName, m_BufferInfo);
 
         if (data)
-        {
-            void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-            memcpy(dstBuffer, data, size);
-            allocator.UnmapMemory(m_BufferInfo.Allocation);
-        }
+            Utils::WriteBuffer(m_BufferInfo, m_Size, data, 0, m_Size);
     }
 
     StagingBuffer::~StagingBuffer()
     {
+        // Copies from staging buffers are waited on before they go out of scope, destroy right away so load time memory does not pile up
         VulkanAllocator allocator(m_DebugName);
         allocator.DestroyBuffer(m_BufferInfo.Buffer, m_BufferInfo.Allocation);
     }
 
     void StagingBuffer::SetData(void* data)
     {
-        VulkanAllocator allocator("StagingBuffer");
-        void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-        memcpy(dstBuffer, data, m_Size);
-        allocator.UnmapMemory(m_BufferInfo.Allocation);
+        SetData(data, 0, m_Size);
+    }
+
+    void StagingBuffer::SetData(const void* data, uint32_t offset, uint32_t size)
+    {
+        Utils::WriteBuffer(m_BufferInfo, m_Size, data, offset, size);
+    }
+
+    void StagingBuffer::Flush(uint32_t offset, uint32_t size)
+    {
+        Utils::FlushBuffer(m_BufferInfo, offset, size);
     }
 
     UniformBuffer::UniformBuffer(void* data, uint32_t size, const std::string& debugName)
@@ -121,35 +163,34 @@ namespace VkLibrary {
         bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
         bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VulkanAllocator allocator(m_DebugName);
-        m_BufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_BufferInfo.Buffer);
-
-        VkTools::SetBufferName(m_BufferInfo.Buffer, m_DebugName.c_str());
+        Utils::CreateMappedBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_DebugName, m_BufferInfo);
 
         m_DescriptorBufferInfo.buffer = m_BufferInfo.Buffer;
         m_DescriptorBufferInfo.offset = 0;
         m_DescriptorBufferInfo.range = size;
 
         if (data)
-        {
-            void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-            memcpy(dstBuffer, data, size);
-            allocator.UnmapMemory(m_BufferInfo.Allocation);
-        }
+            Utils::WriteBuffer(m_BufferInfo, m_Size, data, 0, m_Size);
     }
 
     UniformBuffer::~UniformBuffer()
     {
-        VulkanAllocator allocator(m_DebugName);
-        allocator.DestroyBuffer(m_BufferInfo.Buffer, m_BufferInfo.Allocation);
+        Utils::DestroyBufferDeferred(m_BufferInfo, m_DebugName);
     }
 
     void UniformBuffer::SetData(void* data)
     {
-        VulkanAllocator allocator("UniformBuffer");
-        void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-        memcpy(dstBuffer, data, m_Size);
-        allocator.UnmapMemory(m_BufferInfo.Allocation);
+        SetData(data, 0, m_Size);
+    }
+
+    void UniformBuffer::SetData(const void* data, uint32_t offset, uint32_t size)
+    {
+        Utils::WriteBuffer(m_BufferInfo, m_Size, data, offset, size);
+    }
+
+    void UniformBuffer::Flush(uint32_t offset, uint32_t size)
+    {
+        Utils::FlushBuffer(m_BufferInfo, offset, size);
     }
 
     StorageBuffer::StorageBuffer(void* data, uint32_t size, const std::string& debugName)
@@ -161,35 +202,38 @@ namespace VkLibrary {
         bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VulkanAllocator allocator(m_DebugName);
-        m_BufferInfo.Allocation = allocator.AllocateBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_BufferInfo.Buffer);
-
-        VkTools::SetBufferName(m_BufferInfo.Buffer, m_DebugName.c_str());
+        Utils::CreateMappedBuffer(bufferCreateInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, m_DebugName, m_BufferInfo);
 
         m_DescriptorBufferInfo.buffer = m_BufferInfo.Buffer;
         m_DescriptorBufferInfo.offset = 0;
         m_DescriptorBufferInfo.range = m_Size;
 
         if (data)
-        {
-            void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-            memcpy(dstBuffer, data, m_Size);
-            allocator.UnmapMemory(m_BufferInfo.Allocation);
-        }
+            Utils::WriteBuffer(m_BufferInfo, m_Size, data, 0, m_Size);
+
+        if (BindlessDescriptorHeap::IsInitialized())
+            m_BindlessIndex = BindlessDescriptorHeap::RegisterStorageBuffer(m_DescriptorBufferInfo);
     }
 
     StorageBuffer::~StorageBuffer()
     {
-        VulkanAllocator allocator(m_DebugName);
-        allocator.DestroyBuffer(m_BufferInfo.Buffer, m_BufferInfo.Allocation);
+        BindlessDescriptorHeap::ReleaseStorageBuffer(m_BindlessIndex);
+        Utils::DestroyBufferDeferred(m_BufferInfo, m_DebugName);
     }
 
     void StorageBuffer::SetData(void* data)
     {
-        VulkanAllocator allocator("StorageBuffer");
-        void* dstBuffer = allocator.MapMemory<void>(m_BufferInfo.Allocation);
-        memcpy(dstBuffer, data, m_Size);
-        allocator.UnmapMemory(m_BufferInfo.Allocation);
+        SetData(data, 0, m_Size);
+    }
+
+    void StorageBuffer::SetData(const void* data, uint32_t offset, uint32_t size)
+    {
+        Utils::WriteBuffer(m_BufferInfo, m_Size, data, offset, size);
+    }
+
+    void StorageBuffer::Flush(uint32_t offset, uint32_t size)
+    {
+        Utils::FlushBuffer(m_BufferInfo, offset, size);
     }
 
 }
\ No newline at end of file
@@ -8,6 +8,10 @@ namespace VkLibrary {
 	{
 		VkBuffer Buffer = nullptr;
 		VmaAllocation Allocation = nullptr;
+
+		// Host visible buffers stay mapped for their lifetime
+		void* MappedData = nullptr;
+		bool HostCoherent = true;
 	};
 	
 	// TODO: Increase buffer flexibility through specifications and enums
@@ -23,19 +27,14 @@ namespace VkLibrary {
 		uint32_t GetSize() { return m_Size; }
 
 		void SetData(void* data);
+		void SetData(const void* data, uint32_t offset, uint32_t size);
 
 		template<typename T>
-		T* Map()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return (T*)allocator.MapMemory<T>(m_BufferInfo.Allocation);
-		}
-
-		void Unmap()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return allocator.UnmapMemory(m_BufferInfo.Allocation);
-		}
+		T* Map() { return (T*)m_BufferInfo.MappedData; }
+
+		// Buffer stays mapped, writes through Map are flushed here
+		void Unmap() { Flush(0, m_Size); }
+		void Flush(uint32_t offset, uint32_t size);
 		
 	private:
 		BufferInfo m_BufferInfo;
@@ -55,19 +54,14 @@ namespace VkLibrary {
 		uint32_t GetCount() { return m_Count; }
 
 		void SetData(void* data);
+		void SetData(const void* data, uint32_t offset, uint32_t size);
 
 		template<typename T>
-		T* Map()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return (T*)allocator.MapMemory<T>(m_BufferInfo.Allocation);
-		}
-
-		void Unmap()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return allocator.UnmapMemory(m_BufferInfo.Allocation);
-		}
+		T* Map() { return (T*)m_BufferInfo.MappedData; }
+
+		// Buffer stays mapped, writes through Map are flushed here
+		void Unmap() { Flush(0, m_Size); }
+		void Flush(uint32_t offset, uint32_t size);
 
 	private:
 		BufferInfo m_BufferInfo;
@@ -87,19 +81,14 @@ namespace VkLibrary {
 		uint32_t GetSize() { return m_Size; }
 
 		void SetData(void* data);
+		void SetData(const void* data, uint32_t offset, uint32_t size);
 
 		template<typename T>
-		T* Map()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return (T*)allocator.MapMemory<T>(m_BufferInfo.Allocation);
-		}
-
-		void Unmap()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return allocator.UnmapMemory(m_BufferInfo.Allocation);
-		}
+		T* Map() { return (T*)m_BufferInfo.MappedData; }
+
+		// Buffer stays mapped, writes through Map are flushed here
+		void Unmap() { Flush(0, m_Size); }
+		void Flush(uint32_t offset, uint32_t size);
 
 	private:
 		BufferInfo m_BufferInfo;
@@ -119,19 +108,14 @@ namespace VkLibrary {
 		const VkDescriptorBufferInfo& GetDescriptorBufferInfo() { return m_DescriptorBufferInfo; }
 
 		void SetData(void* data);
+		void SetData(const void* data, uint32_t offset, uint32_t size);
 
 		template<typename T>
-		T* Map()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return (T*)allocator.MapMemory<T>(m_BufferInfo.Allocation);
-		}
-
-		void Unmap()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return allocator.UnmapMemory(m_BufferInfo.Allocation);
-		}
+		T* Map() { return (T*)m_BufferInfo.MappedData; }
+
+		// Buffer stays mapped, writes through Map are flushed here
+		void Unmap() { Flush(0, m_Size); }
+		void Flush(uint32_t offset, uint32_t size);
 
 	private:
 		BufferInfo m_BufferInfo;
@@ -151,25 +135,24 @@ namespace VkLibrary {
 		uint32_t GetSize() { return m_Size; }
 		const VkDescriptorBufferInfo& GetDescriptorBufferInfo() { return m_DescriptorBufferInfo; }
 
+		// Index into the bindless storage buffer array
+		uint32_t GetBindlessIndex() const { return m_BindlessIndex; }
+
 		void SetData(void* data);
+		void SetData(const void* data, uint32_t offset, uint32_t size);
 
 		template<typename T>
-		T* Map()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return (T*)allocator.MapMemory<T>(m_BufferInfo.Allocation);
-		}
-
-		void Unmap()
-		{
-			VulkanAllocator allocator(m_DebugName);
-			return allocator.UnmapMemory(m_BufferInfo.Allocation);
-		}
+		T* Map() { return (T*)m_BufferInfo.MappedData; }
+
+		// Buffer stays mapped, writes through Map are flushed here
+		void Unmap() { Flush(0, m_Size); }
+		void Flush(uint32_t offset, uint32_t size);
 
 	private:
 		BufferInfo m_BufferInfo;
 		uint32_t m_Size = 0;
 		VkDescriptorBufferInfo m_DescriptorBufferInfo;
+		uint32_t m_BindlessIndex = UINT32_MAX;
 		const std::string m_DebugName;
 	};
 
@@ -3,9 +3,13 @@
 #include "VulkanTools.h"
 #include "VulkanExtensions.h"
 #include "Core/Application.h"
+#include "Memory/FileIO.h"
+#include "Memory/MappedFile.h"
  
 namespace VkLibrary {
 
+	static const std::filesystem::path s_PipelineCachePath = "cache/pipelines.bin";
+
 	VulkanDevice::VulkanDevice()
 	{
 		Init();
@@ -13,7 +17,14 @@ namespace VkLibrary {
 
 	VulkanDevice::~VulkanDevice()
 	{
+		m_ImmediateContext.reset();
+		m_DeletionQueue.reset();
+
 		vkDestroyCommandPool(m_LogicalDevice, m_CommandPool, nullptr);
+		SavePipelineCache();
+		vkDestroyPipelineCache(m_LogicalDevice, m_PipelineCache, nullptr);
+		m_DescriptorAllocator.reset();
+		m_DescriptorSetLayoutCache.reset();
 
 		vkDestroyDevice(m_LogicalDevice, nullptr);
 	}
@@ -52,7 +63,7 @@ namespace VkLibrary {
 		m_QueueFamilyProperties.resize(queueFamilyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, m_QueueFamilyProperties.data());
 
-		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos = GetQueueCreateInfo(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos = GetQueueCreateInfo(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT);
 
 		// Set queue priority to 1.0f
 		float queuePriority = 1.0f;
@@ -80,12 +91,27 @@ namespace VkLibrary {
 		v12Features.descriptorIndexing = true;
 		v12Features.runtimeDescriptorArray = true;
 		v12Features.bufferDeviceAddress = true;
+		v12Features.timelineSemaphore = true;
+
+		// Bindless descriptor heap features
+		v12Features.descriptorBindingVariableDescriptorCount = true;
+		v12Features.descriptorBindingUpdateUnusedWhilePending = true;
+		v12Features.descriptorBindingSampledImageUpdateAfterBind = true;
+		v12Features.descriptorBindingStorageBufferUpdateAfterBind = true;
+		v12Features.shaderSampledImageArrayNonUniformIndexing = true;
+		v12Features.shaderStorageBufferArrayNonUniformIndexing = true;
 
 		// Ray tracing features
 		VkPhysicalDeviceRobustness2FeaturesEXT robustness2Features{};
 		robustness2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_EXT;
 		robustness2Features.nullDescriptor = VK_TRUE;
 
+		// Barriers are recorded through BarrierBatch with vkCmdPipelineBarrier2
+		VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+		synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		synchronization2Features.synchronization2 = VK_TRUE;
+		robustness2Features.pNext = &synchronization2Features;
+
 		VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures{};
 		accelerationStructureFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
 		accelerationStructureFeatures.pNext = &robustness2Features;
@@ -115,6 +141,60 @@ namespace VkLibrary {
 		deviceExtensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
 		deviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
 		deviceExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+		deviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+		// Optional extensions
+		if (std::find(m_SupportedDeviceExtensions.begin(), m_SupportedDeviceExtensions.end(), VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) != m_SupportedDeviceExtensions.end())
+		{
+			deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+			m_MemoryBudgetSupported = true;
+		}
+
+		// Present id and present wait let the swapchain find out when a frame actually reached the display
+		VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+		presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+
+		VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+		presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+		presentWaitFeatures.pNext = &presentIdFeatures;
+
+		bool presentWaitExtensions = std::find(m_SupportedDeviceExtensions.begin(), m_SupportedDeviceExtensions.end(), VK_KHR_PRESENT_ID_EXTENSION_NAME) != m_SupportedDeviceExtensions.end() &&
+			std::find(m_SupportedDeviceExtensions.begin(), m_SupportedDeviceExtensions.end(), VK_KHR_PRESENT_WAIT_EXTENSION_NAME) != m_SupportedDeviceExtensions.end();
+		if (presentWaitExtensions)
+		{
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &presentWaitFeatures;
+			vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &features);
+		}
+
+		if (presentWaitFeatures.presentWait && presentIdFeatures.presentId)
+		{
+			deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+			synchronization2Features.pNext = &presentWaitFeatures;
+			m_PresentWaitSupported = true;
+		}
+
+		// Dynamic rendering lets framebuffers and pipelines work without render pass objects
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+		dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+		if (std::find(m_SupportedDeviceExtensions.begin(), m_SupportedDeviceExtensions.end(), VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) != m_SupportedDeviceExtensions.end())
+		{
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &dynamicRenderingFeatures;
+			vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &features);
+		}
+
+		if (dynamicRenderingFeatures.dynamicRendering)
+		{
+			deviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			dynamicRenderingFeatures.pNext = synchronization2Features.pNext;
+			synchronization2Features.pNext = &dynamicRenderingFeatures;
+			m_DynamicRenderingSupported = true;
+		}
 
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -142,12 +222,86 @@ namespace VkLibrary {
 		LoadDeviceExtensions(m_LogicalDevice);
 
 		vkGetDeviceQueue(m_LogicalDevice, m_QueueFamilyIndices.Graphics, 0, &m_GraphicsQueue);
+		vkGetDeviceQueue(m_LogicalDevice, m_QueueFamilyIndices.Compute, 0, &m_ComputeQueue);
+		vkGetDeviceQueue(m_LogicalDevice, m_QueueFamilyIndices.Transfer, 0, &m_TransferQueue);
+
+		LOG_INFO("Queue families: graphics {}, compute {}, transfer {}", m_QueueFamilyIndices.Graphics, m_QueueFamilyIndices.Compute, m_QueueFamilyIndices.Transfer);
 
 		// Create command pool
 		VkCommandPoolCreateInfo poolInfo = {};
 		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 		poolInfo.queueFamilyIndex = m_QueueFamilyIndices.Graphics;
 		VK_CHECK_RESULT(vkCreateCommandPool(m_LogicalDevice, &poolInfo, nullptr, &m_CommandPool));
+
+		CreatePipelineCache();
+
+		m_DescriptorSetLayoutCache = CreateScope<DescriptorSetLayoutCache>(m_LogicalDevice);
+
+		DescriptorAllocatorSpecification descriptorAllocatorSpec;
+		descriptorAllocatorSpec.LayoutCache = m_DescriptorSetLayoutCache.get();
+		m_DescriptorAllocator = CreateScope<DescriptorAllocator>(m_LogicalDevice, descriptorAllocatorSpec);
+
+		m_DeletionQueue = CreateScope<DeletionQueue>();
+		m_ImmediateContext = CreateScope<ImmediateContext>(m_LogicalDevice, m_GraphicsQueue, m_QueueFamilyIndices.Graphics, m_QueueMutex);
+	}
+
+	void VulkanDevice::CreatePipelineCache()
+	{
+		// Pipeline cache shared by every pipeline, specialization constant values are part of what the driver caches on
+		VkPipelineCacheCreateInfo pipelineCacheInfo{};
+		pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		// Seeded with the data saved by the last run, data from another device or driver is left out
+		MappedFile file(s_PipelineCachePath);
+		if (file.IsValid() && file.GetSize() >= sizeof(VkPipelineCacheHeaderVersionOne))
+		{
+			const VkPipelineCacheHeaderVersionOne* header = (const VkPipelineCacheHeaderVersionOne*)file.GetData();
+
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+
+			if (header->headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header->vendorID == properties.vendorID &&
+				header->deviceID == properties.deviceID && memcmp(header->pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+			{
+				pipelineCacheInfo.initialDataSize = file.GetSize();
+				pipelineCacheInfo.pInitialData = file.GetData();
+			}
+			else
+			{
+				LOG_INFO("Pipeline cache {} was created by another device or driver, it is rebuilt", s_PipelineCachePath.string());
+			}
+		}
+
+		VK_CHECK_RESULT(vkCreatePipelineCache(m_LogicalDevice, &pipelineCacheInfo, nullptr, &m_PipelineCache));
+	}
+
+	void VulkanDevice::SavePipelineCache()
+	{
+		size_t size = 0;
+		if (vkGetPipelineCacheData(m_LogicalDevice, m_PipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+			return;
+
+		std::vector<uint8_t> data(size);
+		if (vkGetPipelineCacheData(m_LogicalDevice, m_PipelineCache, &size, data.data()) != VK_SUCCESS)
+			return;
+
+		if (s_PipelineCachePath.has_parent_path())
+			std::filesystem::create_directories(s_PipelineCachePath.parent_path());
+
+		// Written next to the destination and renamed, an interrupted write never leaves a partial cache behind
+		std::filesystem::path temporaryPath = s_PipelineCachePath.string() + ".tmp";
+		{
+			FileWriter writer(temporaryPath);
+			writer.WriteData((const char*)data.data(), size);
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporaryPath, s_PipelineCachePath, error);
+		if (error)
+		{
+			LOG_ERROR("Failed to write pipeline cache {}: {}", s_PipelineCachePath.string(), error.message());
+			std::filesystem::remove(temporaryPath, error);
+		}
 	}
 
 	uint32_t VulkanDevice::IsDeviceSuitable(VkPhysicalDevice device)
@@ -248,7 +402,7 @@ namespace VkLibrary {
 		else
 		{
 			// Else we use the same queue
-			m_QueueFamilyIndices.Compute = m_QueueFamilyIndices.Compute;
+			m_QueueFamilyIndices.Compute = m_QueueFamilyIndices.Graphics;
 		}
 
 		// Dedicated transfer queue
@@ -353,25 +507,9 @@ namespace VkLibrary {
 		// End command buffers
 		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
 
-		// Submit info
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		// Create fence
-		VkFenceCreateInfo fenceCreateInfo{};
-		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-
-		VkFence fence;
-		VK_CHECK_RESULT(vkCreateFence(m_LogicalDevice, &fenceCreateInfo, nullptr, &fence));
-
-		// Submit command buffer and signal fence when it's done
-		VK_CHECK_RESULT(vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, fence));
-		VK_CHECK_RESULT(vkWaitForFences(m_LogicalDevice, 1, &fence, VK_TRUE, UINT32_MAX));
-
-		// Destroy fence
-		vkDestroyFence(m_LogicalDevice, fence, nullptr);
+		// Submitted after any open immediate work, waits on the ticket instead of a fence created per call
+		uint64_t ticket = m_ImmediateContext->Submit(commandBuffer);
+		m_ImmediateContext->Wait(ticket);
 
 		// Free command buffer if specified
 		if (free)
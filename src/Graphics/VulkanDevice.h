@@ -1,6 +1,12 @@
 #pragma once
 #include "pch.h"
+#include "Core/Core.h"
+#include "DescriptorSetLayoutCache.h"
+#include "DescriptorAllocator.h"
+#include "DeletionQueue.h"
+#include "ImmediateContext.h"
 #include <vulkan/vulkan.h>
+#include <mutex>
 
 namespace VkLibrary {
 
@@ -39,6 +45,22 @@ namespace VkLibrary {
 
 		inline QueueFamilyIndices GetQueueFamilyIndices() const { return m_QueueFamilyIndices; };
 		inline VkQueue GetGraphicsQueue() const { return m_GraphicsQueue; }
+		inline VkQueue GetComputeQueue() const { return m_ComputeQueue; }
+		inline VkQueue GetTransferQueue() const { return m_TransferQueue; }
+		inline bool HasDedicatedTransferQueue() const { return m_QueueFamilyIndices.Transfer != m_QueueFamilyIndices.Graphics; }
+		inline bool HasDedicatedComputeQueue() const { return m_QueueFamilyIndices.Compute != m_QueueFamilyIndices.Graphics; }
+
+		// Held around every vkQueueSubmit, vkQueuePresentKHR and vkDeviceWaitIdle, the queues may all be the same VkQueue
+		inline std::mutex& GetQueueMutex() const { return m_QueueMutex; }
+		inline VkPipelineCache GetPipelineCache() const { return m_PipelineCache; }
+		inline DescriptorSetLayoutCache& GetDescriptorSetLayoutCache() const { return *m_DescriptorSetLayoutCache; }
+		inline DescriptorAllocator& GetDescriptorAllocator() const { return *m_DescriptorAllocator; }
+		inline DeletionQueue& GetDeletionQueue() const { return *m_DeletionQueue; }
+		inline ImmediateContext& GetImmediateContext() const { return *m_ImmediateContext; }
+
+		inline bool IsMemoryBudgetSupported() const { return m_MemoryBudgetSupported; }
+		inline bool IsPresentWaitSupported() const { return m_PresentWaitSupported; }
+		inline bool IsDynamicRenderingSupported() const { return m_DynamicRenderingSupported; }
 
 		const VkPhysicalDeviceProperties2& GetDeviceProperties() const { return m_DeviceProperties; }
 		const VkPhysicalDeviceRayTracingPipelinePropertiesKHR& GetRayTracingPipelineProperties() const { return m_RayTracingPipelineProperties; }
@@ -46,6 +68,10 @@ namespace VkLibrary {
 	private:
 		void Init();
 
+		// Pipeline cache data is loaded from the last run and saved again on destruction
+		void CreatePipelineCache();
+		void SavePipelineCache();
+
 		uint32_t IsDeviceSuitable(VkPhysicalDevice device);
 		uint32_t GetQueueFamilyIndex(VkQueueFlags queueFlags);
 		std::vector<VkDeviceQueueCreateInfo> GetQueueCreateInfo(VkQueueFlags requestedQueueTypes);
@@ -60,9 +86,20 @@ namespace VkLibrary {
 		QueueFamilyIndices m_QueueFamilyIndices;
 		SwapChainSupportDetails m_SwapChainSupportDetails;
 		std::vector<std::string> m_SupportedDeviceExtensions;
+		bool m_MemoryBudgetSupported = false;
+		bool m_PresentWaitSupported = false;
+		bool m_DynamicRenderingSupported = false;
 
 		VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
+		VkQueue m_ComputeQueue = VK_NULL_HANDLE;
+		VkQueue m_TransferQueue = VK_NULL_HANDLE;
+		mutable std::mutex m_QueueMutex;
 		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+		Scope<DescriptorSetLayoutCache> m_DescriptorSetLayoutCache;
+		Scope<DescriptorAllocator> m_DescriptorAllocator;
+		Scope<DeletionQueue> m_DeletionQueue;
+		Scope<ImmediateContext> m_ImmediateContext;
 
 		VkPhysicalDeviceProperties2 m_DeviceProperties{};
 		VkPhysicalDeviceFeatures m_DeviceFeatures{};
@@ -187,6 +187,54 @@ VKAPI_ATTR void VKAPI_CALL vkGetAccelerationStructureBuildSizesKHR(
     gvkGetAccelerationStructureBuildSizesKHR(device, buildType, pBuildInfo, pMaxPrimitiveCounts, pSizeInfo);
 }
 
+//----------------------------------------------------------------------------------------------------------
+// Present Wait Extension
+//----------------------------------------------------------------------------------------------------------
+
+PFN_vkWaitForPresentKHR                               gvkWaitForPresentKHR;
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitForPresentKHR(
+    VkDevice device,
+    VkSwapchainKHR swapchain,
+    uint64_t presentId,
+    uint64_t timeout)
+{
+    return gvkWaitForPresentKHR(device, swapchain, presentId, timeout);
+}
+
+//----------------------------------------------------------------------------------------------------------
+// Dynamic Rendering Extension
+//----------------------------------------------------------------------------------------------------------
+
+PFN_vkCmdBeginRenderingKHR                            gvkCmdBeginRenderingKHR;
+PFN_vkCmdEndRenderingKHR                              gvkCmdEndRenderingKHR;
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderingKHR(
+    VkCommandBuffer commandBuffer,
+    const VkRenderingInfoKHR* pRenderingInfo)
+{
+    gvkCmdBeginRenderingKHR(commandBuffer, pRenderingInfo);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderingKHR(
+    VkCommandBuffer commandBuffer)
+{
+    gvkCmdEndRenderingKHR(commandBuffer);
+}
+
+//----------------------------------------------------------------------------------------------------------
+// Synchronization2 Extension
+//----------------------------------------------------------------------------------------------------------
+
+PFN_vkCmdPipelineBarrier2KHR                          gvkCmdPipelineBarrier2KHR;
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier2KHR(
+    VkCommandBuffer commandBuffer,
+    const VkDependencyInfoKHR* pDependencyInfo)
+{
+    gvkCmdPipelineBarrier2KHR(commandBuffer, pDependencyInfo);
+}
+
 //----------------------------------------------------------------------------------------------------------
 // Ray Tracing Pipeline Extension
 //----------------------------------------------------------------------------------------------------------
@@ -396,6 +444,16 @@ namespace VkLibrary {
         LOAD_DEVICE_PROC(vkGetDeviceAccelerationStructureCompatibilityKHR)
         LOAD_DEVICE_PROC(vkGetAccelerationStructureBuildSizesKHR)
 
+        // Synchronization2 extension entry points
+        LOAD_DEVICE_PROC(vkCmdPipelineBarrier2KHR)
+
+        // Present Wait extension entry points, only valid if the device supports it
+        LOAD_DEVICE_PROC(vkWaitForPresentKHR)
+
+        // Dynamic Rendering extension entry points, only valid if the device supports it
+        LOAD_DEVICE_PROC(vkCmdBeginRenderingKHR)
+        LOAD_DEVICE_PROC(vkCmdEndRenderingKHR)
+
         // Ray Tracing Pipeline extension entry points
         LOAD_DEVICE_PROC(vkCmdTraceRaysKHR)
         LOAD_DEVICE_PROC(vkCreateRayTracingPipelinesKHR)
@@ -17,7 +17,10 @@ namespace VkLibrary {
         Ref<VulkanDevice> device = Application::GetVulkanDevice();
 
         // Vulkan shutdown
-        vkDeviceWaitIdle(device->GetLogicalDevice());
+        {
+            std::lock_guard<std::mutex> queueLock(device->GetQueueMutex());
+            vkDeviceWaitIdle(device->GetLogicalDevice());
+        }
         vkDestroyDescriptorPool(device->GetLogicalDevice(), m_DescriptorPool, nullptr);
 
         // ImGui shutdown
@@ -91,7 +94,8 @@ namespace VkLibrary {
         init_info.DescriptorPool = m_DescriptorPool;
         init_info.Allocator = nullptr;
         init_info.MinImageCount = swapChain->GetImageCount();
-        init_info.ImageCount = swapChain->GetImageCount();
+        // Vertex buffers rotate per draw, every frame in flight needs its own
+        init_info.ImageCount = std::max(swapChain->GetImageCount(), swapChain->GetFramesInFlight());
         init_info.CheckVkResultFn = nullptr;
         ImGui_ImplVulkan_Init(&init_info, swapChain->GetRenderPass());
 
@@ -189,8 +193,11 @@ namespace VkLibrary {
 
             vkEndCommandBuffer(command_buffer);
 
-            vkQueueSubmit(device->GetGraphicsQueue(), 1, &end_info, VK_NULL_HANDLE);
-            vkDeviceWaitIdle(device->GetLogicalDevice());
+            {
+                std::lock_guard<std::mutex> queueLock(device->GetQueueMutex());
+                vkQueueSubmit(device->GetGraphicsQueue(), 1, &end_info, VK_NULL_HANDLE);
+                vkDeviceWaitIdle(device->GetLogicalDevice());
+            }
 
             ImGui_ImplVulkan_DestroyFontUploadObjects();
         } 
@@ -9,8 +9,25 @@ namespace VkLibrary {
 
 	ViewportPanel::ViewportPanel()
 	{
-		m_DescriptorPool = VkTools::CreateDescriptorPool();
-		m_ImageDescriptorSet = VkTools::AllocateDescriptorSet(m_DescriptorPool, &ImGui_ImplVulkan_GetDescriptorSetLayout());
+	}
+
+	ViewportPanel::~ViewportPanel()
+	{
+		ReleaseDescriptorSet();
+	}
+
+	void ViewportPanel::ReleaseDescriptorSet()
+	{
+		if (!m_ImageDescriptorSet)
+			return;
+
+		Ref<VulkanDevice> device = Application::GetVulkanDevice();
+		device->GetDeletionQueue().Push([allocator = &device->GetDescriptorAllocator(), descriptorSet = m_ImageDescriptorSet]()
+		{
+			allocator->Free(descriptorSet);
+		});
+
+		m_ImageDescriptorSet = VK_NULL_HANDLE;
 	}
 
 	void ViewportPanel::Render(Ref<Image> image)
@@ -49,6 +66,10 @@ namespace VkLibrary {
 			const VkDescriptorImageInfo& descriptorInfo = image->GetDescriptorImageInfo();
 			if (m_ImageView != descriptorInfo.imageView)
 			{
+				// Frames in flight may still sample the old set, so switch to a new one instead of updating it in place
+				ReleaseDescriptorSet();
+				m_ImageDescriptorSet = device->GetDescriptorAllocator().Allocate(ImGui_ImplVulkan_GetDescriptorSetLayout());
+
 				VkWriteDescriptorSet writeDescriptor = VkTools::WriteDescriptorSet(m_ImageDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, &descriptorInfo);
 				vkUpdateDescriptorSets(device->GetLogicalDevice(), 1, &writeDescriptor, 0, nullptr);
 				m_ImageView = descriptorInfo.imageView;
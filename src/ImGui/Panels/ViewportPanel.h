@@ -12,6 +12,7 @@ namespace VkLibrary {
 	{
 	public:
 		ViewportPanel();
+		~ViewportPanel();
 
 	public:
 		void Render(Ref<Image> image);
@@ -26,6 +27,9 @@ namespace VkLibrary {
 		bool IsHovered() const { return m_Hovered; }
 		bool IsFocused() const { return m_Focused; }
 
+	private:
+		void ReleaseDescriptorSet();
+
 	private:
 		glm::vec2 m_Size = { 0.0f, 0.0f };
 		glm::vec2 m_Position = { 0.0f, 0.0f };
@@ -34,7 +38,6 @@ namespace VkLibrary {
 		bool m_Hovered = false;
 		bool m_Focused = false;
 
-		VkDescriptorPool m_DescriptorPool = VK_NULL_HANDLE;
 		VkDescriptorSet m_ImageDescriptorSet = VK_NULL_HANDLE;
 		VkImageView m_ImageView = VK_NULL_HANDLE;
 	};
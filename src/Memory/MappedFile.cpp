@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace VkLibrary {
+
+	MappedFile::MappedFile(const std::filesystem::path& path)
+		: m_Path(path)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		m_Data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		m_Size = (uint64_t)size.QuadPart;
+		m_FileHandle = file;
+		m_MappingHandle = mapping;
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+			return;
+
+		struct stat fileStat;
+		fstat(file, &fileStat);
+
+		void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+
+		if (data == MAP_FAILED)
+			return;
+
+		m_Data = (const uint8_t*)data;
+		m_Size = (uint64_t)fileStat.st_size;
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+
+		if (m_MappingHandle)
+			CloseHandle((HANDLE)m_MappingHandle);
+
+		if (m_FileHandle)
+			CloseHandle((HANDLE)m_FileHandle);
+#else
+		if (m_Data)
+			munmap((void*)m_Data, m_Size);
+#endif
+	}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <filesystem>
+#include <stdint.h>
+
+namespace VkLibrary {
+
+	// Read-only view of a whole file mapped into memory
+	class MappedFile
+	{
+	public:
+		MappedFile(const std::filesystem::path& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+	public:
+		inline const uint8_t* GetData() const { return m_Data; }
+		inline uint64_t GetSize() const { return m_Size; }
+		inline bool IsValid() const { return m_Data != nullptr; }
+
+	private:
+		std::filesystem::path m_Path;
+
+		const uint8_t* m_Data = nullptr;
+		uint64_t m_Size = 0;
+
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+	};
+
+}
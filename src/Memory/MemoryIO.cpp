@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "MemoryIO.h"
+#include "Core/Core.h"
+
+namespace VkLibrary
+{
+	MemoryWriter::MemoryWriter(std::vector<uint8_t>& output)
+		: m_Output(output)
+	{
+	}
+
+	void MemoryWriter::WriteData(const char* data, uint64_t size)
+	{
+		m_Output.insert(m_Output.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	}
+
+	MemoryReader::MemoryReader(const uint8_t* data, uint64_t size)
+		: m_Data(data), m_Size(size)
+	{
+	}
+
+	char* MemoryReader::ReadData(uint64_t size)
+	{
+		ASSERT(m_Position + size <= m_Size, "Read past the end of memory stream");
+
+		char* data = (char*)(m_Data + m_Position);
+		m_Position += size;
+		return data;
+	}
+
+	void MemoryReader::ReadData(char* output, uint64_t size)
+	{
+		ASSERT(m_Position + size <= m_Size, "Read past the end of memory stream");
+
+		memcpy(output, m_Data + m_Position, size);
+		m_Position += size;
+	}
+}
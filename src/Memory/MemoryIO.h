@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include "StreamIO.h"
+
+namespace VkLibrary {
+
+	class MemoryWriter : public StreamWriter
+	{
+	public:
+		MemoryWriter(std::vector<uint8_t>& output);
+		~MemoryWriter() = default;
+
+		void WriteData(const char* data, uint64_t size);
+
+	private:
+		std::vector<uint8_t>& m_Output;
+	};
+
+	class MemoryReader : public StreamReader
+	{
+	public:
+		MemoryReader(const uint8_t* data, uint64_t size);
+		~MemoryReader() = default;
+
+		char* ReadData(uint64_t size);
+		void ReadData(char* output, uint64_t size);
+
+		inline uint64_t GetPosition() const { return m_Position; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		uint64_t m_Size = 0;
+		uint64_t m_Position = 0;
+	};
+
+}
@@ -0,0 +1,330 @@
+#include "pch.h"
+#include "OffsetAllocator.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace VkLibrary {
+
+	namespace Utils {
+
+		static const uint32_t s_MantissaBits = 3;
+		static const uint32_t s_MantissaValue = 1 << s_MantissaBits;
+		static const uint32_t s_MantissaMask = s_MantissaValue - 1;
+
+		static uint32_t CountLeadingZeros(uint32_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			return _BitScanReverse(&index, value) ? 31 - index : 32;
+#else
+			return value ? __builtin_clz(value) : 32;
+#endif
+		}
+
+		static uint32_t CountTrailingZeros(uint32_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			return _BitScanForward(&index, value) ? index : 32;
+#else
+			return value ? __builtin_ctz(value) : 32;
+#endif
+		}
+
+		static uint32_t FindLowestSetBitAfter(uint32_t bitMask, uint32_t startBitIndex)
+		{
+			if (startBitIndex >= 32)
+				return OffsetAllocation::NoSpace;
+
+			uint32_t bitsAfter = bitMask & ~((1u << startBitIndex) - 1);
+			return bitsAfter ? CountTrailingZeros(bitsAfter) : OffsetAllocation::NoSpace;
+		}
+
+		// Bin of the smallest size class that fits size, used when searching
+		static uint32_t SizeToBinRoundUp(uint32_t size)
+		{
+			if (size < s_MantissaValue)
+				return size;
+
+			uint32_t highestSetBit = 31 - CountLeadingZeros(size);
+			uint32_t mantissaStartBit = highestSetBit - s_MantissaBits;
+			uint32_t exponent = mantissaStartBit + 1;
+			uint32_t mantissa = (size >> mantissaStartBit) & s_MantissaMask;
+
+			// Round up, mantissa overflow carries into the exponent
+			if (size & ((1u << mantissaStartBit) - 1))
+				mantissa++;
+
+			return (exponent << s_MantissaBits) + mantissa;
+		}
+
+		// Bin of the largest size class not larger than size, used when inserting
+		static uint32_t SizeToBinRoundDown(uint32_t size)
+		{
+			if (size < s_MantissaValue)
+				return size;
+
+			uint32_t highestSetBit = 31 - CountLeadingZeros(size);
+			uint32_t mantissaStartBit = highestSetBit - s_MantissaBits;
+			uint32_t exponent = mantissaStartBit + 1;
+			uint32_t mantissa = (size >> mantissaStartBit) & s_MantissaMask;
+
+			return (exponent << s_MantissaBits) | mantissa;
+		}
+
+		static uint32_t BinToSize(uint32_t bin)
+		{
+			uint32_t exponent = bin >> s_MantissaBits;
+			uint32_t mantissa = bin & s_MantissaMask;
+
+			if (exponent == 0)
+				return mantissa;
+
+			return (mantissa | s_MantissaValue) << (exponent - 1);
+		}
+
+	}
+
+	OffsetAllocator::OffsetAllocator(uint32_t size, uint32_t maxAllocations)
+		: m_Size(size), m_MaxAllocations(maxAllocations)
+	{
+		Reset();
+	}
+
+	void OffsetAllocator::Reset()
+	{
+		m_FreeStorage = 0;
+		m_UsedBinsTop = 0;
+
+		for (uint32_t i = 0; i < TopBinCount; i++)
+			m_UsedBins[i] = 0;
+
+		for (uint32_t i = 0; i < LeafBinCount; i++)
+			m_BinIndices[i] = Unused;
+
+		m_Nodes.assign(m_MaxAllocations, Node());
+
+		// Free node stack, lowest indices are handed out first
+		m_FreeNodes.resize(m_MaxAllocations);
+		for (uint32_t i = 0; i < m_MaxAllocations; i++)
+			m_FreeNodes[i] = m_MaxAllocations - i - 1;
+
+		// Start with one free node covering the whole range
+		InsertNodeIntoBin(m_Size, 0);
+	}
+
+	OffsetAllocation OffsetAllocator::Allocate(uint32_t size)
+	{
+		// A split may need a node for the remainder
+		if (m_FreeNodes.empty() || size == 0)
+			return OffsetAllocation();
+
+		uint32_t minBinIndex = Utils::SizeToBinRoundUp(size);
+		uint32_t minTopBinIndex = minBinIndex / BinsPerLeaf;
+		uint32_t minLeafBinIndex = minBinIndex % BinsPerLeaf;
+
+		uint32_t topBinIndex = minTopBinIndex;
+		uint32_t leafBinIndex = OffsetAllocation::NoSpace;
+
+		// Look for a free node in the same top bin first
+		if (m_UsedBinsTop & (1u << topBinIndex))
+			leafBinIndex = Utils::FindLowestSetBitAfter(m_UsedBins[topBinIndex], minLeafBinIndex);
+
+		// Otherwise take the smallest node of the next larger top bin
+		if (leafBinIndex == OffsetAllocation::NoSpace)
+		{
+			topBinIndex = Utils::FindLowestSetBitAfter(m_UsedBinsTop, minTopBinIndex + 1);
+			if (topBinIndex == OffsetAllocation::NoSpace)
+				return OffsetAllocation();
+
+			leafBinIndex = Utils::CountTrailingZeros(m_UsedBins[topBinIndex]);
+		}
+
+		uint32_t binIndex = topBinIndex * BinsPerLeaf + leafBinIndex;
+
+		// Pop the head of the bin list
+		uint32_t nodeIndex = m_BinIndices[binIndex];
+		Node& node = m_Nodes[nodeIndex];
+		uint32_t nodeTotalSize = node.DataSize;
+		node.DataSize = size;
+		node.Used = true;
+
+		m_BinIndices[binIndex] = node.BinListNext;
+		if (node.BinListNext != Unused)
+			m_Nodes[node.BinListNext].BinListPrev = Unused;
+
+		m_FreeStorage -= nodeTotalSize;
+
+		if (m_BinIndices[binIndex] == Unused)
+		{
+			m_UsedBins[topBinIndex] &= ~(1u << leafBinIndex);
+			if (m_UsedBins[topBinIndex] == 0)
+				m_UsedBinsTop &= ~(1u << topBinIndex);
+		}
+
+		// Put the remainder back as a new free node after this one
+		uint32_t remainderSize = nodeTotalSize - size;
+		if (remainderSize > 0)
+		{
+			uint32_t newNodeIndex = InsertNodeIntoBin(remainderSize, node.DataOffset + size);
+
+			if (node.NeighborNext != Unused)
+				m_Nodes[node.NeighborNext].NeighborPrev = newNodeIndex;
+
+			m_Nodes[newNodeIndex].NeighborPrev = nodeIndex;
+			m_Nodes[newNodeIndex].NeighborNext = node.NeighborNext;
+			node.NeighborNext = newNodeIndex;
+		}
+
+		OffsetAllocation allocation;
+		allocation.Offset = node.DataOffset;
+		allocation.Metadata = nodeIndex;
+		return allocation;
+	}
+
+	void OffsetAllocator::Free(const OffsetAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		uint32_t nodeIndex = allocation.Metadata;
+		Node& node = m_Nodes[nodeIndex];
+		ASSERT(node.Used, "Offset allocation was already freed");
+
+		uint32_t offset = node.DataOffset;
+		uint32_t size = node.DataSize;
+
+		// Merge with free neighbors
+		if (node.NeighborPrev != Unused && !m_Nodes[node.NeighborPrev].Used)
+		{
+			Node& prevNode = m_Nodes[node.NeighborPrev];
+			offset = prevNode.DataOffset;
+			size += prevNode.DataSize;
+
+			RemoveNodeFromBin(node.NeighborPrev);
+			node.NeighborPrev = prevNode.NeighborPrev;
+		}
+
+		if (node.NeighborNext != Unused && !m_Nodes[node.NeighborNext].Used)
+		{
+			Node& nextNode = m_Nodes[node.NeighborNext];
+			size += nextNode.DataSize;
+
+			RemoveNodeFromBin(node.NeighborNext);
+			node.NeighborNext = nextNode.NeighborNext;
+		}
+
+		uint32_t neighborPrev = node.NeighborPrev;
+		uint32_t neighborNext = node.NeighborNext;
+
+		node = Node();
+		m_FreeNodes.push_back(nodeIndex);
+
+		uint32_t combinedNodeIndex = InsertNodeIntoBin(size, offset);
+
+		if (neighborNext != Unused)
+		{
+			m_Nodes[combinedNodeIndex].NeighborNext = neighborNext;
+			m_Nodes[neighborNext].NeighborPrev = combinedNodeIndex;
+		}
+
+		if (neighborPrev != Unused)
+		{
+			m_Nodes[combinedNodeIndex].NeighborPrev = neighborPrev;
+			m_Nodes[neighborPrev].NeighborNext = combinedNodeIndex;
+		}
+	}
+
+	uint32_t OffsetAllocator::GetAllocationSize(const OffsetAllocation& allocation) const
+	{
+		if (!allocation.IsValid())
+			return 0;
+
+		return m_Nodes[allocation.Metadata].DataSize;
+	}
+
+	uint32_t OffsetAllocator::GetLargestFreeRegion() const
+	{
+		if (m_UsedBinsTop == 0)
+			return 0;
+
+		uint32_t topBinIndex = 31 - Utils::CountLeadingZeros(m_UsedBinsTop);
+		uint32_t leafBinIndex = 31 - Utils::CountLeadingZeros(m_UsedBins[topBinIndex]);
+
+		// Bins only give a lower bound, check the actual nodes of the largest bin
+		uint32_t largest = Utils::BinToSize(topBinIndex * BinsPerLeaf + leafBinIndex);
+		for (uint32_t nodeIndex = m_BinIndices[topBinIndex * BinsPerLeaf + leafBinIndex]; nodeIndex != Unused; nodeIndex = m_Nodes[nodeIndex].BinListNext)
+			largest = std::max(largest, m_Nodes[nodeIndex].DataSize);
+
+		return largest;
+	}
+
+	uint32_t OffsetAllocator::InsertNodeIntoBin(uint32_t size, uint32_t dataOffset)
+	{
+		uint32_t binIndex = Utils::SizeToBinRoundDown(size);
+		uint32_t topBinIndex = binIndex / BinsPerLeaf;
+		uint32_t leafBinIndex = binIndex % BinsPerLeaf;
+
+		if (m_BinIndices[binIndex] == Unused)
+		{
+			m_UsedBins[topBinIndex] |= 1u << leafBinIndex;
+			m_UsedBinsTop |= 1u << topBinIndex;
+		}
+
+		ASSERT(!m_FreeNodes.empty(), "Offset allocator ran out of nodes");
+		uint32_t topNodeIndex = m_BinIndices[binIndex];
+		uint32_t nodeIndex = m_FreeNodes.back();
+		m_FreeNodes.pop_back();
+
+		// Push to the head of the bin list
+		Node& node = m_Nodes[nodeIndex];
+		node = Node();
+		node.DataOffset = dataOffset;
+		node.DataSize = size;
+		node.BinListNext = topNodeIndex;
+
+		if (topNodeIndex != Unused)
+			m_Nodes[topNodeIndex].BinListPrev = nodeIndex;
+
+		m_BinIndices[binIndex] = nodeIndex;
+		m_FreeStorage += size;
+
+		return nodeIndex;
+	}
+
+	void OffsetAllocator::RemoveNodeFromBin(uint32_t nodeIndex)
+	{
+		Node& node = m_Nodes[nodeIndex];
+
+		if (node.BinListPrev != Unused)
+		{
+			m_Nodes[node.BinListPrev].BinListNext = node.BinListNext;
+			if (node.BinListNext != Unused)
+				m_Nodes[node.BinListNext].BinListPrev = node.BinListPrev;
+		}
+		else
+		{
+			// Node is the head of its bin
+			uint32_t binIndex = Utils::SizeToBinRoundDown(node.DataSize);
+			uint32_t topBinIndex = binIndex / BinsPerLeaf;
+			uint32_t leafBinIndex = binIndex % BinsPerLeaf;
+
+			m_BinIndices[binIndex] = node.BinListNext;
+			if (node.BinListNext != Unused)
+				m_Nodes[node.BinListNext].BinListPrev = Unused;
+
+			if (m_BinIndices[binIndex] == Unused)
+			{
+				m_UsedBins[topBinIndex] &= ~(1u << leafBinIndex);
+				if (m_UsedBins[topBinIndex] == 0)
+					m_UsedBinsTop &= ~(1u << topBinIndex);
+			}
+		}
+
+		m_FreeNodes.push_back(nodeIndex);
+		m_FreeStorage -= node.DataSize;
+	}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+namespace VkLibrary {
+
+	struct OffsetAllocation
+	{
+		static constexpr uint32_t NoSpace = UINT32_MAX;
+
+		uint32_t Offset = NoSpace;
+		uint32_t Metadata = NoSpace; // Node index, used to free the allocation
+
+		inline bool IsValid() const { return Offset != NoSpace; }
+	};
+
+	// Two level segregated fit allocator over an abstract range [0, size), allocates and frees in O(1)
+	// Sizes are binned by a small float (3 bit mantissa) so allocations round up by at most 12.5% when searching
+	// NOTE: Only offsets are managed, the caller owns the memory the offsets point into
+	class OffsetAllocator
+	{
+	public:
+		OffsetAllocator(uint32_t size, uint32_t maxAllocations = 128 * 1024);
+
+		OffsetAllocator(const OffsetAllocator&) = delete;
+		OffsetAllocator& operator=(const OffsetAllocator&) = delete;
+
+	public:
+		OffsetAllocation Allocate(uint32_t size);
+		void Free(const OffsetAllocation& allocation);
+
+		void Reset();
+
+		uint32_t GetAllocationSize(const OffsetAllocation& allocation) const;
+
+		inline uint32_t GetSize() const { return m_Size; }
+		inline uint32_t GetFreeSpace() const { return m_FreeStorage; }
+		uint32_t GetLargestFreeRegion() const;
+
+	public:
+		static constexpr uint32_t TopBinCount = 32;
+		static constexpr uint32_t BinsPerLeaf = 8;
+		static constexpr uint32_t LeafBinCount = TopBinCount * BinsPerLeaf;
+
+	private:
+		uint32_t InsertNodeIntoBin(uint32_t size, uint32_t dataOffset);
+		void RemoveNodeFromBin(uint32_t nodeIndex);
+
+	private:
+		static constexpr uint32_t Unused = UINT32_MAX;
+
+		struct Node
+		{
+			uint32_t DataOffset = 0;
+			uint32_t DataSize = 0;
+			uint32_t BinListPrev = Unused;
+			uint32_t BinListNext = Unused;
+			uint32_t NeighborPrev = Unused;
+			uint32_t NeighborNext = Unused;
+			bool Used = false;
+		};
+
+		uint32_t m_Size = 0;
+		uint32_t m_MaxAllocations = 0;
+		uint32_t m_FreeStorage = 0;
+
+		uint32_t m_UsedBinsTop = 0;
+		uint8_t m_UsedBins[TopBinCount] = {};
+		uint32_t m_BinIndices[LeafBinCount] = {};
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_FreeNodes;
+	};
+
+}
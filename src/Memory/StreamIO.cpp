@@ -31,7 +31,7 @@ namespace VkLibrary {
 
 	std::string StreamReader::ReadString()
 	{
-		uint32_t size = ReadRaw<uint32_t>();
+		uint64_t size = ReadRaw<uint64_t>();
 		char* buffer = new char[size];
 		ReadData(buffer, size);
 
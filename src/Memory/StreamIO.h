@@ -54,10 +54,11 @@ namespace VkLibrary {
 		std::string ReadString();
 
 		template<typename T>
-		T& ReadRaw()
+		T ReadRaw()
 		{
-			char* value = ReadData(sizeof(T));
-			return (T&)value;
+			T value;
+			ReadData((char*)&value, sizeof(T));
+			return value;
 		}
 
 		template<typename T>
@@ -0,0 +1,70 @@
+#include "pch.h"
+#include "Core/Log.h"
+#include "Graphics/ShaderCompiler.h"
+#include "Graphics/ShaderLibrary.h"
+#include "Graphics/ShaderPack.h"
+
+using namespace VkLibrary;
+
+// Usage: ShaderPackCompiler <shader directory> <output.vlshaders>
+// Run from the application working directory so pack keys match the paths used at runtime
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: ShaderPackCompiler <shader directory> <output.vlshaders>" << std::endl;
+		return 1;
+	}
+
+	Log::Init();
+
+	const std::filesystem::path shaderDirectory = argv[1];
+	const std::filesystem::path outputPath = argv[2];
+
+	std::vector<ShaderPackShader> shaders;
+	uint32_t failedCount = 0;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(shaderDirectory))
+	{
+		const std::filesystem::path& path = entry.path();
+		if (!entry.is_regular_file() || (path.extension() != ".glsl" && path.extension() != ".hlsl"))
+			continue;
+
+		std::vector<ShaderVariant> variants = { ShaderVariant() };
+		std::unordered_map<ShaderStage, std::string> shaderSrc = ShaderCompiler::SplitShaders(path, &variants);
+
+		// Files without a #Shader stage are include files
+		if (shaderSrc.empty() || shaderSrc.find(ShaderStage::NONE) != shaderSrc.end())
+			continue;
+
+		for (const ShaderVariant& variant : variants)
+		{
+			ShaderCompileOptions options;
+			options.EntryPoint = variant.EntryPoint;
+			options.Defines = variant.Defines;
+			options.Optimize = true;
+
+			ShaderPackShader& shader = shaders.emplace_back();
+			shader.Key = ShaderLibrary::GetShaderKey(path.string(), variant.EntryPoint, variant.Defines);
+
+			if (!ShaderCompiler::Compile(path, shaderSrc, options, shader.SPIRV))
+			{
+				LOG_ERROR("Failed to compile {}", shader.Key);
+				shaders.pop_back();
+				failedCount++;
+				continue;
+			}
+
+			for (const auto& [stage, spirv] : shader.SPIRV)
+				ShaderCompiler::Reflect(spirv, stage, shader.ReflectionData);
+
+			LOG_INFO("Compiled {}", shader.Key);
+		}
+	}
+
+	ShaderPack::Write(outputPath, shaders);
+	LOG_INFO("Wrote {} shaders to {}", shaders.size(), outputPath.string());
+
+	return failedCount ? 1 : 0;
+}